@@ -1,5 +1,13 @@
 #include <stdint.h>
 
 #define UBN_LITTLE_ENDIAN
+#ifdef __SIZEOF_INT128__
+#define UBN_BITS_PER_WORD        64UL
+#if defined(__x86_64__)
+#define UBN_X86_AVX2
+#define UBN_X86_IFMA
+#define UBN_X86_ADX
+#endif
+#else
 #define UBN_BITS_PER_WORD        32UL
-
+#endif
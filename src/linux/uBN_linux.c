@@ -3,8 +3,14 @@
 
 void  muBN_rand(muBN_t *r) {
   muBN_size_t l;
+  muBN_size_t i;
+  muBN_uword_t w;
   l = r->wlen;
   while(l--) {
-    r->v[l--] = rand();
+    w = 0;
+    for (i = 0; i<(muBN_size_t)sizeof(muBN_uword_t); i++) {
+      w = (w<<8) ^ (muBN_uword_t)rand();
+    }
+    r->v[l] = w;
   }
 }
@@ -0,0 +1,445 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mu25519.h"
+
+/*
+ * Limb i holds W(i) bits at offset ceil(i.255/L). A product of limbs i
+ * and j lands at offset(i+j), plus one bit when both are odd in radix
+ * 2^25.5 (TWICE). Offsets above 255 fold back with 2^255 = 19.
+ */
+#if UBN_BITS_PER_WORD == 64
+typedef unsigned __int128 mu25519_dlimb_t;
+#define U25519_W(i)        51
+#define U25519_TWICE(i,j)  0
+#else
+typedef uint64_t          mu25519_dlimb_t;
+#define U25519_W(i)        (26-((i)&1))
+#define U25519_TWICE(i,j)  ((i)&(j)&1)
+#endif
+#define U25519_L           U25519_LIMBS
+#define U25519_MASK(i)     ((((mu25519_limb_t)1)<<U25519_W(i))-1)
+
+/* ======================================================================================= */
+/*                                      Field                                              */
+/* ======================================================================================= */
+
+void mu25519_fe_0(mu25519_fe_t *r) {
+  int i;
+  for (i = 0; i < U25519_L; i++) {
+    r->v[i] = 0;
+  }
+}
+
+void mu25519_fe_1(mu25519_fe_t *r) {
+  mu25519_fe_0(r);
+  r->v[0] = 1;
+}
+
+void mu25519_fe_copy(mu25519_fe_t *r, const mu25519_fe_t *a) {
+  int i;
+  for (i = 0; i < U25519_L; i++) {
+    r->v[i] = a->v[i];
+  }
+}
+
+void mu25519_fe_frombytes(mu25519_fe_t *r, const uint8_t *s) {
+  uint64_t acc;
+  int      i, n, k;
+
+  acc = 0;
+  n   = 0;
+  k   = 0;
+  for (i = 0; i < U25519_L; i++) {
+    while ((n < U25519_W(i)) && (k < 32)) {
+      acc |= ((uint64_t)s[k++])<<n;
+      n   += 8;
+    }
+    r->v[i] = (mu25519_limb_t)acc & U25519_MASK(i);
+    acc   >>= U25519_W(i);
+    n      -= U25519_W(i);
+  }
+}
+
+/*
+ * One carry pass, the top carry folds into limb 0 which may keep a few
+ * bits over its width.
+ */
+static void mu25519_carry(mu25519_fe_t *r) {
+  mu25519_limb_t c;
+  int            i;
+
+  c = 0;
+  for (i = 0; i < U25519_L; i++) {
+    r->v[i] += c;
+    c        = r->v[i] >> U25519_W(i);
+    r->v[i] &= U25519_MASK(i);
+  }
+  r->v[0] += 19*c;
+}
+
+/*
+ * r = c mod p, from unsaturated double limbs. Spelled out, as the
+ * products below.
+ */
+#define U25519_CARRY_I(i)                                                   \
+  c[(i)+1] += c[i] >> U25519_W(i);                                          \
+  r->v[i]   = (mu25519_limb_t)c[i] & U25519_MASK(i)
+
+static void mu25519_reduce(mu25519_fe_t *r, mu25519_dlimb_t *c) {
+  mu25519_limb_t t;
+
+  U25519_CARRY_I(0); U25519_CARRY_I(1); U25519_CARRY_I(2); U25519_CARRY_I(3);
+#if U25519_L == 10
+  U25519_CARRY_I(4); U25519_CARRY_I(5); U25519_CARRY_I(6); U25519_CARRY_I(7);
+  U25519_CARRY_I(8);
+#endif
+  c[0]  = (mu25519_dlimb_t)r->v[0] + 19*(c[U25519_L-1] >> U25519_W(U25519_L-1));
+  r->v[U25519_L-1] = (mu25519_limb_t)c[U25519_L-1] & U25519_MASK(U25519_L-1);
+  t        = (mu25519_limb_t)(c[0] >> U25519_W(0));
+  r->v[0]  = (mu25519_limb_t)c[0] & U25519_MASK(0);
+  r->v[1] += t;
+}
+
+void mu25519_fe_tobytes(uint8_t *s, const mu25519_fe_t *a) {
+  mu25519_fe_t   t;
+  mu25519_limb_t q;
+  uint64_t       acc;
+  int            i, n, k;
+
+  mu25519_fe_copy(&t, a);
+  mu25519_carry(&t);
+  mu25519_carry(&t);
+
+  /* t < 2p: q = 1 iff t >= p, that is t+19 >= 2^255 */
+  q = (t.v[0] + 19) >> U25519_W(0);
+  for (i = 1; i < U25519_L; i++) {
+    q = (t.v[i] + q) >> U25519_W(i);
+  }
+  t.v[0] += 19*q;
+  q = 0;
+  for (i = 0; i < U25519_L; i++) {
+    t.v[i] += q;
+    q       = t.v[i] >> U25519_W(i);
+    t.v[i] &= U25519_MASK(i);
+  }
+
+  acc = 0;
+  n   = 0;
+  k   = 0;
+  for (i = 0; i < U25519_L; i++) {
+    acc |= ((uint64_t)t.v[i])<<n;
+    n   += U25519_W(i);
+    while ((n >= 8) || ((i == U25519_L-1) && (n > 0))) {
+      s[k++] = (uint8_t)acc;
+      acc  >>= 8;
+      n     -= 8;
+    }
+  }
+  mu25519_fe_0(&t);
+}
+
+void mu25519_fe_add(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b) {
+  int i;
+  for (i = 0; i < U25519_L; i++) {
+    r->v[i] = a->v[i] + b->v[i];
+  }
+}
+
+void mu25519_fe_sub(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b) {
+  int i;
+
+  /* a + 4p - b, limb per limb positive */
+  r->v[0] = a->v[0] + 4*(U25519_MASK(0)-18) - b->v[0];
+  for (i = 1; i < U25519_L; i++) {
+    r->v[i] = a->v[i] + 4*U25519_MASK(i) - b->v[i];
+  }
+  mu25519_carry(r);
+}
+
+void mu25519_fe_neg(mu25519_fe_t *r, const mu25519_fe_t *a) {
+  mu25519_fe_t z;
+
+  mu25519_fe_0(&z);
+  mu25519_fe_sub(r, &z, a);
+}
+
+/*
+ * Products are spelled out limb by limb, the constant i,j tests fold at
+ * compile time, loops would only get unrolled at -O3.
+ */
+#define U25519_ROW(F,i)     F(i,0); F(i,1); F(i,2); F(i,3); F(i,4); U25519_ROW_HI(F,i)
+#if U25519_L == 5
+#define U25519_ROW_HI(F,i)
+#define U25519_ROWS(F)      U25519_ROW(F,0); U25519_ROW(F,1); U25519_ROW(F,2); \
+                            U25519_ROW(F,3); U25519_ROW(F,4)
+#else
+#define U25519_ROW_HI(F,i)  F(i,5); F(i,6); F(i,7); F(i,8); F(i,9)
+#define U25519_ROWS(F)      U25519_ROW(F,0); U25519_ROW(F,1); U25519_ROW(F,2); \
+                            U25519_ROW(F,3); U25519_ROW(F,4); U25519_ROW(F,5); \
+                            U25519_ROW(F,6); U25519_ROW(F,7); U25519_ROW(F,8); \
+                            U25519_ROW(F,9)
+#endif
+
+/* c[i+j] += a[i].b[j] */
+#define U25519_MUL_IJ(i,j)                                                  \
+  c[((i)+(j))%U25519_L] += ((mu25519_dlimb_t)a->v[i] *                      \
+                            ((i)+(j) < U25519_L ? b->v[j] : b19[j])) << U25519_TWICE(i,j)
+
+/* c[i+j] += a[i].a[j], counted twice for i < j */
+#define U25519_SQR_IJ(i,j)                                                  \
+  if ((j) == (i)) {                                                         \
+    c[(2*(i))%U25519_L] += ((mu25519_dlimb_t)a->v[i] *                      \
+                            (2*(i) < U25519_L ? a->v[i] : a19[i])) << U25519_TWICE(i,i); \
+  } else if ((j) > (i)) {                                                   \
+    c[((i)+(j))%U25519_L] += ((mu25519_dlimb_t)a2[i] *                      \
+                              ((i)+(j) < U25519_L ? a->v[j] : a19[j])) << U25519_TWICE(i,j); \
+  }
+
+void mu25519_fe_mul(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b) {
+  mu25519_dlimb_t c[U25519_L];
+  mu25519_limb_t  b19[U25519_L];
+  int             i;
+
+  for (i = 0; i < U25519_L; i++) {
+    b19[i] = 19*b->v[i];
+    c[i]   = 0;
+  }
+  U25519_ROWS(U25519_MUL_IJ);
+  mu25519_reduce(r, c);
+}
+
+void mu25519_fe_sqr(mu25519_fe_t *r, const mu25519_fe_t *a) {
+  mu25519_dlimb_t c[U25519_L];
+  mu25519_limb_t  a19[U25519_L], a2[U25519_L];
+  int             i;
+
+  for (i = 0; i < U25519_L; i++) {
+    a19[i] = 19*a->v[i];
+    a2[i]  = 2*a->v[i];
+    c[i]   = 0;
+  }
+  U25519_ROWS(U25519_SQR_IJ);
+  mu25519_reduce(r, c);
+}
+
+void mu25519_fe_mul_small(mu25519_fe_t *r, const mu25519_fe_t *a, uint32_t s) {
+  mu25519_dlimb_t c[U25519_L];
+  int             i;
+
+  for (i = 0; i < U25519_L; i++) {
+    c[i] = (mu25519_dlimb_t)a->v[i] * s;
+  }
+  mu25519_reduce(r, c);
+}
+
+/* r = a^(2^n) */
+static void mu25519_fe_sqr_n(mu25519_fe_t *r, const mu25519_fe_t *a, int n) {
+  mu25519_fe_sqr(r, a);
+  while (--n) {
+    mu25519_fe_sqr(r, r);
+  }
+}
+
+void mu25519_fe_inv(mu25519_fe_t *r, const mu25519_fe_t *a) {
+  mu25519_fe_t z2, z9, z11, z5, z10, z50, z100, t;
+
+  /* p-2 = 2^255-21 = (2^250-1).2^5 + 11 */
+  mu25519_fe_sqr(&z2, a);
+  mu25519_fe_sqr_n(&t, &z2, 2);
+  mu25519_fe_mul(&z9, &t, a);
+  mu25519_fe_mul(&z11, &z9, &z2);
+  mu25519_fe_sqr(&t, &z11);
+  mu25519_fe_mul(&z5, &t, &z9);          /* 2^5-1   */
+  mu25519_fe_sqr_n(&t, &z5, 5);
+  mu25519_fe_mul(&z10, &t, &z5);         /* 2^10-1  */
+  mu25519_fe_sqr_n(&t, &z10, 10);
+  mu25519_fe_mul(&z2, &t, &z10);         /* 2^20-1  */
+  mu25519_fe_sqr_n(&t, &z2, 20);
+  mu25519_fe_mul(&t, &t, &z2);           /* 2^40-1  */
+  mu25519_fe_sqr_n(&t, &t, 10);
+  mu25519_fe_mul(&z50, &t, &z10);        /* 2^50-1  */
+  mu25519_fe_sqr_n(&t, &z50, 50);
+  mu25519_fe_mul(&z100, &t, &z50);       /* 2^100-1 */
+  mu25519_fe_sqr_n(&t, &z100, 100);
+  mu25519_fe_mul(&t, &t, &z100);         /* 2^200-1 */
+  mu25519_fe_sqr_n(&t, &t, 50);
+  mu25519_fe_mul(&t, &t, &z50);          /* 2^250-1 */
+  mu25519_fe_sqr_n(&t, &t, 5);
+  mu25519_fe_mul(r, &t, &z11);
+
+  mu25519_fe_0(&z2);  mu25519_fe_0(&z9);  mu25519_fe_0(&z11); mu25519_fe_0(&z5);
+  mu25519_fe_0(&z10); mu25519_fe_0(&z50); mu25519_fe_0(&z100); mu25519_fe_0(&t);
+}
+
+void mu25519_fe_pow22523(mu25519_fe_t *r, const mu25519_fe_t *a) {
+  mu25519_fe_t z2, z9, z5, z10, z50, z100, t;
+
+  /* 2^252-3 = (2^250-1).2^2 + 1 */
+  mu25519_fe_sqr(&z2, a);
+  mu25519_fe_sqr_n(&t, &z2, 2);
+  mu25519_fe_mul(&z9, &t, a);
+  mu25519_fe_mul(&t, &z9, &z2);
+  mu25519_fe_sqr(&t, &t);
+  mu25519_fe_mul(&z5, &t, &z9);          /* 2^5-1   */
+  mu25519_fe_sqr_n(&t, &z5, 5);
+  mu25519_fe_mul(&z10, &t, &z5);         /* 2^10-1  */
+  mu25519_fe_sqr_n(&t, &z10, 10);
+  mu25519_fe_mul(&z2, &t, &z10);         /* 2^20-1  */
+  mu25519_fe_sqr_n(&t, &z2, 20);
+  mu25519_fe_mul(&t, &t, &z2);           /* 2^40-1  */
+  mu25519_fe_sqr_n(&t, &t, 10);
+  mu25519_fe_mul(&z50, &t, &z10);        /* 2^50-1  */
+  mu25519_fe_sqr_n(&t, &z50, 50);
+  mu25519_fe_mul(&z100, &t, &z50);       /* 2^100-1 */
+  mu25519_fe_sqr_n(&t, &z100, 100);
+  mu25519_fe_mul(&t, &t, &z100);         /* 2^200-1 */
+  mu25519_fe_sqr_n(&t, &t, 50);
+  mu25519_fe_mul(&t, &t, &z50);          /* 2^250-1 */
+  mu25519_fe_sqr_n(&t, &t, 2);
+  mu25519_fe_mul(r, &t, a);
+
+  mu25519_fe_0(&z2);  mu25519_fe_0(&z9);   mu25519_fe_0(&z5); mu25519_fe_0(&z10);
+  mu25519_fe_0(&z50); mu25519_fe_0(&z100); mu25519_fe_0(&t);
+}
+
+muBN_word_t mu25519_fe_iszero(const mu25519_fe_t *a) {
+  uint8_t  s[32];
+  uint32_t nz;
+  int      i;
+
+  mu25519_fe_tobytes(s, a);
+  nz = 0;
+  for (i = 0; i < 32; i++) {
+    nz |= s[i];
+  }
+  return (muBN_word_t)(1 ^ ((0 - nz) >> 31));
+}
+
+muBN_word_t mu25519_fe_isneg(const mu25519_fe_t *a) {
+  uint8_t s[32];
+
+  mu25519_fe_tobytes(s, a);
+  return s[0] & 1;
+}
+
+void mu25519_fe_cmov(mu25519_fe_t *r, const mu25519_fe_t *a, mu25519_limb_t move) {
+  mu25519_limb_t mask;
+  int            i;
+
+  mask = 0 - move;
+  for (i = 0; i < U25519_L; i++) {
+    r->v[i] ^= mask & (r->v[i] ^ a->v[i]);
+  }
+}
+
+void mu25519_fe_cswap(mu25519_fe_t *a, mu25519_fe_t *b, mu25519_limb_t swap) {
+  mu25519_limb_t mask, x;
+  int            i;
+
+  mask = 0 - swap;
+  for (i = 0; i < U25519_L; i++) {
+    x        = mask & (a->v[i] ^ b->v[i]);
+    a->v[i] ^= x;
+    b->v[i] ^= x;
+  }
+}
+
+/* ======================================================================================= */
+/*                                      X25519                                             */
+/* ======================================================================================= */
+
+/* (A-2)/4, A = 486662 */
+#define U25519_A24  121665
+
+muBN_word_t mu_x25519(uint8_t *out, const uint8_t *scalar, const uint8_t *u) {
+  mu25519_fe_t   x1, x2, z2, x3, z3;
+  mu25519_fe_t   a, aa, b, bb, e, c, d;
+  mu25519_limb_t swap, kt;
+  uint8_t        k[32];
+  uint32_t       nz;
+  int            i;
+
+  for (i = 0; i < 32; i++) {
+    k[i] = scalar[i];
+  }
+  k[0]  &= 248;
+  k[31] &= 127;
+  k[31] |= 64;
+
+  mu25519_fe_frombytes(&x1, u);
+  mu25519_fe_1(&x2);
+  mu25519_fe_0(&z2);
+  mu25519_fe_copy(&x3, &x1);
+  mu25519_fe_1(&z3);
+
+  /* RFC 7748, 5 */
+  swap = 0;
+  for (i = 254; i >= 0; i--) {
+    kt    = (k[i>>3] >> (i&7)) & 1;
+    swap ^= kt;
+    mu25519_fe_cswap(&x2, &x3, swap);
+    mu25519_fe_cswap(&z2, &z3, swap);
+    swap  = kt;
+
+    mu25519_fe_add(&a, &x2, &z2);
+    mu25519_fe_sqr(&aa, &a);
+    mu25519_fe_sub(&b, &x2, &z2);
+    mu25519_fe_sqr(&bb, &b);
+    mu25519_fe_sub(&e, &aa, &bb);
+    mu25519_fe_add(&c, &x3, &z3);
+    mu25519_fe_sub(&d, &x3, &z3);
+    mu25519_fe_mul(&d, &d, &a);             /* DA */
+    mu25519_fe_mul(&c, &c, &b);             /* CB */
+    mu25519_fe_add(&x3, &d, &c);
+    mu25519_fe_sqr(&x3, &x3);
+    mu25519_fe_sub(&z3, &d, &c);
+    mu25519_fe_sqr(&z3, &z3);
+    mu25519_fe_mul(&z3, &z3, &x1);
+    mu25519_fe_mul(&x2, &aa, &bb);
+    mu25519_fe_mul_small(&z2, &e, U25519_A24);
+    mu25519_fe_add(&z2, &z2, &aa);
+    mu25519_fe_mul(&z2, &z2, &e);
+  }
+  mu25519_fe_cswap(&x2, &x3, swap);
+  mu25519_fe_cswap(&z2, &z3, swap);
+
+  mu25519_fe_inv(&z2, &z2);
+  mu25519_fe_mul(&x2, &x2, &z2);
+  mu25519_fe_tobytes(out, &x2);
+
+  nz = 0;
+  for (i = 0; i < 32; i++) {
+    nz   |= out[i];
+    k[i]  = 0;
+  }
+  mu25519_fe_0(&x2); mu25519_fe_0(&z2); mu25519_fe_0(&x3); mu25519_fe_0(&z3);
+  mu25519_fe_0(&a);  mu25519_fe_0(&aa); mu25519_fe_0(&b);  mu25519_fe_0(&bb);
+  mu25519_fe_0(&e);  mu25519_fe_0(&c);  mu25519_fe_0(&d);
+
+  return (muBN_word_t)((0 - nz) >> 31);
+}
+
+muBN_word_t mu_x25519_base(uint8_t *out, const uint8_t *scalar) {
+  uint8_t u[32];
+  int     i;
+
+  u[0] = 9;
+  for (i = 1; i < 32; i++) {
+    u[i] = 0;
+  }
+  return mu_x25519(out, scalar, u);
+}
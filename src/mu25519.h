@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef mu25519_H
+#define mu25519_H
+
+/*
+ * Curve25519 field GF(2^255-19) and X25519 key agreement (RFC 7748).
+ *
+ * The field does not use muBN: elements are unsaturated little endian
+ * limbs, so that products accumulate without carry chains and only get
+ * one carry pass at the end.
+ *  - 64 bits words: 5 limbs of 51 bits, 128 bits products
+ *  - else: 10 limbs of 26 and 25 bits (radix 2^25.5), 64 bits products
+ *
+ * Limbs are kept a few bits over their width between operations.
+ * mu25519_fe_add does not carry: its inputs shall not be sums, and a sum
+ * of up to three elements is accepted by all the other operations.
+ *
+ * All the functions run in constant time.
+ */
+
+#include "muBN.h"
+
+#if UBN_BITS_PER_WORD == 64
+#define U25519_LIMBS  5
+typedef uint64_t      mu25519_limb_t;
+#else
+#define U25519_LIMBS  10
+typedef uint32_t      mu25519_limb_t;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Field element, value sum(v[i].2^ceil(i.255/U25519_LIMBS)) mod p
+ */
+typedef struct {
+  mu25519_limb_t  v[U25519_LIMBS];
+} mu25519_fe_t;
+
+/* ======================================================================================= */
+/*                                      Field                                              */
+/* ======================================================================================= */
+
+/**
+ * r = 0, r = 1, r = a
+ */
+void mu25519_fe_0(mu25519_fe_t *r);
+void mu25519_fe_1(mu25519_fe_t *r);
+void mu25519_fe_copy(mu25519_fe_t *r, const mu25519_fe_t *a);
+
+/**
+ * r = little endian s, bit 255 ignored. s may be above p.
+ */
+void mu25519_fe_frombytes(mu25519_fe_t *r, const uint8_t *s);
+
+/**
+ * s = a, 32 bytes little endian, fully reduced
+ */
+void mu25519_fe_tobytes(uint8_t *s, const mu25519_fe_t *a);
+
+/**
+ * r = a + b, not reduced, see header
+ */
+void mu25519_fe_add(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b);
+
+/**
+ * r = a - b
+ */
+void mu25519_fe_sub(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b);
+
+/**
+ * r = -a
+ */
+void mu25519_fe_neg(mu25519_fe_t *r, const mu25519_fe_t *a);
+
+/**
+ * r = a.b, r = a², r = a.s with s < 2^20
+ * r may be a or b
+ */
+void mu25519_fe_mul(mu25519_fe_t *r, const mu25519_fe_t *a, const mu25519_fe_t *b);
+void mu25519_fe_sqr(mu25519_fe_t *r, const mu25519_fe_t *a);
+void mu25519_fe_mul_small(mu25519_fe_t *r, const mu25519_fe_t *a, uint32_t s);
+
+/**
+ * r = a⁻¹ = a^(p-2), 254 squarings and 11 products. 0 gives 0.
+ */
+void mu25519_fe_inv(mu25519_fe_t *r, const mu25519_fe_t *a);
+
+/**
+ * r = a^((p-5)/8) = a^(2^252-3), square root helper
+ */
+void mu25519_fe_pow22523(mu25519_fe_t *r, const mu25519_fe_t *a);
+
+/**
+ * @return 1 if a = 0 mod p, 0 else
+ */
+muBN_word_t mu25519_fe_iszero(const mu25519_fe_t *a);
+
+/**
+ * @return the parity of a mod p, the "sign" of RFC 8032
+ */
+muBN_word_t mu25519_fe_isneg(const mu25519_fe_t *a);
+
+/**
+ * r = a if move is 1, leave r as is if move is 0
+ */
+void mu25519_fe_cmov(mu25519_fe_t *r, const mu25519_fe_t *a, mu25519_limb_t move);
+
+/**
+ * swap a and b if swap is 1, leave them as is if swap is 0. Same job in
+ * both cases.
+ */
+void mu25519_fe_cswap(mu25519_fe_t *a, mu25519_fe_t *b, mu25519_limb_t swap);
+
+/* ======================================================================================= */
+/*                                      X25519                                             */
+/* ======================================================================================= */
+
+/**
+ * out = X25519(scalar, u), RFC 7748: x-only Montgomery ladder over the
+ * clamped scalar, with constant time conditional swaps.
+ *
+ * @param [out] out     32 bytes, little endian u-coordinate
+ * @param [in]  scalar  32 bytes, clamped on a local copy
+ * @param [in]  u       32 bytes, little endian u-coordinate, bit 255 ignored
+ *
+ * @return 1
+ * @return 0 if out is all zero, u was of small order
+ */
+muBN_word_t mu_x25519(uint8_t *out, const uint8_t *scalar, const uint8_t *u);
+
+/**
+ * out = X25519(scalar, 9), the public key of scalar
+ */
+muBN_word_t mu_x25519_base(uint8_t *out, const uint8_t *scalar);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -48,7 +48,7 @@ void muBN_init_zero(muBN_t *r, muBN_uword_t  *a ,muBN_size_t wlen ) {
 }
 
 void muBN_zero(muBN_t *r) {
-  muBN_uword_t wlen = r->wlen;
+  muBN_size_t wlen = r->wlen;
   while (wlen--) {
     r->v[wlen] = 0;    
   }
@@ -157,6 +157,7 @@ muBN_size_t muBN_ubn2hex (muBN_t *r,  uint8_t *to,  muBN_size_t  blen)  {
   muBN_size_t  wlen;
   muBN_uword_t  w;
   muBN_size_t  i;
+  muBN_size_t  k;
 
   if (blen < (muBN_size_t)(r->wlen*sizeof(muBN_uword_t)*2)) {
     return -1;
@@ -167,25 +168,9 @@ muBN_size_t muBN_ubn2hex (muBN_t *r,  uint8_t *to,  muBN_size_t  blen)  {
   wlen = r->wlen;
   for (i = 0; i<wlen; i++) {    
     w = r->v[i];
-#if UBN_BITS_PER_WORD == 32
-    to[blen+0] = HEX(((w>>28) &0x0F));
-    to[blen+1] = HEX(((w>>24) &0x0F));
-    to[blen+2] = HEX(((w>>20) &0x0F));
-    to[blen+3] = HEX(((w>>16) &0x0F));
-    to[blen+4] = HEX(((w>>12) &0x0F));
-    to[blen+5] = HEX(((w>> 8) &0x0F));
-    to[blen+6] = HEX(((w>> 4) &0x0F));
-    to[blen+7] = HEX(( w      &0x0F));
-#elif UBN_BITS_PER_WORD == 16
-    to[blen+0] = HEX(((w>>12) &0x0F));
-    to[blen+1] = HEX(((w>> 8) &0x0F));
-    to[blen+2] = HEX(((w>> 4) &0x0F));
-    to[blen+3] = HEX(( w      &0x0F));
-#else
-    to[blen+0] = HEX(((w>> 4) &0x0F));
-    to[blen+1] = HEX(( w      &0x0F));
-#endif
-    blen  += 2*(UBN_BITS_PER_WORD/8);
+    for (k = UBN_BITS_PER_WORD-4; k>=0; k -= 4) {
+      to[blen++] = HEX((w>>k) &0x0F);
+    }
   }
   to[blen] = 0;
   return blen;
@@ -199,6 +184,7 @@ static char VAL(unsigned char c) {
 muBN_size_t muBN_hex2ubn (muBN_t *r,  uint8_t *from,  muBN_size_t  blen)  {
   muBN_size_t  wlen;
   muBN_uword_t  w;
+  muBN_size_t  k;
     
   if (blen > (muBN_size_t)(r->wlen*sizeof(muBN_uword_t)*2)) {
     return -1;
@@ -206,31 +192,13 @@ muBN_size_t muBN_hex2ubn (muBN_t *r,  uint8_t *from,  muBN_size_t  blen)  {
   
   wlen = r->wlen;  
   muBN_zero(r);
-  while (blen > (muBN_size_t)(UBN_BITS_PER_WORD/8)) {
-    blen -= UBN_BITS_PER_WORD/8;
+  while (blen > (muBN_size_t)(UBN_BITS_PER_WORD/4)) {
+    blen -= UBN_BITS_PER_WORD/4;
     wlen --;
-#if UBN_BITS_PER_WORD == 32
-    w = 
-      (VAL(from[blen+0]) << 28) |
-      (VAL(from[blen+1]) << 24) |
-      (VAL(from[blen+2]) << 20) |
-      (VAL(from[blen+3]) << 16) |
-      (VAL(from[blen+4]) << 12) |
-      (VAL(from[blen+5]) <<  8) |
-      (VAL(from[blen+6]) <<  4) |
-      (VAL(from[blen+7])     );
-    
-#elif UBN_BITS_PER_WORD == 16
-    w =
-      (VAL(from[blen+1]) << 12) |
-      (VAL(from[blen+2]) <<  8) |
-      (VAL(from[blen+3]) <<  4) |
-      (VAL(from[blen+4])     );
-#else
-    w = 
-      (VAL(from[i+0]) << 4) |
-      (VAL(from[i+1])     );
-#endif    
+    w = 0;
+    for (k = 0; k<(muBN_size_t)(UBN_BITS_PER_WORD/4); k++) {
+      w = (w<<4) | VAL(from[blen+k]);
+    }
     r->v[wlen]= w;       
   }    
   if (blen) {
@@ -268,7 +236,7 @@ void muBN_or(muBN_t *r, muBN_t *a,  muBN_t *b) {
   }  
 }
 void muBN_and(muBN_t *r, muBN_t *a,  muBN_t *b) {
-  muBN_uword_t wlen =r->wlen;
+  muBN_size_t  wlen =r->wlen;
   r->OV = 0;
   r->C = 0;
   while (wlen--) {    
@@ -296,22 +264,26 @@ muBN_word_t muBN_testC(muBN_t *r) {
 
 muBN_size_t   muBN_count_bit(const muBN_t *a) {
   muBN_size_t wlen  = a->wlen;
-  muBN_uword_t nbits = wlen*UBN_BITS_PER_WORD;
+  muBN_size_t nbits = wlen*UBN_BITS_PER_WORD;
   muBN_size_t  i ;
+  muBN_uword_t w;
   for (i =0; i<wlen; i++) {
     if (a->v[i]) {
       break;
     }    
     nbits -= UBN_BITS_PER_WORD;
   }
+  if (i == wlen) {
+    return 0;
+  }
 
-  wlen = (a->v[i]);
+  w = (a->v[i]);
   for (i = 0; i<(muBN_size_t)(UBN_BITS_PER_WORD);i++) {
-    if (wlen & UBN_WORD_HIGH_BIT) {
+    if (w & UBN_WORD_HIGH_BIT) {
       break;
     }
     nbits--;
-    wlen = wlen<<1;
+    w = w<<1;
   }
   return nbits;
 }
@@ -319,7 +291,7 @@ muBN_size_t   muBN_count_bit(const muBN_t *a) {
 muBN_word_t  muBN_test_bit(const muBN_t *a, muBN_size_t  n) {
   return
     (  (a->v[a->wlen-1-n/UBN_BITS_PER_WORD])
-       & (1<<(n%UBN_BITS_PER_WORD)) )
+       & ((muBN_uword_t)1<<(n%UBN_BITS_PER_WORD)) )
     ?1:0;
 }
 /* ======================================================================================= */
@@ -526,7 +498,7 @@ void muBN_rshift1c(muBN_t *r) {
   muBN_uword_t c;
   muBN_size_t i;
 
-  c = r->C ? 1<<(UBN_BITS_PER_WORD-1) : 0;
+  c = r->C ? UBN_WORD_HIGH_BIT : 0;
   for (i = 0; i<wlen; i++) {
     v = r->v[i];
     r->v[i] = v>>1|c;
@@ -560,7 +532,7 @@ void muBN_rshiftc(muBN_t *r, muBN_size_t  n)  {
  l1:
   if ((i^w) == 0) goto z;
 
-  c = r->v[i-w-1] << (UBN_BITS_PER_WORD-b);
+  c = r->v[i-w-1] << ((UBN_BITS_PER_WORD-b)%UBN_BITS_PER_WORD);
   c &= m;
   v =  r->v[i-w]>>b|c;
   r->v[i] = v;
@@ -569,7 +541,7 @@ void muBN_rshiftc(muBN_t *r, muBN_size_t  n)  {
   
  z:  
   c = r->C?UBN_WORD_BIT_MASK:0;
-  c = c << (UBN_BITS_PER_WORD-b);
+  c = c << ((UBN_BITS_PER_WORD-b)%UBN_BITS_PER_WORD);
   c &= m;
   v =  r->v[i-w]>>b|c;
   r->v[i] = v;
@@ -625,7 +597,7 @@ void muBN_lshift(muBN_t *r, muBN_size_t  n)  {
   wlen1 = r->wlen - w -1;
  l1: 
   if ((i^wlen1) == 0) goto z;
-  c = r->v[i+w+1] >> (UBN_BITS_PER_WORD-b);
+  c = r->v[i+w+1] >> ((UBN_BITS_PER_WORD-b)%UBN_BITS_PER_WORD);
   c &= m;
   v =  r->v[i+w]<<b|c;
   r->v[i] = v;
@@ -650,6 +622,223 @@ void muBN_lshift(muBN_t *r, muBN_size_t  n)  {
 }
 
 
+/* ---------------------------------------------------------------------------------------
+ * CPU features of the x86 kernels, resolved once by CPUID at load time (or on the first
+ * call if another constructor calls muBN first), then read as a plain flag word.
+ * --------------------------------------------------------------------------------------- */
+#if (defined(UBN_X86_ADX) || defined(UBN_X86_AVX2) || defined(UBN_X86_IFMA)) && \
+    (UBN_BITS_PER_WORD == 64)
+#define UBN_CPU_READY  0x01
+#define UBN_CPU_ADX    0x02
+#define UBN_CPU_AVX2   0x04
+#define UBN_CPU_IFMA   0x08
+
+static volatile unsigned int muBN_cpu;
+
+__attribute__((constructor))
+static void muBN_cpu_init(void) {
+  unsigned int f;
+
+  __builtin_cpu_init();
+  f = UBN_CPU_READY;
+  if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx")) {
+    f |= UBN_CPU_ADX;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    f |= UBN_CPU_AVX2;
+  }
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma")) {
+    f |= UBN_CPU_IFMA;
+  }
+  muBN_cpu = f;
+}
+
+static int muBN_cpu_has(unsigned int feature) {
+  if (!(muBN_cpu & UBN_CPU_READY)) {
+    muBN_cpu_init();
+  }
+  return (muBN_cpu & feature) != 0;
+}
+#endif
+
+/* ---------------------------------------------------------------------------------------
+ * BMI2/ADX kernels.
+ *
+ * mulx products and _addcarryx_u64 carry chains, the low and high halves of the
+ * products being added by two independent chains. Word arrays are the native most
+ * significant word first ones, pointers below are on the least significant word.
+ * Same results as the portable code.
+ * --------------------------------------------------------------------------------------- */
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+#include <immintrin.h>
+
+/* Montgomery products keep a 2*wlen words product on the stack */
+#define UBN_ADX_MAX_WLEN  128
+
+typedef unsigned long long muBN_adx_t;
+
+static int muBN_adx_use(void) {
+  return muBN_cpu_has(UBN_CPU_ADX);
+}
+
+/* r = a+b, n words, returns the carry */
+__attribute__((target("adx")))
+static muBN_uword_t muBN_adx_add(muBN_uword_t *r, muBN_uword_t *a, muBN_uword_t *b, muBN_size_t n) {
+  muBN_adx_t     x;
+  unsigned char  c;
+
+  c = 0;
+  while (n--) {
+    c    = _addcarryx_u64(c, a[n], b[n], &x);
+    r[n] = x;
+  }
+  return c;
+}
+
+/* r = a-b, n words, returns the borrow */
+__attribute__((target("adx")))
+static muBN_uword_t muBN_adx_sub(muBN_uword_t *r, muBN_uword_t *a, muBN_uword_t *b, muBN_size_t n) {
+  muBN_adx_t     x;
+  unsigned char  c;
+
+  c = 0;
+  while (n--) {
+    c    = _subborrow_u64(c, a[n], b[n], &x);
+    r[n] = x;
+  }
+  return c;
+}
+
+/* t[0, -1, ..., -(n-1)] += u*b[0, -1, ..., -(n-1)], returns the carry word.
+ * One mulx per word, t+lo on the CF chain (adcx) and the previous high
+ * word on the OF chain (adox). Compilers only emit adc from the intrinsics,
+ * so the row is written in asm; the loop control (lea, jrcxz) leaves both
+ * flags untouched (jrcxz only reaches 128 bytes, hence the trampolines).
+ * n%4 single steps, then blocks of four words.
+ */
+#define UBN_ADX_STEP(o)                         \
+    "movq   " #o "(%[t]), %[x]           \n\t"  \
+    "mulxq  " #o "(%[b]), %[lo], %[hi]   \n\t"  \
+    "adcxq  %[lo], %[x]                  \n\t"  \
+    "adoxq  %[ph], %[x]                  \n\t"  \
+    "movq   %[x], " #o "(%[t])           \n\t"  \
+    "movq   %[hi], %[ph]                 \n\t"
+
+static inline muBN_uword_t muBN_adx_addmul(muBN_uword_t *t, muBN_uword_t *b, muBN_size_t n,
+                                           muBN_uword_t u) {
+  muBN_adx_t  ph, x, lo, hi, cnt, blk;
+
+  cnt = (muBN_adx_t)(n&3);
+  blk = (muBN_adx_t)(n>>2);
+  __asm__ __volatile__ (
+    "xorl   %k[ph], %k[ph]               \n\t"
+    "1:                                  \n\t"
+    "jrcxz  2f                           \n\t"
+    UBN_ADX_STEP(0)
+    "leaq   -8(%[t]), %[t]               \n\t"
+    "leaq   -8(%[b]), %[b]               \n\t"
+    "leaq   -1(%%rcx), %%rcx             \n\t"
+    "jmp    1b                           \n\t"
+    "2:                                  \n\t"
+    "movq   %[blk], %%rcx                \n\t"
+    "jrcxz  5f                           \n\t"
+    "jmp    3f                           \n\t"
+    "5:                                  \n\t"
+    "jmp    4f                           \n\t"
+    "3:                                  \n\t"
+    UBN_ADX_STEP(0)
+    UBN_ADX_STEP(-8)
+    UBN_ADX_STEP(-16)
+    UBN_ADX_STEP(-24)
+    "leaq   -32(%[t]), %[t]              \n\t"
+    "leaq   -32(%[b]), %[b]              \n\t"
+    "leaq   -1(%%rcx), %%rcx             \n\t"
+    "jrcxz  4f                           \n\t"
+    "jmp    3b                           \n\t"
+    "4:                                  \n\t"
+    "movl   $0, %k[x]                    \n\t"
+    "adcxq  %[x], %[ph]                  \n\t"
+    "adoxq  %[x], %[ph]                  \n\t"
+    : [ph] "=&r" (ph), [x] "=&r" (x), [lo] "=&r" (lo), [hi] "=&r" (hi),
+      [t] "+r" (t), [b] "+r" (b), "+c" (cnt)
+    : "d" (u), [blk] "r" (blk)
+    : "cc", "memory");
+  return ph;
+}
+
+/* r = a*b, r of an+bn words, see muBN_mul_school */
+__attribute__((target("bmi2,adx")))
+static void muBN_adx_mul(muBN_uword_t *r,
+                         muBN_uword_t *a, muBN_size_t an,
+                         muBN_uword_t *b, muBN_size_t bn) {
+  muBN_uword_t  *t;
+  muBN_size_t   i;
+
+  for (i = 0; i < an+bn; i++) {
+    r[i] = 0;
+  }
+  t = r+an+bn-1;
+  for (i = 0; i < an; i++) {
+    t[-i-bn] = muBN_adx_addmul(t-i, b+bn-1, bn, a[an-1-i]);
+  }
+}
+
+/* t = a², t of 2n words */
+__attribute__((target("bmi2,adx")))
+static void muBN_adx_sqr(muBN_uword_t *t, muBN_uword_t *a, muBN_size_t n) {
+  muBN_adx_t     lo, hi, x;
+  muBN_uword_t   *tl, *al;
+  unsigned char  c;
+  muBN_size_t    i;
+
+  //1. off-diagonal products
+  for (i = 0; i < 2*n; i++) {
+    t[i] = 0;
+  }
+  tl = t+2*n-1;
+  al = a+n-1;
+  for (i = 0; i < n-1; i++) {
+    tl[-2*i-1-(n-1-i)] = muBN_adx_addmul(tl-2*i-1, al-i-1, n-1-i, al[-i]);
+  }
+
+  //2. doubled, plus the squares
+  c = 0;
+  for (i = 0; i < 2*n; i++) {
+    x = tl[-i];
+    tl[-i] = (x<<1) | c;
+    c = (unsigned char)(x>>63);
+  }
+  c = 0;
+  for (i = 0; i < n; i++) {
+    lo = _mulx_u64(al[-i], al[-i], &hi);
+    c = _addcarryx_u64(c, tl[-2*i],   lo, &x);
+    tl[-2*i] = x;
+    c = _addcarryx_u64(c, tl[-2*i-1], hi, &x);
+    tl[-2*i-1] = x;
+  }
+}
+
+/* r = t.R⁻¹, t of 2n words, r and t < 2m before the final subtraction */
+__attribute__((target("bmi2,adx")))
+static muBN_uword_t muBN_adx_redc(muBN_uword_t *t, muBN_uword_t *m, muBN_size_t n,
+                                  muBN_uword_t j0) {
+  muBN_adx_t     x;
+  muBN_uword_t   *tl, *ml;
+  unsigned char  c;
+  muBN_size_t    i;
+
+  tl = t+2*n-1;
+  ml = m+n-1;
+  c  = 0;
+  for (i = 0; i < n; i++) {
+    x = muBN_adx_addmul(tl-i, ml, n, tl[-i]*j0);
+    c = _addcarryx_u64(c, tl[-i-n], x, &x);
+    tl[-i-n] = x;
+  }
+  return c;
+}
+#endif
+
 // r = a+b 
 muBN_word_t muBN_add(muBN_t *r,  muBN_t *a, muBN_t *b) {
 #ifdef ADDSUB_WITH_DOUBLE_WORD
@@ -673,6 +862,13 @@ muBN_word_t muBN_add(muBN_t *r,  muBN_t *a, muBN_t *b) {
   muBN_uword_t *pa, *pb,*pr;
   r->OV = 0;
   carry = 0;
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_adx_use()) {
+    carry = muBN_adx_add(r->v, a->v, b->v, wlen);
+    r->C  = (a->C+b->C+carry)&1;
+    return r->C;
+  }
+#endif
   pa = &a->v[wlen];
   pb = &b->v[wlen];
   pr = &r->v[wlen];
@@ -761,6 +957,13 @@ muBN_word_t muBN_sub(muBN_t *r,  muBN_t *a, muBN_t *b) {
   muBN_uword_t *pa, *pb,*pr;
   r->OV = 0;
   carry = 0;
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_adx_use()) {
+    carry = muBN_adx_sub(r->v, a->v, b->v, wlen);
+    r->C  = (a->C-b->C-carry)&1;
+    return r->C;
+  }
+#endif
   pa = &a->v[wlen];
   pb = &b->v[wlen];
   pr = &r->v[wlen];
@@ -826,31 +1029,193 @@ muBN_word_t muBN_sub_uword(muBN_t *r,  muBN_t *a, muBN_uword_t vb) {
 }
 
 
-void muBN_mul(muBN_t *r, muBN_t *a, muBN_t *b) {
+/* r[0..an+bn-1] = a*b, schoolbook, words in muBN order (MSW first) */
+static void muBN_mul_school(muBN_uword_t *r,
+                            muBN_uword_t *a, muBN_size_t awlen,
+                            muBN_uword_t *b, muBN_size_t bwlen) {
   muBN_udword_t ab;
   muBN_udword_t carry;
   muBN_uword_t  *rv;
-  muBN_size_t    awlen,bwlen;
   muBN_size_t   j;
 
-  awlen = a->wlen;
-  bwlen = b->wlen;
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_adx_use()) {
+    muBN_adx_mul(r, a, awlen, b, bwlen);
+    return;
+  }
+#endif
+  for (j = 0; j < awlen+bwlen; j++) {
+    r[j] = 0;
+  }
   carry = 0;
-  muBN_zero(r);  
-  rv = r->v+r->wlen-awlen;
+  rv = r+awlen;
   while(awlen--) {
     rv[0] = carry;
     carry = 0;
     j = bwlen;  
     while(j--) {
-      ab = rv[j]+ (muBN_udword_t)(a->v[awlen])*(muBN_udword_t)(b->v[j])+carry;
+      ab = rv[j]+ (muBN_udword_t)(a[awlen])*(muBN_udword_t)(b[j])+carry;
       rv[j] = ab;
       carry = ab>>UBN_BITS_PER_WORD;
     }
     rv--;
   }
   rv[0] = carry;
+}
+
+void muBN_mul(muBN_t *r, muBN_t *a, muBN_t *b) {
+  muBN_zero(r);  
+  muBN_mul_school(r->v+r->wlen-a->wlen-b->wlen, a->v, a->wlen, b->v, b->wlen);
+}
+
+/* r[0..rn-1] += a[0..an-1], an <= rn, LSW aligned. Return carry.
+ * The carry runs over all the rn words, whatever its value.
+ */
+static muBN_uword_t muBN_words_add(muBN_uword_t *r, muBN_size_t rn,
+                                   muBN_uword_t *a, muBN_size_t an) {
+  muBN_udword_t sum;
+  muBN_uword_t  carry;
+
+  carry = 0;
+  r += rn-an;
+  rn -= an;
+  while (an--) {
+    sum = (muBN_udword_t)r[an] + a[an] + carry;
+    r[an] = (muBN_uword_t)sum;
+    carry = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+  }
+  while (rn--) {
+    r--;
+    sum = (muBN_udword_t)r[0] + carry;
+    r[0] = (muBN_uword_t)sum;
+    carry = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+  }
+  return carry;
+}
+
+/* d[0..l-1] = |x - y|, with x on l words and y on h words, h <= l <= h+1.
+ * x - y is negated under the mask of its borrow: same job for all values.
+ * Return 1 if x < y
+ */
+static muBN_uword_t muBN_words_absdiff(muBN_uword_t *d,
+                                       muBN_uword_t *x, muBN_size_t l,
+                                       muBN_uword_t *y, muBN_size_t h) {
+  muBN_udword_t sub;
+  muBN_uword_t  borrow, mask, carry;
+  muBN_size_t   i;
+
+  borrow = 0;
+  i = l;
+  while (i--) {
+    sub = (muBN_udword_t)x[i] - ((i >= l-h) ? y[i-(l-h)] : 0) - borrow;
+    d[i] = (muBN_uword_t)sub;
+    borrow = (muBN_uword_t)(sub>>UBN_BITS_PER_WORD)&1;
+  }
+  mask  = (muBN_uword_t)0 - borrow;
+  carry = borrow;
+  i = l;
+  while (i--) {
+    sub = (muBN_udword_t)(d[i]^mask) + carry;
+    d[i] = (muBN_uword_t)sub;
+    carry = (muBN_uword_t)(sub>>UBN_BITS_PER_WORD);
+  }
+  return borrow;
+}
 
+/* r[0..2n-1] = a*b, with a and b on n words.
+ *
+ * a = a1.B^h + a0, b = b1.B^h + b0, with a0,b0 on h words and a1,b1 on l = n-h words:
+ *   a.b = a1b1.B^2h + (a1b1 + a0b0 - (a1-a0)(b1-b0)).B^h + a0b0
+ * The subtractive form keeps the middle operands on l words.
+ * temp usage: 4.l + temp(l)
+ */
+static void muBN_mul_kara(muBN_uword_t *r, muBN_uword_t *a, muBN_uword_t *b,
+                          muBN_size_t n, muBN_uword_t *temp) {
+  muBN_size_t   h, l;
+  muBN_udword_t sum;
+  muBN_uword_t  sa, sb, carry, c, mask;
+  muBN_uword_t  *da, *db, *zm, *u;
+
+  if ((n < 2) || (n < UBN_KARATSUBA_THRESHOLD)) {
+    muBN_mul_school(r, a, n, b, n);
+    return;
+  }
+  h  = n/2;
+  l  = n-h;
+  da = temp;
+  db = temp+l;
+  zm = temp+2*l;
+  u  = temp;
+
+  //a0b0 in the 2h low words, a1b1 in the 2l high words
+  muBN_mul_kara(r+2*l, a+l, b+l, h, temp);
+  muBN_mul_kara(r, a, b, l, temp);
+
+  //zm = |a1-a0|.|b1-b0|
+  sa = muBN_words_absdiff(da, a, l, a+l, h);
+  sb = muBN_words_absdiff(db, b, l, b+l, h);
+  muBN_mul_kara(zm, da, db, l, temp+4*l);
+
+  //u = a1b1 + a0b0 -/+ zm, the true value is >= 0 and < B^(2l+1). For the same signs,
+  //zm is subtracted as the add of its complement, selected by mask
+  for (h = 0; h < 2*l; h++) {
+    u[h] = r[h];
+  }
+  h = n-l;
+  carry = muBN_words_add(u, 2*l, r+2*l, 2*h);
+  mask  = (muBN_uword_t)0 - ((sa^sb)^1);
+  c     = mask&1;
+  for (h = 2*l; h--; ) {
+    sum  = (muBN_udword_t)u[h] + (zm[h]^mask) + c;
+    u[h] = (muBN_uword_t)sum;
+    c    = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+  }
+  carry += c - (mask&1);
+  h = n-l;
+
+  //r += u.B^h
+  muBN_words_add(r, 2*n-h, u, 2*l);
+  zm[0] = carry;
+  muBN_words_add(r, 2*n-h-2*l, zm, 1);
+}
+
+void muBN_mul_karatsuba(muBN_t *r, muBN_t *a, muBN_t *b, muBN_uword_t *temp) {
+  muBN_uword_t  *pa, *pb, *pr, *pt;
+  muBN_size_t    an, bn, c, n;
+
+  pa = a->v;
+  an = a->wlen;
+  pb = b->v;
+  bn = b->wlen;
+  if (an < bn) {
+    pa = b->v;
+    an = b->wlen;
+    pb = a->v;
+    bn = a->wlen;
+  }
+  muBN_zero(r);
+  pr = r->v+r->wlen-an-bn;
+  if (bn < UBN_KARATSUBA_THRESHOLD) {
+    muBN_mul_school(pr, pa, an, pb, bn);
+    return;
+  }
+  if (an == bn) {
+    muBN_mul_kara(pr, pa, pb, bn, temp);
+    return;
+  }
+  //unbalanced: bn words slices of a, from the LSW, each multiplied by b
+  pt = temp+2*bn;
+  n  = an;
+  while (n) {
+    c = n < bn ? n : bn;
+    n -= c;
+    if (c == bn) {
+      muBN_mul_kara(temp, pa+n, pb, bn, pt);
+    } else {
+      muBN_mul_school(temp, pa+n, c, pb, bn);
+    }
+    muBN_words_add(pr, n+c+bn, temp, c+bn);
+  }
 }
 
 void muBN_mul_uword(muBN_t *r, muBN_t *a, muBN_uword_t w) {
@@ -880,6 +1245,166 @@ void muBN_mul_uword(muBN_t *r, muBN_t *a, muBN_uword_t w) {
 /*                                Z/nZ  Arithmetic                                         */
 /* ======================================================================================= */
 
+/* v = floor((B²-1)/d) - B, with B = 2^b and d a normalized word (high bit set) */
+static muBN_uword_t muBN_reciprocal(muBN_uword_t d) {
+  return (muBN_uword_t)((((muBN_udword_t)(muBN_uword_t)~d)<<UBN_BITS_PER_WORD | UBN_MAX_UWORD) / d);
+}
+
+/* Return (u1:u0)/d and set *r to (u1:u0)%d, with d normalized, u1 < d and
+ * v = muBN_reciprocal(d). Two multiplications, no division.
+ * (Moller-Granlund, Improved division by invariant integers, alg. 4)
+ */
+static muBN_uword_t muBN_div2by1(muBN_uword_t *r, muBN_uword_t u1, muBN_uword_t u0,
+                                 muBN_uword_t d,  muBN_uword_t v) {
+  muBN_udword_t q;
+  muBN_uword_t  q1, q0, rr;
+
+  q  = (muBN_udword_t)v*u1 + (((muBN_udword_t)u1<<UBN_BITS_PER_WORD)|u0);
+  q1 = (muBN_uword_t)(q>>UBN_BITS_PER_WORD) + 1;
+  q0 = (muBN_uword_t)q;
+  rr = u0 - q1*d;
+  if (rr > q0) {
+    q1--;
+    rr += d;
+  }
+  if (rr >= d) {
+    q1++;
+    rr -= d;
+  }
+  *r = rr;
+  return q1;
+}
+
+/* B^e = q.m + r, with B = 2^b, m non zero on t significant words and e >= t.
+ * q is NULL or receives the e-t+1 quotient words, the quotient shall fit.
+ * temp word length a least t+e+1.
+ *
+ *  . m' = m<<shf is the normalized modulus
+ *  . B^t = m' + (B^t - m'), a single negation
+ *  . shf doublings, then (e-t) word shifts reduced by one quotient
+ *    word each, give 2^(b.e+shf) mod m' = (B^e mod m)<<shf, the quotient
+ *    is the same for m and m'.
+ */
+static void muBN_bpow_divrem(muBN_t *r, muBN_uword_t *q, muBN_t *m, muBN_size_t e,
+                             muBN_uword_t *temp) {
+  muBN_uword_t     *pm, *pa;
+  muBN_size_t       t, shf;
+  muBN_size_t       i, j, k;
+  muBN_udword_t     sum, muldw;
+  muBN_uword_t      carry, v;
+  muBN_uword_t      qi, qtop, rh;
+  muBN_uword_t      pm0, pm1, inv;
+  muBN_t            ubn_mn, ubn_a;
+
+  //1. m' = normalized m, on its t significant words
+  t  = m->wlen;
+  pm = m->v;
+  while (t && (!*pm)) {
+    pm++;
+    t--;
+  }
+  if (t == 0) {
+    return;
+  }
+  muBN_init(&ubn_mn, temp, t);
+  for (i = 0; i<t; i++) {
+    ubn_mn.v[i] = pm[i];
+  }
+  shf = 0;
+  v = pm[0];
+  while (v < UBN_WORD_HIGH_BIT) {
+    v = v<<1;
+    shf++;
+  }
+  muBN_lshift(&ubn_mn, shf);
+  pm  = ubn_mn.v;
+  pm0 = pm[0];
+  pm1 = (t==1) ? 0 : pm[1];
+  inv = muBN_reciprocal(pm0);
+
+  //2. a = B^t mod m', in the last t words of the t+1 words window pa
+  pa = temp+t;
+  pa[0] = 0;
+  muBN_init(&ubn_a, pa+1, t);
+  for (i = 0; i<t; i++) {
+    ubn_a.v[i] = pm[i];
+  }
+  muBN_negate(&ubn_a);
+  ubn_a.C = 0;
+  qtop = 1;
+  if (muBN_ucmp(&ubn_a,&ubn_mn) >= 0) {
+    //m is a power of two
+    muBN_sub(&ubn_a,&ubn_a,&ubn_mn);
+    qtop = 2;
+  }
+
+  //3. shf doublings
+  for (k = 0; k<shf; k++) {
+    qtop = qtop<<1;
+    if (muBN_lshift1c(&ubn_a) || (muBN_ucmp(&ubn_a,&ubn_mn) >= 0)) {
+      ubn_a.C = 0;
+      muBN_sub(&ubn_a,&ubn_a,&ubn_mn);
+      qtop |= 1;
+    }
+    ubn_a.C = 0;
+  }
+  if (q) {
+    *q++ = qtop;
+  }
+
+  //4. a = a.B mod m', one quotient word per step, the window slides
+  //   one word to the right instead of shifting a
+  for (k = e-t; k>0; k--) {
+    pa++;
+    pa[t] = 0;
+    //4.1 estimate qi from pa[0]:pa[1]:pa[2] and pm0:pm1, qi is exact or one too big
+    if (pa[0] >= pm0) {
+      qi  = UBN_MAX_UWORD;
+      sum = (muBN_udword_t)pa[1] + pm0;
+    } else {
+      qi  = muBN_div2by1(&v, pa[0], pa[1], pm0, inv);
+      sum = v;
+    }
+    while ((sum>>UBN_BITS_PER_WORD) == 0) {
+      rh = (t==1) ? 0 : pa[2];
+      if ((muBN_udword_t)qi*pm1 <= ((sum<<UBN_BITS_PER_WORD)|rh)) {
+        break;
+      }
+      qi--;
+      sum += pm0;
+    }
+    //4.2 a = a - qi.m', borrow is merged in the product carry
+    carry = 0;
+    for (j = t-1; j >= 0; j--) {
+      muldw = (muBN_udword_t)pm[j]*qi + carry;
+      v     = (muBN_uword_t)muldw;
+      carry = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD) + (pa[j+1] < v);
+      pa[j+1] -= v;
+    }
+    v     = pa[0];
+    pa[0] = v - carry;
+    //4.3 qi was one too big: add m' back
+    if (v < carry) {
+      qi--;
+      carry = 0;
+      for (j = t-1; j >= 0; j--) {
+        sum = (muBN_udword_t)pa[j+1] + pm[j] + carry;
+        pa[j+1] = (muBN_uword_t)sum;
+        carry = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+      }
+      pa[0] += carry;
+    }
+    if (q) {
+      *q++ = qi;
+    }
+  }
+
+  //5. r = a>>shf
+  muBN_init(&ubn_a, pa+1, t);
+  muBN_urshift(&ubn_a, shf);
+  muBN_copy(r, &ubn_a);
+}
+
 
 
 muBN_word_t muBN_mod_inv(muBN_t *r, muBN_t *in, muBN_t *m,  muBN_uword_t *temp) {
@@ -941,8 +1466,320 @@ muBN_word_t muBN_mod_inv(muBN_t *r, muBN_t *in, muBN_t *m,  muBN_uword_t *temp)
   }
 }
 
+/* ---------------------------------------------------------------------------------------
+ * safegcd inversion, Bernstein-Yang divsteps
+ *
+ * Numbers are held as L signed limbs of N = b-2 bits, LSW first: limbs
+ * 0..L-2 are in [0, 2^N), the top one carries the sign. N divsteps are
+ * batched in a transition matrix (u v; q r), scaled by 2^N, applied to
+ *  . f, g : (f,g) = (u.f + v.g, q.f + r.g) / 2^N, exact
+ *  . d, e : same product mod m, kept in (-2m, m) by adding a multiple
+ *           of m that makes the low limb zero
+ * Matrix entries satisfy |u|+|v| <= 2^N, |q|+|r| <= 2^N, so a limb product
+ * with carry fits muBN_dword_t.
+ * --------------------------------------------------------------------------------------- */
+#define UBN_SGCD_N     ((muBN_size_t)UBN_BITS_PER_WORD-2)
+#define UBN_SGCD_MASK  ((muBN_uword_t)(((muBN_uword_t)1<<UBN_SGCD_N)-1))
+
+typedef struct {
+  muBN_word_t u, v, q, r;
+} muBN_sgcd_mat_t;
+
+/* N divsteps on the low limbs of f and g, constant time, zeta = -(delta+1/2).
+ * delta grows with the divsteps count, hence int32_t whatever the word size.
+ */
+static int32_t muBN_sgcd_divsteps(int32_t zeta, muBN_uword_t f, muBN_uword_t g,
+                                   muBN_sgcd_mat_t *t) {
+  muBN_uword_t u, v, q, r;
+  muBN_uword_t c1, c2, x, y, z;
+  muBN_size_t  i;
+
+  u = 1; v = 0;
+  q = 0; r = 1;
+  for (i = 0; i < UBN_SGCD_N; i++) {
+    //c1: zeta < 0, c2: g odd
+    c1 = (muBN_uword_t)(muBN_word_t)(zeta >> 31);
+    c2 = (muBN_uword_t)(0-(g&1));
+    //conditionaly negated f, u, v
+    x  = (muBN_uword_t)((f^c1)-c1);
+    y  = (muBN_uword_t)((u^c1)-c1);
+    z  = (muBN_uword_t)((v^c1)-c1);
+    g  = (muBN_uword_t)(g + (x&c2));
+    q  = (muBN_uword_t)(q + (y&c2));
+    r  = (muBN_uword_t)(r + (z&c2));
+    //swap case
+    c1 &= c2;
+    zeta = (zeta ^ (int32_t)(muBN_word_t)c1) - 1;
+    f  = (muBN_uword_t)(f + (g&c1));
+    u  = (muBN_uword_t)(u + (q&c1));
+    v  = (muBN_uword_t)(v + (r&c1));
+    g  = g>>1;
+    u  = (muBN_uword_t)(u<<1);
+    v  = (muBN_uword_t)(v<<1);
+  }
+  t->u = (muBN_word_t)u;
+  t->v = (muBN_word_t)v;
+  t->q = (muBN_word_t)q;
+  t->r = (muBN_word_t)r;
+  return zeta;
+}
+
+/* N divsteps on the low limbs of f and g, variable time, eta = -delta */
+static int32_t muBN_sgcd_divsteps_var(int32_t eta, muBN_uword_t f, muBN_uword_t g,
+                                       muBN_sgcd_mat_t *t) {
+  muBN_uword_t u, v, q, r, x;
+  muBN_size_t  i;
+
+  u = 1; v = 0;
+  q = 0; r = 1;
+  i = UBN_SGCD_N;
+  for (;;) {
+    while (i && !(g&1)) {
+      g = g>>1;
+      u = (muBN_uword_t)(u<<1);
+      v = (muBN_uword_t)(v<<1);
+      eta--;
+      i--;
+    }
+    if (i == 0) {
+      break;
+    }
+    if (eta < 0) {
+      eta = -eta;
+      x = f; f = g; g = (muBN_uword_t)(0-x);
+      x = u; u = q; q = (muBN_uword_t)(0-x);
+      x = v; v = r; r = (muBN_uword_t)(0-x);
+    }
+    g = (muBN_uword_t)(g+f);
+    q = (muBN_uword_t)(q+u);
+    r = (muBN_uword_t)(r+v);
+  }
+  t->u = (muBN_word_t)u;
+  t->v = (muBN_word_t)v;
+  t->q = (muBN_word_t)q;
+  t->r = (muBN_word_t)r;
+  return eta;
+}
+
+/* (f,g) = t.(f,g) / 2^N */
+static void muBN_sgcd_update_fg(muBN_word_t *f, muBN_word_t *g, muBN_size_t L,
+                                muBN_sgcd_mat_t *t) {
+  muBN_dword_t cf, cg;
+  muBN_size_t  i;
+
+  cf = (muBN_dword_t)t->u*f[0] + (muBN_dword_t)t->v*g[0];
+  cg = (muBN_dword_t)t->q*f[0] + (muBN_dword_t)t->r*g[0];
+  cf >>= UBN_SGCD_N;
+  cg >>= UBN_SGCD_N;
+  for (i = 1; i < L; i++) {
+    cf += (muBN_dword_t)t->u*f[i] + (muBN_dword_t)t->v*g[i];
+    cg += (muBN_dword_t)t->q*f[i] + (muBN_dword_t)t->r*g[i];
+    f[i-1] = (muBN_word_t)((muBN_uword_t)cf & UBN_SGCD_MASK);
+    g[i-1] = (muBN_word_t)((muBN_uword_t)cg & UBN_SGCD_MASK);
+    cf >>= UBN_SGCD_N;
+    cg >>= UBN_SGCD_N;
+  }
+  f[L-1] = (muBN_word_t)cf;
+  g[L-1] = (muBN_word_t)cg;
+}
+
+/* (d,e) = t.(d,e) / 2^N mod m, mi = m⁻¹ mod 2^N */
+static void muBN_sgcd_update_de(muBN_word_t *d, muBN_word_t *e, muBN_word_t *m,
+                                muBN_uword_t mi, muBN_size_t L, muBN_sgcd_mat_t *t) {
+  muBN_dword_t cd, ce;
+  muBN_word_t  sd, se, md, me;
+  muBN_size_t  i;
+
+  sd = (muBN_word_t)(d[L-1] >> (UBN_BITS_PER_WORD-1));
+  se = (muBN_word_t)(e[L-1] >> (UBN_BITS_PER_WORD-1));
+  md = (muBN_word_t)((t->u & sd) + (t->v & se));
+  me = (muBN_word_t)((t->q & sd) + (t->r & se));
+  cd = (muBN_dword_t)t->u*d[0] + (muBN_dword_t)t->v*e[0];
+  ce = (muBN_dword_t)t->q*d[0] + (muBN_dword_t)t->r*e[0];
+  //md, me: low limb of the results becomes zero
+  md = (muBN_word_t)(md - (muBN_word_t)((muBN_uword_t)((muBN_udword_t)mi*(muBN_uword_t)cd + (muBN_uword_t)md) & UBN_SGCD_MASK));
+  me = (muBN_word_t)(me - (muBN_word_t)((muBN_uword_t)((muBN_udword_t)mi*(muBN_uword_t)ce + (muBN_uword_t)me) & UBN_SGCD_MASK));
+  cd += (muBN_dword_t)m[0]*md;
+  ce += (muBN_dword_t)m[0]*me;
+  cd >>= UBN_SGCD_N;
+  ce >>= UBN_SGCD_N;
+  for (i = 1; i < L; i++) {
+    cd += (muBN_dword_t)t->u*d[i] + (muBN_dword_t)t->v*e[i] + (muBN_dword_t)m[i]*md;
+    ce += (muBN_dword_t)t->q*d[i] + (muBN_dword_t)t->r*e[i] + (muBN_dword_t)m[i]*me;
+    d[i-1] = (muBN_word_t)((muBN_uword_t)cd & UBN_SGCD_MASK);
+    e[i-1] = (muBN_word_t)((muBN_uword_t)ce & UBN_SGCD_MASK);
+    cd >>= UBN_SGCD_N;
+    ce >>= UBN_SGCD_N;
+  }
+  d[L-1] = (muBN_word_t)cd;
+  e[L-1] = (muBN_word_t)ce;
+}
+
+/* x = x + (m & mask), limbs normalized */
+static void muBN_sgcd_cadd(muBN_word_t *x, muBN_word_t *m, muBN_word_t mask, muBN_size_t L) {
+  muBN_dword_t c;
+  muBN_size_t  i;
+
+  c = 0;
+  for (i = 0; i < L-1; i++) {
+    c += (muBN_dword_t)x[i] + (m[i] & mask);
+    x[i] = (muBN_word_t)((muBN_uword_t)c & UBN_SGCD_MASK);
+    c >>= UBN_SGCD_N;
+  }
+  c += (muBN_dword_t)x[L-1] + (m[L-1] & mask);
+  x[L-1] = (muBN_word_t)c;
+}
+
+/* x = (x ^ mask) - mask, limbs normalized */
+static void muBN_sgcd_cneg(muBN_word_t *x, muBN_word_t mask, muBN_size_t L) {
+  muBN_dword_t c;
+  muBN_size_t  i;
+
+  c = 0;
+  for (i = 0; i < L-1; i++) {
+    c += (muBN_dword_t)(x[i] ^ mask) - mask;
+    x[i] = (muBN_word_t)((muBN_uword_t)c & UBN_SGCD_MASK);
+    c >>= UBN_SGCD_N;
+  }
+  c += (muBN_dword_t)(x[L-1] ^ mask) - mask;
+  x[L-1] = (muBN_word_t)c;
+}
+
+/* a >= 0 to L limbs */
+static void muBN_sgcd_load(muBN_word_t *x, muBN_size_t L, muBN_t *a) {
+  muBN_udword_t acc;
+  muBN_size_t   i, k, n;
+
+  acc = 0;
+  n   = 0;
+  k   = 0;
+  for (i = a->wlen-1; i >= 0; i--) {
+    acc |= (muBN_udword_t)a->v[i] << n;
+    n   += UBN_BITS_PER_WORD;
+    while ((n >= UBN_SGCD_N) && (k < L)) {
+      x[k++] = (muBN_word_t)((muBN_uword_t)acc & UBN_SGCD_MASK);
+      acc >>= UBN_SGCD_N;
+      n   -= UBN_SGCD_N;
+    }
+  }
+  while (k < L) {
+    x[k++] = (muBN_word_t)((muBN_uword_t)acc & UBN_SGCD_MASK);
+    acc >>= UBN_SGCD_N;
+  }
+}
+
+/* L limbs, normalized and >= 0, to r */
+static void muBN_sgcd_store(muBN_t *r, muBN_word_t *x, muBN_size_t L) {
+  muBN_udword_t acc;
+  muBN_size_t   i, k, n;
+
+  acc = 0;
+  n   = 0;
+  i   = r->wlen-1;
+  for (k = 0; k < L; k++) {
+    acc |= (muBN_udword_t)(muBN_uword_t)x[k] << n;
+    n   += UBN_SGCD_N;
+    while ((n >= (muBN_size_t)UBN_BITS_PER_WORD) && (i >= 0)) {
+      r->v[i--] = (muBN_uword_t)acc;
+      acc >>= UBN_BITS_PER_WORD;
+      n   -= UBN_BITS_PER_WORD;
+    }
+  }
+  while (i >= 0) {
+    r->v[i--] = (muBN_uword_t)acc;
+    acc >>= UBN_BITS_PER_WORD;
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+/* r = a⁻¹ mod m, sec selects the constant time divsteps and iteration count */
+static muBN_word_t muBN_mod_inv_sgcd(muBN_t *r, muBN_t *a, muBN_t *m,
+                                     muBN_uword_t *temp, muBN_word_t sec) {
+  muBN_word_t     *f, *g, *d, *e, *pm;
+  muBN_word_t      sf, ok;
+  int32_t          zeta;
+  muBN_uword_t     mi, x;
+  muBN_size_t      L, i;
+  uint32_t         bits, k, n;
+  muBN_sgcd_mat_t  t;
+
+  L  = (m->wlen*UBN_BITS_PER_WORD)/UBN_SGCD_N + 2;
+  f  = (muBN_word_t*)temp;
+  g  = f+L;
+  d  = g+L;
+  e  = d+L;
+  pm = e+L;
+  muBN_sgcd_load(pm, L, m);
+  muBN_sgcd_load(g,  L, a);
+  for (i = 0; i < L; i++) {
+    f[i] = pm[i];
+    d[i] = 0;
+    e[i] = 0;
+  }
+  e[0] = 1;
+
+  //mi = m⁻¹ mod 2^N
+  mi = 1;
+  for (i = 0; i<(muBN_size_t)(UBN_LOG2_BITS_PER_WORD); i++) {
+    x  = (muBN_uword_t)(2 - (muBN_uword_t)((muBN_udword_t)(muBN_uword_t)pm[0]*mi));
+    mi = (muBN_uword_t)((muBN_udword_t)mi*x);
+  }
+  mi &= UBN_SGCD_MASK;
+
+  //divsteps bound for f,g < 2^bits
+  bits = (uint32_t)muBN_count_bit(m);
+  bits = (bits < 46) ? (49*bits+57)/17 : (49*bits+80)/17;
+  n    = (bits+UBN_SGCD_N-1)/UBN_SGCD_N;
+
+  zeta = -1;
+  for (k = 0; k < n; k++) {
+    if (sec) {
+      zeta = muBN_sgcd_divsteps(zeta, (muBN_uword_t)f[0], (muBN_uword_t)g[0], &t);
+    } else {
+      for (i = 0; (i < L) && (!g[i]); i++);
+      if (i == L) {
+        break;
+      }
+      zeta = muBN_sgcd_divsteps_var(zeta, (muBN_uword_t)f[0], (muBN_uword_t)g[0], &t);
+    }
+    muBN_sgcd_update_fg(f, g, L, &t);
+    muBN_sgcd_update_de(d, e, pm, mi, L, &t);
+  }
+
+  //g = 0 and f = +/-1
+  sf = (muBN_word_t)(f[L-1] >> (UBN_BITS_PER_WORD-1));
+  ok = 0;
+  for (i = 0; i < L-1; i++) {
+    ok |= g[i];
+    ok |= f[i] ^ (((muBN_word_t)UBN_SGCD_MASK & sf) | ((i == 0) & ~sf));
+  }
+  ok |= g[L-1] | (f[L-1] ^ sf);
+
+  //d in (-2m, m) to [0, m), sign of f applied
+  muBN_sgcd_cadd(d, pm, (muBN_word_t)(d[L-1] >> (UBN_BITS_PER_WORD-1)), L);
+  muBN_sgcd_cneg(d, sf, L);
+  muBN_sgcd_cadd(d, pm, (muBN_word_t)(d[L-1] >> (UBN_BITS_PER_WORD-1)), L);
+  if (ok) {
+    muBN_zero(r);
+    return 0;
+  }
+  muBN_sgcd_store(r, d, L);
+  return 1;
+}
+
+muBN_word_t muBN_mod_inv_sec(muBN_t *r, muBN_t *a, muBN_t *m,  muBN_uword_t *temp) {
+  return muBN_mod_inv_sgcd(r, a, m, temp, 1);
+}
+
+muBN_word_t muBN_mod_inv_var(muBN_t *r, muBN_t *a, muBN_t *m,  muBN_uword_t *temp) {
+  return muBN_mod_inv_sgcd(r, a, m, temp, 0);
+}
+
 //r = a % m, 
-void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
+/* Knuth algorithm D, r = b % m and, if q is not NULL, q = b / m */
+static void muBN_div_internal(muBN_t *q, muBN_t *r,  muBN_t *b, muBN_t *m,
+                              muBN_uword_t  *tmp)  {
   //  int cnt;
 
   muBN_uword_t     *pa;
@@ -954,7 +1791,7 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
   muBN_uword_t      carry; 
   muBN_uword_t      qi;
   muBN_uword_t      mq0,mq1,mq2;  
-  muBN_uword_t      pm0,pm1;
+  muBN_uword_t      pm0,pm1,inv;
   muBN_uword_t      pa0,pa1, pa2;
 
   muBN_t            mod;
@@ -967,6 +1804,9 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
   //dup b to modify it
   muBN_init(&a, tmp+ m->wlen, b->wlen+2);
   muBN_copy(&a,b);
+  if (q) {
+    muBN_zero(q);
+  }
 
   //1. normalize
   // ->normalize n
@@ -981,7 +1821,7 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
   }
   mq0 = pm[0];
   shf = 0;
-  while (mq0 < (1UL<<(UBN_BITS_PER_WORD-1))) {
+  while (mq0 < UBN_WORD_HIGH_BIT) {
     mq0 = mq0<<1;
     shf++;
   }
@@ -998,6 +1838,10 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
     muBN_zero(r);
     return;
   }
+  if (n < t) {
+    //a < m
+    goto step4;
+  }
 
   //2. adjust first step
   qi = 0;
@@ -1013,7 +1857,10 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
       pa[i] = (muBN_word_t)sum;
       carry = (((muBN_uword_t)(sum>>UBN_BITS_PER_WORD))&UBN_WORD_HIGH_BIT) ? 1 : 0;
     }
-    
+    qi++;
+    if (q && (n-t < q->wlen)) {
+      q->v[q->wlen-1-(n-t)] = qi;
+    }
   }
 
   
@@ -1025,6 +1872,7 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
   } else {
     pm1 = pm[1]; 
   }
+  inv = muBN_reciprocal(pm0);
   
   for (i = n; i>=t+1; i--) {
     
@@ -1036,11 +1884,11 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
       pa2 = pa[2];
     }
     
-    //3.1
+    //3.1 pa0 <= pm0, no hardware division
     if (pa0 == pm0){
       qi = UBN_MAX_UWORD;
     } else {
-      qi = (((muBN_udword_t)pa0<< UBN_BITS_PER_WORD)+(muBN_udword_t)pa1)/pm0;
+      qi = muBN_div2by1(&mq0, pa0, pa1, pm0, inv);
     }
 
     //3.2 at most twice
@@ -1081,6 +1929,7 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
     
     //3.4     
     if (carry) {
+      qi--;
       carry = 0;
       for (j = t-1; j >= 0; j--) {
         muldw = pa[j+1];
@@ -1103,9 +1952,15 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
       sum = (muBN_udword_t)pa[0]+carry;
       pa[0] = (muBN_uword_t)muldw;
     }
+    if (q && (i-t-1 < q->wlen)) {
+      q->v[q->wlen-1-(i-t-1)] = qi;
+    }
     
     pa++;
   }
+
+  //4.
+ step4:
   muBN_urshift(&a, shf);
   muBN_urshift(m, shf);
   muBN_copy(r,&a);
@@ -1116,6 +1971,48 @@ void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
   */
 }
 
+void muBN_mod(muBN_t *r,  muBN_t *b, muBN_t *m, muBN_uword_t  *tmp)  {
+  muBN_div_internal(NULL, r, b, m, tmp);
+}
+
+void muBN_divrem(muBN_t *q, muBN_t *r,  muBN_t *a, muBN_t *m, muBN_uword_t  *tmp)  {
+  muBN_div_internal(q, r, a, m, tmp);
+}
+
+muBN_uword_t muBN_divrem_uword(muBN_t *q, muBN_t *a, muBN_uword_t d) {
+  muBN_uword_t  dn, inv, rem, u0, qk;
+  muBN_size_t   shf, k;
+
+  if (d == 0) {
+    return 0;
+  }
+  shf = 0;
+  dn  = d;
+  while (dn < UBN_WORD_HIGH_BIT) {
+    dn = dn<<1;
+    shf++;
+  }
+  inv = muBN_reciprocal(dn);
+
+  //divide a<<shf by d<<shf, the extra top word is below dn
+  rem = shf ? (muBN_uword_t)(a->v[0]>>(UBN_BITS_PER_WORD-shf)) : 0;
+  for (k = 0; k < a->wlen; k++) {
+    u0 = (muBN_uword_t)(a->v[k]<<shf);
+    if (shf && (k+1 < a->wlen)) {
+      u0 |= (muBN_uword_t)(a->v[k+1]>>(UBN_BITS_PER_WORD-shf));
+    }
+    qk = muBN_div2by1(&rem, rem, u0, dn, inv);
+    if (q) {
+      q->v[k] = qk;
+    }
+  }
+  if (q) {
+    q->C  = 0;
+    q->OV = 0;
+  }
+  return rem>>shf;
+}
+
 void muBN_mod_add_sec(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, muBN_uword_t  *temp) {
 
   muBN_size_t wlen;
@@ -1138,7 +2035,8 @@ void muBN_mod_add_sec(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, muBN_uword_t
     rsub.v[wlen] = add;
     csub = (add >> UBN_BITS_PER_WORD)?1:0;
   }  
-  if (csub) {
+  //a+b < m: no carry out of a+b and a borrow out of a+b-m
+  if (csub && !cadd) {
     muBN_copy(r,r);
   } else {
     muBN_copy(r,&rsub);
@@ -1176,7 +2074,7 @@ void muBN_mod_sub_sec(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, muBN_uword_t
 
 void muBN_mod_add(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m) {
   muBN_uword_t c = muBN_add(r,a,b);
-  if (c || muBN_ucmp(r,m)>0) {
+  if (c || muBN_ucmp(r,m)>=0) {
     muBN_sub(r,r,m);
   }
   
@@ -1190,9 +2088,9 @@ void muBN_mod_sub(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m) {
 
 void muBN_mod_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, muBN_uword_t  *temp) {
   muBN_t dr;
-  muBN_init(&dr, temp, m->wlen);
+  muBN_init(&dr, temp, m->wlen*2);
   muBN_mul(&dr,a,b);
-  muBN_mod(r,&dr,m,temp+m->wlen);   
+  muBN_mod(r,&dr,m,temp+m->wlen*2);   
 }
 
 
@@ -1213,10 +2111,11 @@ void muBN_mgt_mgt2z(muBN_t *r,  muBN_t *a, muBN_t *m, muBN_t *one, muBN_uword_t
 
 /* Compute 
  * j0 = -m mod 2^b, with b bitLength(muBN_uword_t)
- * j1 = R² mod m,   with R = 2^bitLength(m)
+ * j1 = R² mod m,   with R = 2^(b.wlen)
+ *
+ * j1 is computed without the general muBN_mod, see muBN_bpow_divrem
  */
 muBN_uword_t muBN_mgt_cst(muBN_t *m, muBN_t *j1, muBN_uword_t *temp) { 
-  muBN_t ubn_tmp;
   muBN_uword_t j0;
   muBN_uword_t a;
   muBN_size_t k;
@@ -1228,14 +2127,12 @@ muBN_uword_t muBN_mgt_cst(muBN_t *m, muBN_t *j1, muBN_uword_t *temp) {
   a =-(m->v[m->wlen-1]) % ((muBN_udword_t)UBN_MAX_UWORD+1);
   j0 = 1;
   for (k = 0; k<(muBN_size_t)(UBN_LOG2_BITS_PER_WORD); k++) {
-    j0 = j0*(2-a*j0);
+    j0 = (muBN_uword_t)((muBN_udword_t)j0*(muBN_uword_t)(2-(muBN_udword_t)a*j0));
   }
 
   // --- R² mod m ---
-  k =  m->wlen*2+1;
-  muBN_init_zero(&ubn_tmp, temp, k);
-  ubn_tmp.v[0] = 1;
-  muBN_mod(j1, &ubn_tmp, m, temp+k);
+  muBN_zero(j1);
+  muBN_bpow_divrem(j1, NULL, m, 2*m->wlen, temp);
 
   // return 
   return j0;
@@ -1259,10 +2156,15 @@ muBN_uword_t muBN_mgt_inv_internal(muBN_t *r, muBN_t *a, muBN_t *m,
 #define vv  (&ubn_v)
 
 
+  //0 has no inverse, and would never leave step1
+  if (muBN_is_zero(a)) {
+    return 0;
+  }
+
   //step1: r = a⁻¹.2^k, n <= k<= 2n
   muBN_init(uu, temp+m->wlen*0, m->wlen);
   muBN_init(vv, temp+m->wlen*1, m->wlen);
-  muBN_init(x2, temp+m->wlen*3, m->wlen);
+  muBN_init(x2, temp+m->wlen*2, m->wlen);
   
   //int c;
   muBN_copy(uu,a);
@@ -1343,9 +2245,272 @@ muBN_uword_t muBN_mgt_inv(muBN_t *r, muBN_t *a, muBN_t *m,
                           muBN_uword_t *temp) {
   return muBN_mgt_inv_internal(r,a,m,temp,1);
 }
+
+/* r = r - m if  rC:r >= m, else r is kept as is.
+ * Both branches do the same job to not leak the comparison result.
+ */
+static void muBN_mgt_final_sub(muBN_t *r, muBN_t *m, muBN_uword_t rC) {
+  muBN_udword_t carry;
+  muBN_uword_t  r0;
+  muBN_size_t   wlen;
+
+  wlen = m->wlen;
+  carry = 0;
+  if (rC | (muBN_ucmp(r,m)>=0)) {
+    while (wlen--) {
+      r0         = r->v[wlen];
+      carry        = (muBN_udword_t)(r->v[wlen])-(muBN_udword_t)(m->v[wlen])-carry;
+      r->v[wlen] = carry;
+      carry      = (carry >> UBN_BITS_PER_WORD)?1:0;
+    }
+  } else {
+    while (wlen--) {
+      r0         = r->v[wlen];
+      carry        = (muBN_udword_t)(r->v[wlen])-(muBN_udword_t)(m->v[wlen])-carry;
+      r->v[wlen] = r0;
+      carry      = (carry >> UBN_BITS_PER_WORD)?1:0;      
+    }
+  }
+}
                                           
 
-void muBN_mgt_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0) {
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+/* muBN_mgt_mul on the ADX kernels, product then reduction, r may be a or b.
+ * amm: no final subtraction, see muBN_amm_mul
+ */
+static void muBN_mgt_mul_adx(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0,
+                             muBN_uword_t amm) {
+  muBN_uword_t  t[2*UBN_ADX_MAX_WLEN];
+  muBN_uword_t  rC;
+  muBN_size_t   i, n;
+
+  n = m->wlen;
+  if (a == b) {
+    muBN_adx_sqr(t, a->v, n);
+  } else {
+    muBN_adx_mul(t, a->v, n, b->v, n);
+  }
+  rC = muBN_adx_redc(t, m->v, n, j0);
+  for (i = 0; i < n; i++) {
+    r->v[i] = t[i];
+  }
+  r->C  = 0;
+  r->OV = 0;
+  if (!amm) {
+    muBN_mgt_final_sub(r, m, rC);
+  }
+}
+#endif
+
+#if (defined(UBN_X86_AVX2) || defined(UBN_X86_IFMA)) && (UBN_BITS_PER_WORD == 64)
+#include <immintrin.h>
+
+/* a as L digits of bits bits, least significant first, to d[0], d[stride], ... */
+static void muBN_digits_load(uint64_t *d, muBN_size_t stride, muBN_size_t L, muBN_t *a,
+                             muBN_size_t bits) {
+  muBN_udword_t acc;
+  muBN_size_t   i, k, nb;
+
+  acc = 0;
+  nb  = 0;
+  k   = a->wlen;
+  for (i = 0; i < L; i++) {
+    if (nb < bits) {
+      if (k) {
+        acc |= (muBN_udword_t)a->v[--k] << nb;
+      }
+      nb += 64;
+    }
+    d[i*stride] = (uint64_t)acc & ((((uint64_t)1)<<bits)-1);
+    acc >>= bits;
+    nb   -= bits;
+  }
+}
+
+/* r = (normalized digits d[0], d[stride], ...) >> shift, minus m if needed */
+static void muBN_digits_store(muBN_t *r, muBN_t *m, uint64_t *d, muBN_size_t stride, muBN_size_t L,
+                              muBN_size_t bits, muBN_size_t shift) {
+  muBN_udword_t acc;
+  muBN_uword_t  rC;
+  muBN_size_t   i, k, nb;
+
+  acc = d[0] >> shift;
+  nb  = bits-shift;
+  rC  = 0;
+  k   = r->wlen;
+  for (i = 1; i < L; i++) {
+    acc |= (muBN_udword_t)d[i*stride] << nb;
+    nb  += bits;
+    if (nb >= 64) {
+      if (k) {
+        r->v[--k] = (muBN_uword_t)acc;
+      } else {
+        rC |= (muBN_uword_t)acc;
+      }
+      acc >>= 64;
+      nb   -= 64;
+    }
+  }
+  while (k) {
+    r->v[--k] = (muBN_uword_t)acc;
+    acc >>= 64;
+  }
+  rC |= (muBN_uword_t)acc;
+  r->C  = 0;
+  r->OV = 0;
+  muBN_mgt_final_sub(r, m, rC);
+}
+#endif
+
+/* ---------------------------------------------------------------------------------------
+ * AVX-512 IFMA Montgomery product.
+ *
+ * Operands as L digits of 52 bits, least significant first, 8 digits per 512 bits
+ * register. vpmadd52luq/vpmadd52huq give the low and high halves of the digit
+ * products, the high halves go one digit up, which is where T is once shifted down
+ * by the reduction step. The D = 64*wlen bits reduction is made of D/52 full steps,
+ * on unnormalized digits (4 halves of 52 bits per step, far from 64 bits), and of a
+ * last D%52 bits step run in scalar, so that R is the same as for the portable code.
+ * --------------------------------------------------------------------------------------- */
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+
+#define UBN_F52_BITS        52
+#define UBN_F52_MASK        ((((uint64_t)1)<<UBN_F52_BITS)-1)
+/* from 8 words for exponentiation, 16 words for a single product */
+#define UBN_F52_EXP_WLEN    8
+#define UBN_F52_MUL_WLEN    16
+#define UBN_F52_MAX_WLEN    64
+#define UBN_F52_MAX_DIGITS  (((UBN_F52_MAX_WLEN*64)/UBN_F52_BITS+2+7)&~7)
+
+static int muBN_f52_use(muBN_size_t wlen, muBN_size_t min) {
+  return (wlen >= min) && (wlen <= UBN_F52_MAX_WLEN) &&
+    muBN_cpu_has(UBN_CPU_IFMA);
+}
+
+/* T = (A*B + U*M)/2^(52q), n8*8 unnormalized digits. The digit 0 is computed in
+ * scalar, to keep the u dependency chain short.
+ */
+__attribute__((target("avx512f,avx512ifma"), always_inline))
+static inline void muBN_f52_mont(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t mp,
+                                 muBN_size_t n8, muBN_size_t q) {
+  __m512i      t[UBN_F52_MAX_DIGITS/8], b[UBN_F52_MAX_DIGITS/8], m[UBN_F52_MAX_DIGITS/8];
+  __m512i      ai, u, zero;
+  uint64_t     t0, s;
+  muBN_size_t  i, j;
+
+  zero = _mm512_setzero_si512();
+  for (j = 0; j < n8; j++) {
+    t[j] = zero;
+    b[j] = _mm512_loadu_si512(B+j*8);
+    m[j] = _mm512_loadu_si512(M+j*8);
+  }
+  for (i = 0; i < q; i++) {
+    //u = (T0+ai*B0).m' mod 2^52, c = (T0+ai*B0+u*M0) / 2^52
+    t0 = (uint64_t)_mm_cvtsi128_si64(_mm512_castsi512_si128(t[0]));
+    s  = t0 + ((A[i]*B[0]) & UBN_F52_MASK);
+    t0 = (s*mp) & UBN_F52_MASK;
+    s  = (s + ((t0*M[0]) & UBN_F52_MASK)) >> UBN_F52_BITS;
+    ai = _mm512_set1_epi64((long long)A[i]);
+    u  = _mm512_set1_epi64((long long)t0);
+    for (j = 0; j < n8; j++) {
+      t[j] = _mm512_madd52lo_epu64(t[j], ai, b[j]);
+      t[j] = _mm512_madd52lo_epu64(t[j], u,  m[j]);
+    }
+    //T = T/2^52 + c, then the high halves
+    for (j = 0; j < n8-1; j++) {
+      t[j] = _mm512_alignr_epi64(t[j+1], t[j], 1);
+    }
+    t[j] = _mm512_alignr_epi64(zero, t[j], 1);
+    t[0] = _mm512_mask_add_epi64(t[0], 1, t[0], _mm512_set1_epi64((long long)s));
+    for (j = 0; j < n8; j++) {
+      t[j] = _mm512_madd52hi_epu64(t[j], ai, b[j]);
+      t[j] = _mm512_madd52hi_epu64(t[j], u,  m[j]);
+    }
+  }
+  for (j = 0; j < n8; j++) {
+    _mm512_storeu_si512(T+j*8, t[j]);
+  }
+}
+
+/* one instance per register count, so that T, B and M stay in registers */
+#define UBN_F52_MONT(n)                                                                 \
+__attribute__((target("avx512f,avx512ifma")))                                           \
+static void muBN_f52_mont_##n(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M,        \
+                              uint64_t mp, muBN_size_t q) {                             \
+  muBN_f52_mont(T, A, B, M, mp, n, q);                                                  \
+}
+UBN_F52_MONT(2)
+UBN_F52_MONT(3)
+UBN_F52_MONT(4)
+UBN_F52_MONT(5)
+UBN_F52_MONT(6)
+UBN_F52_MONT(7)
+UBN_F52_MONT(8)
+UBN_F52_MONT(9)
+UBN_F52_MONT(10)
+
+static void muBN_f52_mont_n(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t mp,
+                            muBN_size_t n8, muBN_size_t q) {
+  switch (n8) {
+  case 2:  muBN_f52_mont_2 (T, A, B, M, mp, q); break;
+  case 3:  muBN_f52_mont_3 (T, A, B, M, mp, q); break;
+  case 4:  muBN_f52_mont_4 (T, A, B, M, mp, q); break;
+  case 5:  muBN_f52_mont_5 (T, A, B, M, mp, q); break;
+  case 6:  muBN_f52_mont_6 (T, A, B, M, mp, q); break;
+  case 7:  muBN_f52_mont_7 (T, A, B, M, mp, q); break;
+  case 8:  muBN_f52_mont_8 (T, A, B, M, mp, q); break;
+  case 9:  muBN_f52_mont_9 (T, A, B, M, mp, q); break;
+  default: muBN_f52_mont_10(T, A, B, M, mp, q); break;
+  }
+}
+
+/* normalize the L digits of T, with the last k bits step if k is not 0,
+ * the result is T >> k, with L+1 digits.
+ */
+static void muBN_f52_last(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t mp,
+                          muBN_size_t L, muBN_size_t q, muBN_size_t k) {
+  muBN_udword_t p;
+  uint64_t      c, u, a;
+  muBN_size_t   j;
+
+  a = 0;
+  u = 0;
+  if (k) {
+    a = A[q];
+    u = ((T[0] + a*B[0])*mp) & ((((uint64_t)1)<<k)-1);
+  }
+  c = 0;
+  for (j = 0; j < L; j++) {
+    p    = (muBN_udword_t)a*B[j] + (muBN_udword_t)u*M[j] + T[j] + c;
+    T[j] = (uint64_t)p & UBN_F52_MASK;
+    c    = (uint64_t)(p >> UBN_F52_BITS);
+  }
+  T[L] = c;
+}
+
+/* same as muBN_mgt_mul, r may be a or b */
+static void muBN_mgt_mul_f52(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0) {
+  uint64_t     A[UBN_F52_MAX_DIGITS], B[UBN_F52_MAX_DIGITS];
+  uint64_t     M[UBN_F52_MAX_DIGITS], T[UBN_F52_MAX_DIGITS];
+  muBN_size_t  L, q, k, n8;
+
+  k  = m->wlen*64;
+  L  = (k+UBN_F52_BITS-1)/UBN_F52_BITS;
+  q  = k/UBN_F52_BITS;
+  k  = k-q*UBN_F52_BITS;
+  n8 = (L+7)/8;
+  muBN_digits_load(A, 1, n8*8, a, UBN_F52_BITS);
+  muBN_digits_load(B, 1, n8*8, b, UBN_F52_BITS);
+  muBN_digits_load(M, 1, n8*8, m, UBN_F52_BITS);
+  muBN_f52_mont_n(T, A, B, M, j0, n8, q);
+  muBN_f52_last(T, A, B, M, j0, L, q, k);
+  muBN_digits_store(r, m, T, 1, L+1, UBN_F52_BITS, k);
+}
+#endif
+
+/* CIOS Montgomery product, amm: no final subtraction, see muBN_amm_mul */
+static void muBN_mgt_mul_internal(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0,
+                                  muBN_uword_t amm) {
   /*                    a          x         y         m */
   muBN_udword_t dwRk, dwSk, dwTk;
   
@@ -1354,6 +2519,12 @@ void muBN_mgt_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0)
   muBN_size_t   wlen;
   muBN_size_t   i,j;
   
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if ((m->wlen <= UBN_ADX_MAX_WLEN) && muBN_adx_use()) {
+    muBN_mgt_mul_adx(r, a, b, m, j0, amm);
+    return;
+  }
+#endif
   r0C = 0;
   wlen = m->wlen;
   b0 = b->v[wlen-1]; 
@@ -1364,7 +2535,7 @@ void muBN_mgt_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0)
     //2. ui = (r0+ai*b0)*j0
     ai = a->v[i];
     r0 = r->v[j];
-    ui = ((r0 + ai*b0)*j0);
+    ui = (muBN_uword_t)(((muBN_udword_t)r0 + (muBN_udword_t)ai*b0)*j0);
     //3. r = (r + ai*b + ui*m) / base
     // unroll first loop, and discard LSB word, only keep carry
     dwSk = (muBN_udword_t)ui*m->v[j];
@@ -1394,22 +2565,367 @@ void muBN_mgt_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0)
     r0C = dwRk>>UBN_BITS_PER_WORD;
   }
 
+  if (!amm) {
+    muBN_mgt_final_sub(r, m, r0C);
+  }
+}
+
+void muBN_mgt_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0) {
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_f52_use(m->wlen, UBN_F52_MUL_WLEN)) {
+    muBN_mgt_mul_f52(r, a, b, m, j0);
+    return;
+  }
+#endif
+  muBN_mgt_mul_internal(r, a, b, m, j0, 0);
+}
+
+void muBN_amm_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t j0) {
+  muBN_mgt_mul_internal(r, a, b, m, j0, 1);
+}
+
+/* t = a², t of 2*a.wlen words, t[0] is the most significant word */
+static void muBN_sqr_words(muBN_uword_t *t, muBN_t *a) {
+  muBN_udword_t uv;
+  muBN_uword_t  carry;
+  muBN_uword_t  ai, ui;
+  muBN_size_t   wlen;
+  muBN_size_t   i,j,k;
+
+  wlen = a->wlen;
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_adx_use()) {
+    muBN_adx_sqr(t, a->v, wlen);
+    return;
+  }
+#endif
+  k    = 2*wlen;
+  while (k--) {
+    t[k] = 0;
+  }
+
+  //1. off-diagonal products, each one computed once
+  for (i = wlen-1; i>0; i--) {
+    ai = a->v[i];
+    carry = 0;
+    for (j = i-1; j >=0; j--) {
+      uv = (muBN_udword_t)t[i+j+1] + (muBN_udword_t)ai*a->v[j] + carry;
+      t[i+j+1] = (muBN_uword_t)uv;
+      carry = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    }
+    t[i] = carry;
+  }
+
+  //2. double them and add the diagonal
   carry = 0;
-  if (r0C | (muBN_ucmp(r,m)>0)) {
-    while (wlen--) {
-      r0         = r->v[wlen];
-      carry        = (muBN_udword_t)(r->v[wlen])-(muBN_udword_t)(m->v[wlen])-carry;
-      r->v[wlen] = carry;
-      carry      = (carry >> UBN_BITS_PER_WORD)?1:0;
+  for (k = 2*wlen-1; k>=0; k--) {
+    ai = t[k];
+    t[k] = (ai<<1)|carry;
+    carry = ai>>(UBN_BITS_PER_WORD-1);
+  }
+  carry = 0;
+  for (i = wlen-1; i>=0; i--) {
+    ai = a->v[i];
+    uv = (muBN_udword_t)ai*ai;
+    ui = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    uv = (muBN_udword_t)t[2*i+1] + (muBN_uword_t)uv + carry;
+    t[2*i+1] = (muBN_uword_t)uv;
+    uv = (muBN_udword_t)t[2*i] + ui + (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    t[2*i] = (muBN_uword_t)uv;
+    carry = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+  }
+}
+
+/* t = t.R⁻¹, t of 2*wlen words, one word per step from the least significant one.
+ * The result is in t[0..wlen-1], its carry is returned.
+ */
+static muBN_uword_t muBN_mgt_redc_words(muBN_uword_t *t, muBN_t *m,  muBN_uword_t j0) {
+  muBN_udword_t uv;
+  muBN_uword_t  carry, topC, ui;
+  muBN_size_t   wlen;
+  muBN_size_t   j,k;
+
+  wlen = m->wlen;
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_adx_use()) {
+    return muBN_adx_redc(t, m->v, wlen, j0);
+  }
+#endif
+  topC = 0;
+  for (k = 2*wlen-1; k>=wlen; k--) {
+    ui = (muBN_uword_t)((muBN_udword_t)t[k]*j0);
+    carry = 0;
+    for (j = wlen-1; j >=0; j--) {
+      uv = (muBN_udword_t)t[k-(wlen-1)+j] + (muBN_udword_t)ui*m->v[j] + carry;
+      t[k-(wlen-1)+j] = (muBN_uword_t)uv;
+      carry = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
     }
-  } else {
-    while (wlen--) {
-      r0         = r->v[wlen];
-      carry        = (muBN_udword_t)(r->v[wlen])-(muBN_udword_t)(m->v[wlen])-carry;
-      r->v[wlen] = r0;
-      carry      = (carry >> UBN_BITS_PER_WORD)?1:0;      
+    uv = (muBN_udword_t)t[k-wlen] + carry + topC;
+    t[k-wlen] = (muBN_uword_t)uv;
+    topC = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+  }
+  return topC;
+}
+
+void muBN_mgt_redc(muBN_t *r,  muBN_t *t, muBN_t *m,  muBN_uword_t j0) {
+  muBN_uword_t  topC;
+  muBN_size_t   i;
+
+  topC = muBN_mgt_redc_words(t->v, m, j0);
+  for (i = 0; i<m->wlen; i++) {
+    r->v[i] = t->v[i];
+  }
+  r->C  = 0;
+  r->OV = 0;
+  muBN_mgt_final_sub(r, m, topC);
+}
+
+/* Montgomery square, amm: no final subtraction, see muBN_amm_sqr */
+static void muBN_mgt_sqr_internal(muBN_t *r,  muBN_t *a, muBN_t *m,  muBN_uword_t j0,
+                                  muBN_uword_t *temp, muBN_uword_t amm) {
+  muBN_uword_t  topC;
+  muBN_uword_t  *t;
+  muBN_size_t   wlen;
+  muBN_size_t   i;
+
+#if defined(UBN_X86_ADX) && (UBN_BITS_PER_WORD == 64)
+  if ((m->wlen <= UBN_ADX_MAX_WLEN) && muBN_adx_use()) {
+    muBN_mgt_mul_adx(r, a, a, m, j0, amm);
+    return;
+  }
+#endif
+  wlen = m->wlen;
+  t    = temp;
+  muBN_sqr_words(t, a);
+
+  //3. reduction
+  topC = muBN_mgt_redc_words(t, m, j0);
+
+  for (i = 0; i<wlen; i++) {
+    r->v[i] = t[i];
+  }
+  r->C  = 0;
+  r->OV = 0;
+  if (!amm) {
+    muBN_mgt_final_sub(r, m, topC);
+  }
+}
+
+void muBN_mgt_sqr(muBN_t *r,  muBN_t *a, muBN_t *m,  muBN_uword_t j0, muBN_uword_t *temp) {
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_f52_use(m->wlen, UBN_F52_MUL_WLEN)) {
+    muBN_mgt_mul_f52(r, a, a, m, j0);
+    return;
+  }
+#endif
+  muBN_mgt_sqr_internal(r, a, m, j0, temp, 0);
+}
+
+void muBN_amm_sqr(muBN_t *r,  muBN_t *a, muBN_t *m,  muBN_uword_t j0, muBN_uword_t *temp) {
+  muBN_mgt_sqr_internal(r, a, m, j0, temp, 1);
+}
+
+/* ---------------------------------------------------------------------------------------
+ * Multi-lane Montgomery product.
+ *
+ * Each lane holds one product, in L digits of 29 bits, least significant digit first,
+ * digit d of lane l of group g at [(d*G+g)*4+l]. With 29 bits digits, 2 products per
+ * step fit 16 steps in a 64 bits lane before the digits need to be normalized.
+ * The D = 64*wlen bits Montgomery reduction is done by D/29 full steps plus one last
+ * step of D%29 bits, so that R is the same as for muBN_mgt_mul.
+ * --------------------------------------------------------------------------------------- */
+#if defined(UBN_X86_AVX2) && (UBN_BITS_PER_WORD == 64)
+
+#define UBN_V29_BITS  29
+#define UBN_V29_MASK  ((((uint64_t)1)<<UBN_V29_BITS)-1)
+/* below 8 words, the scalar muBN_mgt_mul is faster */
+#define UBN_V29_MIN_WLEN  8
+
+__attribute__((target("avx2"), always_inline))
+static inline void muBN_v29_norm(uint64_t *T, muBN_size_t L, muBN_size_t G) {
+  __m256i     x, c[2], mask;
+  muBN_size_t d, g;
+
+  mask = _mm256_set1_epi64x(UBN_V29_MASK);
+  for (g = 0; g < G; g++) {
+    c[g] = _mm256_setzero_si256();
+  }
+  for (d = 0; d < L-1; d++) {
+    for (g = 0; g < G; g++) {
+      x    = _mm256_add_epi64(_mm256_load_si256((__m256i*)(T+(d*G+g)*4)), c[g]);
+      c[g] = _mm256_srli_epi64(x, UBN_V29_BITS);
+      _mm256_store_si256((__m256i*)(T+(d*G+g)*4), _mm256_and_si256(x, mask));
     }
   }
+  for (g = 0; g < G; g++) {
+    x = _mm256_add_epi64(_mm256_load_si256((__m256i*)(T+(d*G+g)*4)), c[g]);
+    _mm256_store_si256((__m256i*)(T+(d*G+g)*4), x);
+  }
+}
+
+/* T = A*B + U*M, with a first reduction of q steps of 29 bits and a last one of k bits */
+__attribute__((target("avx2"), always_inline))
+static inline void muBN_v29_mont(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t *mp,
+                                 muBN_size_t L, muBN_size_t q, muBN_size_t k, muBN_size_t G) {
+  __m256i     ai[2], u[2], x, mask;
+  muBN_size_t i, d, g;
+
+  mask = _mm256_set1_epi64x(UBN_V29_MASK);
+  for (d = 0; d < L*G*4; d++) {
+    T[d] = 0;
+  }
+
+  for (i = 0; i < q; i++) {
+    //u = (T0+ai*B0).m' mod 2^29, T = (T + ai*B + u*M)/2^29
+    for (g = 0; g < G; g++) {
+      ai[g] = _mm256_load_si256((__m256i*)(A+(i*G+g)*4));
+      x     = _mm256_add_epi64(_mm256_load_si256((__m256i*)(T+g*4)),
+                               _mm256_mul_epu32(ai[g], _mm256_load_si256((__m256i*)(B+g*4))));
+      u[g]  = _mm256_and_si256(_mm256_mul_epu32(x, _mm256_load_si256((__m256i*)(mp+g*4))), mask);
+      x     = _mm256_add_epi64(x, _mm256_mul_epu32(u[g], _mm256_load_si256((__m256i*)(M+g*4))));
+      x     = _mm256_add_epi64(_mm256_load_si256((__m256i*)(T+(G+g)*4)),
+                               _mm256_srli_epi64(x, UBN_V29_BITS));
+      _mm256_store_si256((__m256i*)(T+(G+g)*4), x);
+    }
+    //groups written out, so that both stay in registers when G is 2
+    for (d = 1; d < L; d++) {
+      x = _mm256_load_si256((__m256i*)(T+(d*G)*4));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(ai[0], _mm256_load_si256((__m256i*)(B+(d*G)*4))));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(u[0],  _mm256_load_si256((__m256i*)(M+(d*G)*4))));
+      _mm256_store_si256((__m256i*)(T+((d-1)*G)*4), x);
+      if (G == 2) {
+        x = _mm256_load_si256((__m256i*)(T+(d*G+1)*4));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(ai[1], _mm256_load_si256((__m256i*)(B+(d*G+1)*4))));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(u[1],  _mm256_load_si256((__m256i*)(M+(d*G+1)*4))));
+        _mm256_store_si256((__m256i*)(T+((d-1)*G+1)*4), x);
+      }
+    }
+    for (g = 0; g < G; g++) {
+      _mm256_store_si256((__m256i*)(T+((L-1)*G+g)*4), _mm256_setzero_si256());
+    }
+    if ((i&15) == 15) {
+      muBN_v29_norm(T, L, G);
+    }
+  }
+  muBN_v29_norm(T, L, G);
+
+  if (k) {
+    //last digit of A, then a k bits reduction step
+    __m256i kmask;
+    __m128i sr, sl;
+    kmask = _mm256_set1_epi64x((((uint64_t)1)<<k)-1);
+    sr    = _mm_cvtsi32_si128(k);
+    sl    = _mm_cvtsi32_si128(UBN_V29_BITS-k);
+    for (g = 0; g < G; g++) {
+      ai[g] = _mm256_load_si256((__m256i*)(A+(q*G+g)*4));
+      for (d = 0; d < L; d++) {
+        x = _mm256_load_si256((__m256i*)(T+(d*G+g)*4));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(ai[g], _mm256_load_si256((__m256i*)(B+(d*G+g)*4))));
+        _mm256_store_si256((__m256i*)(T+(d*G+g)*4), x);
+      }
+    }
+    muBN_v29_norm(T, L, G);
+    for (g = 0; g < G; g++) {
+      x    = _mm256_load_si256((__m256i*)(T+g*4));
+      u[g] = _mm256_and_si256(_mm256_mul_epu32(x, _mm256_load_si256((__m256i*)(mp+g*4))), kmask);
+      for (d = 0; d < L; d++) {
+        x = _mm256_load_si256((__m256i*)(T+(d*G+g)*4));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(u[g], _mm256_load_si256((__m256i*)(M+(d*G+g)*4))));
+        _mm256_store_si256((__m256i*)(T+(d*G+g)*4), x);
+      }
+    }
+    muBN_v29_norm(T, L, G);
+    for (g = 0; g < G; g++) {
+      for (d = 0; d < L-1; d++) {
+        x = _mm256_srl_epi64(_mm256_load_si256((__m256i*)(T+(d*G+g)*4)), sr);
+        x = _mm256_or_si256(x, _mm256_and_si256(mask,
+                _mm256_sll_epi64(_mm256_load_si256((__m256i*)(T+((d+1)*G+g)*4)), sl)));
+        _mm256_store_si256((__m256i*)(T+(d*G+g)*4), x);
+      }
+      x = _mm256_srl_epi64(_mm256_load_si256((__m256i*)(T+(d*G+g)*4)), sr);
+      _mm256_store_si256((__m256i*)(T+(d*G+g)*4), x);
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+static void muBN_v29_mont_x4(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t *mp,
+                             muBN_size_t L, muBN_size_t q, muBN_size_t k) {
+  muBN_v29_mont(T, A, B, M, mp, L, q, k, 1);
+}
+
+__attribute__((target("avx2")))
+static void muBN_v29_mont_x8(uint64_t *T, uint64_t *A, uint64_t *B, uint64_t *M, uint64_t *mp,
+                             muBN_size_t L, muBN_size_t q, muBN_size_t k) {
+  muBN_v29_mont(T, A, B, M, mp, L, q, k, 2);
+}
+
+static void muBN_mgt_mul_v29(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t *j0,
+                             muBN_uword_t *temp, muBN_size_t G) {
+  uint64_t    *A, *B, *M, *T, *mp;
+  muBN_size_t  L, q, k, n, o;
+
+  n = m->wlen*64;
+  L = (n+UBN_V29_BITS-1)/UBN_V29_BITS;
+  q = n/UBN_V29_BITS;
+  k = n-q*UBN_V29_BITS;
+
+  A  = (uint64_t*)(((uintptr_t)temp+31) & ~(uintptr_t)31);
+  B  = A+L*G*4;
+  M  = B+L*G*4;
+  T  = M+L*G*4;
+  mp = T+L*G*4;
+  for (n = 0; n < G*4; n++) {
+    o = (n>>2)*4+(n&3);
+    muBN_digits_load(A+o, G*4, L, &a[n], UBN_V29_BITS);
+    muBN_digits_load(B+o, G*4, L, &b[n], UBN_V29_BITS);
+    muBN_digits_load(M+o, G*4, L, &m[n], UBN_V29_BITS);
+    mp[o] = j0[n] & UBN_V29_MASK;
+  }
+  if (G == 1) {
+    muBN_v29_mont_x4(T, A, B, M, mp, L, q, k);
+  } else {
+    muBN_v29_mont_x8(T, A, B, M, mp, L, q, k);
+  }
+  for (n = 0; n < G*4; n++) {
+    o = (n>>2)*4+(n&3);
+    muBN_digits_store(&r[n], &m[n], T+o, G*4, L, UBN_V29_BITS, 0);
+  }
+}
+#endif
+
+void muBN_mgt_mul_x4(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t *j0,
+                     muBN_uword_t *temp) {
+  muBN_size_t i;
+
+#if defined(UBN_X86_AVX2) && (UBN_BITS_PER_WORD == 64)
+  if ((m->wlen >= UBN_V29_MIN_WLEN) && muBN_cpu_has(UBN_CPU_AVX2)) {
+    muBN_mgt_mul_v29(r, a, b, m, j0, temp, 1);
+    return;
+  }
+#else
+  (void)temp;
+#endif
+  for (i = 0; i < 4; i++) {
+    muBN_mgt_mul(&r[i], &a[i], &b[i], &m[i], j0[i]);
+  }
+}
+
+void muBN_mgt_mul_x8(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t *j0,
+                     muBN_uword_t *temp) {
+  muBN_size_t i;
+
+#if defined(UBN_X86_AVX2) && (UBN_BITS_PER_WORD == 64)
+  if ((m->wlen >= UBN_V29_MIN_WLEN) && muBN_cpu_has(UBN_CPU_AVX2)) {
+    muBN_mgt_mul_v29(r, a, b, m, j0, temp, 2);
+    return;
+  }
+#else
+  (void)temp;
+#endif
+  for (i = 0; i < 8; i++) {
+    muBN_mgt_mul(&r[i], &a[i], &b[i], &m[i], j0[i]);
+  }
 }
 
 
@@ -1420,3 +2936,1262 @@ void muBN_mgt_zmul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,
   muBN_mgt_mul(&t,  j1, a, m, j0);
   muBN_mgt_mul(r,   &t, b, m, j0);
 }
+
+
+/* Window width for an exponent of 'bits' bits */
+static muBN_size_t muBN_mgt_exp_window(muBN_size_t bits) {
+  muBN_size_t w;
+  if      (bits > 671) w = 6;
+  else if (bits > 239) w = 5;
+  else if (bits >  79) w = 4;
+  else if (bits >  23) w = 3;
+  else                 w = 1;
+  return (w > UBN_EXP_WINDOW_MAX) ? UBN_EXP_WINDOW_MAX : w;
+}
+
+/* Read the 'k' bits of 'e' starting at bit 'pos' */
+static muBN_uword_t muBN_mgt_exp_bits(muBN_t *e, muBN_size_t pos, muBN_size_t k) {
+  muBN_uword_t d;
+  d = 0;
+  while (k--) {
+    d = (d<<1) | muBN_test_bit(e, pos+k);
+  }
+  return d;
+}
+
+/* r = tab[idx], reading all entries */
+static void muBN_mgt_exp_lookup(muBN_t *r, muBN_uword_t *tab, muBN_uword_t n,
+                                muBN_uword_t idx) {
+  muBN_size_t   wlen;
+  muBN_uword_t  i, d, mask;
+  muBN_size_t   j;
+
+  wlen = r->wlen;
+  for (j = 0; j<wlen; j++) {
+    r->v[j] = 0;
+  }
+  for (i = 0; i<n; i++) {
+    d    = i^idx;
+    mask = ((muBN_uword_t)(d|(0-d))>>(UBN_BITS_PER_WORD-1));
+    mask = mask - 1;
+    for (j = 0; j<wlen; j++) {
+      r->v[j] |= tab[j] & mask;
+    }
+    tab += wlen;
+  }
+}
+
+/* r = Mont(1) = R mod m, from 'mone' if given, else from j1, 'tmp' is
+ * a wlen scratch number distinct from 'r'
+ */
+static void muBN_mgt_exp_one(muBN_t *r, muBN_t *m, muBN_uword_t j0,
+                             muBN_t *j1, muBN_t *mone, muBN_t *tmp) {
+  if (mone) {
+    muBN_copy(r, mone);
+  } else {
+    muBN_one(tmp);
+    muBN_mgt_mul(r, j1, tmp, m, j0);
+  }
+}
+
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+/* Fixed window exponentiation on IFMA products, for both muBN_mgt_exp_fast and
+ * muBN_mgt_exp_secure. The accumulator stays in 52 bits digits, in the
+ * R' = 2^(52n) domain, 52n >= D+2, where the products are only kept below 2m.
+ * Table entries are reduced and stored as words, in the usual table space.
+ */
+static void muBN_mgt_exp_f52(muBN_t *r, muBN_t *a, muBN_t *e, muBN_t *m,
+                             muBN_uword_t j0, muBN_t *j1, muBN_t *mone,
+                             muBN_uword_t *temp, muBN_word_t sec) {
+  uint64_t      X[UBN_F52_MAX_DIGITS], Y[UBN_F52_MAX_DIGITS];
+  uint64_t      C[UBN_F52_MAX_DIGITS], M[UBN_F52_MAX_DIGITS];
+  uint64_t      *P, *Q, *W;
+  muBN_t        g, t;
+  muBN_uword_t  *tab;
+  muBN_size_t   wlen, n, n8, s;
+  muBN_size_t   nbits, w, i, k;
+  muBN_uword_t  d;
+
+  wlen = m->wlen;
+  n    = (wlen*64+2+UBN_F52_BITS-1)/UBN_F52_BITS;
+  n8   = (n+7)/8;
+  s    = n*UBN_F52_BITS-wlen*64;
+  muBN_init(&g, temp,      wlen);
+  muBN_init(&t, temp+wlen, wlen);
+  tab  = temp+wlen*4;
+
+  nbits = sec ? e->wlen*(muBN_size_t)UBN_BITS_PER_WORD : muBN_count_bit(e);
+  if (nbits == 0) {
+    muBN_mgt_exp_one(r, m, j0, j1, mone, &g);
+    return;
+  }
+  w = muBN_mgt_exp_window(nbits);
+
+  //1. tab[0] = R' = R.2^s, C = R'²/R = R.2^(2s), X = a.R/R, tab[k] = a^k
+  muBN_digits_load(M, 1, n8*8, m, UBN_F52_BITS);
+  muBN_digits_load(X, 1, n8*8, a, UBN_F52_BITS);
+  muBN_mgt_exp_one(&g, m, j0, j1, mone, &t);
+  for (i = 0; i < s; i++) {
+    muBN_mod_add(&g, &g, &g, m);
+  }
+  muBN_init(&t, tab, wlen);
+  muBN_copy(&t, &g);
+  for (i = 0; i < s; i++) {
+    muBN_mod_add(&g, &g, &g, m);
+  }
+  muBN_digits_load(C, 1, n8*8, &g, UBN_F52_BITS);
+  muBN_f52_mont_n(Y, X, C, M, j0, n8, n);
+  muBN_f52_last(Y, X, C, M, j0, n, n, 0);
+  for (k = 0; k < n8*8; k++) {
+    C[k] = Y[k];
+  }
+  for (k = 1; k < (1<<w); k++) {
+    if (k > 1) {
+      muBN_init(&t, tab+((k&1) ? k-1 : k>>1)*wlen, wlen);
+      muBN_digits_load(X, 1, n8*8, &t, UBN_F52_BITS);
+      muBN_f52_mont_n(Y, X, (k&1) ? C : X, M, j0, n8, n);
+      muBN_f52_last(Y, X, C, M, j0, n, n, 0);
+    }
+    muBN_init(&t, tab+k*wlen, wlen);
+    muBN_digits_store(&t, m, Y, 1, n+1, UBN_F52_BITS, 0);
+  }
+
+  //2. fixed window, left to right, top window may be shorter
+  P = X;
+  Q = Y;
+  i = ((nbits-1)/w)*w;
+  d = muBN_mgt_exp_bits(e, i, nbits-i);
+  if (sec) {
+    muBN_mgt_exp_lookup(&g, tab, 1<<w, d);
+  } else {
+    muBN_init(&g, tab+d*wlen, wlen);
+  }
+  muBN_digits_load(P, 1, n8*8, &g, UBN_F52_BITS);
+  while (i) {
+    i -= w;
+    for (k = 0; k<w; k++) {
+      muBN_f52_mont_n(Q, P, P, M, j0, n8, n);
+      muBN_f52_last(Q, P, P, M, j0, n, n, 0);
+      W = P; P = Q; Q = W;
+    }
+    d = muBN_mgt_exp_bits(e, i, w);
+    if (sec) {
+      muBN_init(&g, temp, wlen);
+      muBN_mgt_exp_lookup(&g, tab, 1<<w, d);
+    } else if (d) {
+      muBN_init(&g, tab+d*wlen, wlen);
+    } else {
+      continue;
+    }
+    muBN_digits_load(C, 1, n8*8, &g, UBN_F52_BITS);
+    muBN_f52_mont_n(Q, P, C, M, j0, n8, n);
+    muBN_f52_last(Q, P, C, M, j0, n, n, 0);
+    W = P; P = Q; Q = W;
+  }
+
+  //3. r = P.R/R'
+  muBN_init(&g, temp, wlen);
+  muBN_mgt_exp_one(&g, m, j0, j1, mone, &t);
+  muBN_digits_load(C, 1, n8*8, &g, UBN_F52_BITS);
+  muBN_f52_mont_n(Q, P, C, M, j0, n8, n);
+  muBN_f52_last(Q, P, C, M, j0, n, n, 0);
+  muBN_digits_store(r, m, Q, 1, n+1, UBN_F52_BITS, 0);
+}
+#endif
+
+static void muBN_mgt_exp_fast(muBN_t *r, muBN_t *a, muBN_t *e, muBN_t *m,
+                              muBN_uword_t j0, muBN_t *j1, muBN_t *mone,
+                              muBN_uword_t *temp) {
+  muBN_t        acc0, acc1, g, g2;
+  muBN_t        *A, *B, *X;
+  muBN_uword_t  *tsqr, *tab;
+  muBN_size_t   wlen;
+  muBN_size_t   w, i, l, k;
+  muBN_uword_t  d;
+
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_f52_use(m->wlen, UBN_F52_EXP_WLEN)) {
+    muBN_mgt_exp_f52(r, a, e, m, j0, j1, mone, temp, 0);
+    return;
+  }
+#endif
+  wlen = m->wlen;
+  tsqr = temp;
+  muBN_init(&acc0, temp+wlen*2, wlen);
+  muBN_init(&acc1, temp+wlen*3, wlen);
+  tab  = temp+wlen*4;
+
+  i = muBN_count_bit(e);
+  if (i == 0) {
+    muBN_mgt_exp_one(&acc0, m, j0, j1, mone, &acc1);
+    muBN_copy(r, &acc0);
+    return;
+  }
+  w = muBN_mgt_exp_window(i);
+
+  //1. odd powers: tab[k] = a^(2k+1)
+  muBN_init(&g, tab, wlen);
+  muBN_copy(&g, a);
+  if (w > 1) {
+    muBN_mgt_sqr(&acc1, a, m, j0, tsqr);
+    muBN_init(&g2, tab, wlen);
+    for (k = 1; k < (1<<(w-1)); k++) {
+      muBN_init(&g, tab+k*wlen, wlen);
+      muBN_mgt_mul(&g, &g2, &acc1, m, j0);
+      g2.v = g.v;
+    }
+  }
+
+  //2. sliding window, left to right
+  A = &acc0;
+  B = &acc1;
+  i--;
+  k = 0;
+  while (i >= 0) {
+    if (!muBN_test_bit(e, i)) {
+      muBN_mgt_sqr(A, A, m, j0, tsqr);
+      i--;
+      continue;
+    }
+    //longest window e[i..l] ending with a one
+    l = (i-w+1 < 0) ? 0 : i-w+1;
+    while (!muBN_test_bit(e, l)) {
+      l++;
+    }
+    d = muBN_mgt_exp_bits(e, l, i-l+1);
+    g.v = tab + (d>>1)*wlen;
+    if (k == 0) {
+      muBN_copy(A, &g);
+      k = 1;
+    } else {
+      while (i >= l) {
+        muBN_mgt_sqr(A, A, m, j0, tsqr);
+        i--;
+      }
+      muBN_mgt_mul(B, A, &g, m, j0);
+      X = A; A = B; B = X;
+    }
+    i = l-1;
+  }
+  muBN_copy(r, A);
+}
+
+static void muBN_mgt_exp_secure(muBN_t *r, muBN_t *a, muBN_t *e, muBN_t *m,
+                                muBN_uword_t j0, muBN_t *j1, muBN_t *mone,
+                                muBN_uword_t *temp) {
+  muBN_t        acc0, acc1, g, gp;
+  muBN_t        *A, *B, *X;
+  muBN_uword_t  *tsqr, *tab;
+  muBN_size_t   wlen;
+  muBN_size_t   nbits;
+  muBN_size_t   w, i, k;
+
+#if defined(UBN_X86_IFMA) && (UBN_BITS_PER_WORD == 64)
+  if (muBN_f52_use(m->wlen, UBN_F52_EXP_WLEN)) {
+    muBN_mgt_exp_f52(r, a, e, m, j0, j1, mone, temp, 1);
+    return;
+  }
+#endif
+  wlen = m->wlen;
+  tsqr = temp;
+  muBN_init(&acc0, temp+wlen*2, wlen);
+  muBN_init(&acc1, temp+wlen*3, wlen);
+  tab  = temp+wlen*4;
+
+  // window depends only on the exponent word-length, not its value
+  nbits = e->wlen*UBN_BITS_PER_WORD;
+  w = muBN_mgt_exp_window(nbits);
+
+  //1. all powers: tab[k] = a^k
+  muBN_init(&g,  tab,      wlen);
+  muBN_mgt_exp_one(&g, m, j0, j1, mone, &acc0);
+  muBN_init(&g,  tab+wlen, wlen);
+  muBN_copy(&g, a);
+  for (k = 2; k < (1<<w); k++) {
+    muBN_init(&g,  tab+k*wlen,     wlen);
+    if (k&1) {
+      muBN_init(&gp, tab+(k-1)*wlen, wlen);
+      muBN_mgt_mul(&g, &gp, a, m, j0);
+    } else {
+      muBN_init(&gp, tab+(k>>1)*wlen, wlen);
+      muBN_mgt_sqr(&g, &gp, m, j0, tsqr);
+    }
+  }
+
+  //2. fixed window, left to right, top window may be shorter
+  //   looked up entries go in the squaring temp, not used by mul
+  muBN_init(&g, tsqr, wlen);
+  A = &acc0;
+  B = &acc1;
+  i = ((nbits-1)/w)*w;
+  muBN_mgt_exp_lookup(A, tab, 1<<w, muBN_mgt_exp_bits(e, i, nbits-i));
+  while (i) {
+    i -= w;
+    for (k = 0; k<w; k++) {
+      muBN_mgt_sqr(A, A, m, j0, tsqr);
+    }
+    muBN_mgt_exp_lookup(&g, tab, 1<<w, muBN_mgt_exp_bits(e, i, w));
+    muBN_mgt_mul(B, A, &g, m, j0);
+    X = A; A = B; B = X;
+  }
+  muBN_copy(r, A);
+}
+
+void muBN_mgt_exp(muBN_t *r, muBN_t *a, muBN_t *e, muBN_t *m,
+                  muBN_uword_t j0, muBN_t *j1, muBN_uword_t *temp) {
+  muBN_mgt_exp_fast(r, a, e, m, j0, j1, NULL, temp);
+}
+
+void muBN_mgt_exp_sec(muBN_t *r, muBN_t *a, muBN_t *e, muBN_t *m,
+                      muBN_uword_t j0, muBN_t *j1, muBN_uword_t *temp) {
+  muBN_mgt_exp_secure(r, a, e, m, j0, j1, NULL, temp);
+}
+
+/* ======================================================================================= */
+/*                                Mongomery  Context                                       */
+/* ======================================================================================= */
+
+muBN_word_t muBN_mgt_ctx_init(muBN_mgt_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                              muBN_uword_t *temp) {
+  muBN_size_t wlen;
+  muBN_t      one;
+
+  wlen = m->wlen;
+  if (muBN_is_even(m) || muBN_is_one(m)) {
+    return 0;
+  }
+  muBN_init(&ctx->m,   buf+wlen*0, wlen);
+  muBN_init(&ctx->one, buf+wlen*1, wlen);
+  muBN_init(&ctx->r2,  buf+wlen*2, wlen);
+  muBN_copy(&ctx->m, m);
+  ctx->m.C = 0;
+  ctx->j0  = muBN_mgt_cst(&ctx->m, &ctx->r2, temp);
+  muBN_init(&one, temp, wlen);
+  muBN_one(&one);
+  muBN_mgt_mul(&ctx->one, &ctx->r2, &one, &ctx->m, ctx->j0);
+
+  ctx->wlen    = wlen;
+  ctx->tmp_sqr = wlen*2;
+  ctx->tmp_inv = wlen*8+10;
+  ctx->tmp_exp = wlen*((1<<UBN_EXP_WINDOW_MAX)+4);
+  return 1;
+}
+
+void muBN_mgt_ctx_clear(muBN_mgt_ctx_t *ctx) {
+  muBN_zero(&ctx->m);
+  muBN_zero(&ctx->one);
+  muBN_zero(&ctx->r2);
+  ctx->j0      = 0;
+  ctx->wlen    = 0;
+  ctx->tmp_sqr = 0;
+  ctx->tmp_inv = 0;
+  ctx->tmp_exp = 0;
+}
+
+void muBN_mgt_ctx_z2mgt(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a) {
+  muBN_mgt_mul(r, a, &ctx->r2, &ctx->m, ctx->j0);
+}
+
+void muBN_mgt_ctx_mgt2z(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  muBN_t one, ta;
+  muBN_init(&one, temp,            ctx->wlen);
+  muBN_init(&ta,  temp+ctx->wlen,  ctx->wlen);
+  muBN_one(&one);
+  muBN_copy(&ta, a);
+  muBN_mgt_mul(r, &ta, &one, &ctx->m, ctx->j0);
+}
+
+void muBN_mgt_ctx_mul(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b) {
+  muBN_mgt_mul(r, a, b, &ctx->m, ctx->j0);
+}
+
+void muBN_mgt_ctx_sqr(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  muBN_mgt_sqr(r, a, &ctx->m, ctx->j0, temp);
+}
+
+muBN_uword_t muBN_mgt_ctx_inv(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  muBN_t t;
+
+  // (a.R)⁻¹ = a⁻¹.R⁻¹, then two R² products bring it to a⁻¹.R
+  muBN_init(&t, temp, ctx->wlen);
+  if (!muBN_mod_inv_sec(&t, a, &ctx->m, temp+ctx->wlen)) {
+    muBN_zero(r);
+    return 0;
+  }
+  muBN_mgt_mul(r, &t, &ctx->r2, &ctx->m, ctx->j0);
+  muBN_mgt_mul(&t, r, &ctx->r2, &ctx->m, ctx->j0);
+  muBN_copy(r, &t);
+  return 1;
+}
+
+muBN_uword_t muBN_mgt_inv_batch(muBN_mgt_ctx_t *ctx, muBN_t *out, muBN_t *in, muBN_size_t n,
+                                muBN_uword_t *temp) {
+  muBN_t       ubn_t, ubn_u;
+  muBN_t       *t, *u, *x;
+  muBN_size_t  i;
+
+  if (n <= 0) {
+    return 1;
+  }
+  t = &ubn_t;
+  u = &ubn_u;
+  muBN_init(t, temp,           ctx->wlen);
+  muBN_init(u, temp+ctx->wlen, ctx->wlen);
+
+  //out[i] = in[0]...in[i], zero inputs count as one
+  if (muBN_is_zero(&in[0])) {
+    muBN_copy(&out[0], &ctx->one);
+  } else {
+    muBN_copy(&out[0], &in[0]);
+  }
+  for (i = 1; i < n; i++) {
+    if (muBN_is_zero(&in[i])) {
+      muBN_copy(&out[i], &out[i-1]);
+    } else {
+      muBN_mgt_mul(&out[i], &out[i-1], &in[i], &ctx->m, ctx->j0);
+    }
+  }
+
+  //u = (in[0]...in[n-1])⁻¹
+  if (!muBN_mgt_ctx_inv(ctx, u, &out[n-1], temp+2*ctx->wlen)) {
+    for (i = 0; i < n; i++) {
+      muBN_zero(&out[i]);
+    }
+    return 0;
+  }
+
+  //out[i] = u.out[i-1], u = (in[0]...in[i-1])⁻¹
+  for (i = n-1; i > 0; i--) {
+    if (muBN_is_zero(&in[i])) {
+      muBN_zero(&out[i]);
+      continue;
+    }
+    muBN_mgt_mul(t, u, &in[i], &ctx->m, ctx->j0);
+    muBN_mgt_mul(&out[i], u, &out[i-1], &ctx->m, ctx->j0);
+    x = u; u = t; t = x;
+  }
+  if (muBN_is_zero(&in[0])) {
+    muBN_zero(&out[0]);
+  } else {
+    muBN_copy(&out[0], u);
+  }
+  return 1;
+}
+
+void muBN_mgt_sum_of_products(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b,
+                              muBN_size_t k, muBN_uword_t *temp) {
+  muBN_t        acc, p;
+  muBN_udword_t n;
+  muBN_uword_t  hi, lt;
+  muBN_size_t   i, wlen;
+
+  wlen = ctx->wlen;
+  muBN_init_zero(&acc, temp,        2*wlen);
+  muBN_init     (&p,   temp+2*wlen, 2*wlen);
+
+  //1. hi:acc = a[0].b[0] + ... + a[k-1].b[k-1], unreduced
+  hi = 0;
+  for (i = 0; i < k; i++) {
+    muBN_mul(&p, &a[i], &b[i]);
+    acc.C = 0;
+    p.C   = 0;
+    hi += muBN_add(&acc, &acc, &p);
+  }
+
+  //2. one reduction: hi:acc < k.m², so hi:r < (k.m/R + 1).m
+  hi += muBN_mgt_redc_words(acc.v, &ctx->m, ctx->j0);
+  for (i = 0; i < wlen; i++) {
+    r->v[i] = acc.v[i];
+  }
+  r->C  = 0;
+  r->OV = 0;
+
+  //3. headroom: k.m/R <= k.(m0+1)/2^b, m0 the top word of m,
+  //   so a 255 bits modulus over 256 bits needs half the subtractions of P-256
+  n = ((muBN_udword_t)k*((muBN_udword_t)ctx->m.v[0]+1) + UBN_MAX_UWORD) >> UBN_BITS_PER_WORD;
+  while (n--) {
+    lt = (muBN_ucmp(r, &ctx->m) < 0);
+    muBN_mgt_final_sub(r, &ctx->m, hi);
+    hi -= (hi != 0) & lt;
+  }
+}
+
+void muBN_mgt_ctx_exp(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *e,
+                      muBN_uword_t *temp) {
+  muBN_mgt_exp_fast(r, a, e, &ctx->m, ctx->j0, &ctx->r2, &ctx->one, temp);
+}
+
+void muBN_mgt_ctx_exp_sec(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *e,
+                          muBN_uword_t *temp) {
+  muBN_mgt_exp_secure(r, a, e, &ctx->m, ctx->j0, &ctx->r2, &ctx->one, temp);
+}
+
+
+/* ======================================================================================= */
+/*                                Barrett  Context                                         */
+/* ======================================================================================= */
+
+muBN_word_t muBN_barrett_ctx_init(muBN_barrett_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                                  muBN_uword_t *temp) {
+  muBN_size_t wlen, k, i;
+  muBN_t      rem;
+
+  wlen = m->wlen;
+  k    = wlen;
+  i    = 0;
+  while (k && (!m->v[i])) {
+    i++;
+    k--;
+  }
+  if (k == 0) {
+    return 0;
+  }
+  //m = B^(k-1): mu = B^(k+1) does not fit
+  if (m->v[i] == 1) {
+    for (i++; (i < wlen) && (!m->v[i]); i++);
+    if (i == wlen) {
+      return 0;
+    }
+  }
+  muBN_init(&ctx->m,  buf,      wlen);
+  muBN_init(&ctx->mu, buf+wlen, k+1);
+  muBN_copy(&ctx->m, m);
+  ctx->m.C = 0;
+  muBN_init(&rem, temp+3*k+1, k);
+  muBN_bpow_divrem(&rem, ctx->mu.v, &ctx->m, 2*k, temp);
+
+  ctx->k       = k;
+  ctx->wlen    = wlen;
+  ctx->tmp_red = wlen*4+4;
+  ctx->tmp_mul = wlen*6+4;
+  return 1;
+}
+
+void muBN_barrett_ctx_clear(muBN_barrett_ctx_t *ctx) {
+  muBN_zero(&ctx->m);
+  muBN_zero(&ctx->mu);
+  ctx->k       = 0;
+  ctx->wlen    = 0;
+  ctx->tmp_red = 0;
+  ctx->tmp_mul = 0;
+}
+
+/* HAC 14.42, with B = 2^b and m on k significant words.
+ * Words in temp are stored LSW first; pm, pmu and px point on the LSW of
+ * m, mu and x, so that pm[-j] is the word of weight B^j.
+ *
+ *  q1 = x / B^(k-1)
+ *  q3 = q1.mu / B^(k+1), columns below k-1 are skipped, q3 is a few units too small
+ *  r  = (x - q3.m) mod B^(k+1), products above B^k are skipped
+ *  while r >= m: r = r - m
+ */
+void muBN_barrett_reduce(muBN_barrett_ctx_t *ctx, muBN_t *r, muBN_t *x, muBN_uword_t *temp) {
+  muBN_uword_t  *q1, *q2, *q3, *r2;
+  muBN_uword_t  *pm, *pmu, *px;
+  muBN_udword_t  muldw;
+  muBN_uword_t   carry, borrow, y, mask;
+  muBN_size_t    k, i, j, jmin, jmax, n;
+
+  k   = ctx->k;
+  q1  = temp;
+  q2  = temp+k+1;
+  q3  = q2+k+1;
+  r2  = q2+2*k+2;
+  pm  = ctx->m.v+ctx->m.wlen-1;
+  pmu = ctx->mu.v+ctx->mu.wlen-1;
+  px  = x->v+x->wlen-1;
+
+  //q1
+  for (i = 0; i <= k; i++) {
+    q1[i] = (i+k-1 < x->wlen) ? px[-(i+k-1)] : 0;
+  }
+
+  //q2 = q1.mu, columns k-1 and above
+  for (i = 0; i < 2*k+2; i++) {
+    q2[i] = 0;
+  }
+  for (i = 0; i <= k; i++) {
+    carry = 0;
+    jmin  = (i < k-1) ? k-1-i : 0;
+    for (j = jmin; j <= k; j++) {
+      muldw   = (muBN_udword_t)q1[i]*pmu[-j] + q2[i+j] + carry;
+      q2[i+j] = (muBN_uword_t)muldw;
+      carry   = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD);
+    }
+    q2[i+k+1] = carry;
+  }
+
+  //r2 = q3.m mod B^(k+1)
+  for (i = 0; i <= k; i++) {
+    r2[i] = 0;
+  }
+  for (i = 0; i <= k; i++) {
+    carry = 0;
+    jmax  = (k-i < k-1) ? k-i : k-1;
+    for (j = 0; j <= jmax; j++) {
+      muldw   = (muBN_udword_t)q3[i]*pm[-j] + r2[i+j] + carry;
+      r2[i+j] = (muBN_uword_t)muldw;
+      carry   = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD);
+    }
+    if (i == 0) {
+      r2[k] = carry;
+    }
+  }
+
+  //r2 = x - r2 mod B^(k+1)
+  borrow = 0;
+  for (i = 0; i <= k; i++) {
+    muldw = (muBN_udword_t)((i < x->wlen) ? px[-i] : 0) - r2[i] - borrow;
+    r2[i] = (muBN_uword_t)muldw;
+    borrow = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD)&1;
+  }
+
+  //r2 < 4m, q3 misses q by 2 at most, plus 1 for the columns of q2 skipped: three
+  //subtractions of m, each one kept or not by the mask of its borrow, same job for all values
+  for (n = 0; n < 3; n++) {
+    borrow = 0;
+    for (i = 0; i <= k; i++) {
+      muldw  = (muBN_udword_t)r2[i] - ((i < k) ? pm[-i] : 0) - borrow;
+      borrow = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD)&1;
+    }
+    mask   = (muBN_uword_t)0 - (borrow^1);
+    borrow = 0;
+    for (i = 0; i <= k; i++) {
+      muldw  = (muBN_udword_t)r2[i] - ((i < k) ? pm[-i] : 0) - borrow;
+      y      = (muBN_uword_t)muldw;
+      borrow = (muBN_uword_t)(muldw>>UBN_BITS_PER_WORD)&1;
+      r2[i]  = (y & mask) | (r2[i] & ~mask);
+    }
+  }
+
+  muBN_zero(r);
+  for (i = 0; i < k; i++) {
+    r->v[r->wlen-1-i] = r2[i];
+  }
+}
+
+void muBN_barrett_mulmod(muBN_barrett_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b,
+                         muBN_uword_t *temp) {
+  muBN_t x;
+
+  muBN_init(&x, temp, a->wlen+b->wlen);
+  muBN_mul(&x, a, b);
+  muBN_barrett_reduce(ctx, r, &x, temp+a->wlen+b->wlen);
+}
+
+/* ======================================================================================= */
+/*                                Special Form Context                                     */
+/* ======================================================================================= */
+
+/* Registry of the special form primes, most significant word first */
+static const muBN_uword_t muBN_fe_p256[] = {
+  UBN_WORD64(0xFFFFFFFF,0x00000001), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0x00000000,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF)
+};
+static const muBN_uword_t muBN_fe_p384[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFE),
+  UBN_WORD64(0xFFFFFFFF,0x00000000), UBN_WORD64(0x00000000,0xFFFFFFFF)
+};
+static const muBN_uword_t muBN_fe_p521[] = {
+  UBN_WORD64(0x00000000,0x000001FF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF)
+};
+static const muBN_uword_t muBN_fe_secp256k1[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFE,0xFFFFFC2F)
+};
+static const muBN_uword_t muBN_fe_p25519[] = {
+  UBN_WORD64(0x7FFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFED)
+};
+
+static const struct {
+  const muBN_uword_t  *p;
+  muBN_size_t         wlen;
+  uint8_t             kind;
+} muBN_fe_registry[] = {
+  {muBN_fe_p256,      sizeof(muBN_fe_p256)/sizeof(muBN_uword_t),      UBN_FE_NIST_P256},
+  {muBN_fe_p384,      sizeof(muBN_fe_p384)/sizeof(muBN_uword_t),      UBN_FE_NIST_P384},
+  {muBN_fe_p521,      sizeof(muBN_fe_p521)/sizeof(muBN_uword_t),      UBN_FE_MERSENNE},
+  {muBN_fe_secp256k1, sizeof(muBN_fe_secp256k1)/sizeof(muBN_uword_t), UBN_FE_PMERSENNE},
+  {muBN_fe_p25519,    sizeof(muBN_fe_p25519)/sizeof(muBN_uword_t),    UBN_FE_PMERSENNE},
+};
+
+/* 2^32n mod m in 32 bits words for the NIST primes, used to fold the carry out of 2^32n */
+static const int8_t muBN_fe_p256_fold[8]  = {1, 0, 0, -1, 0, 0, -1, 1};
+static const int8_t muBN_fe_p384_fold[12] = {1, -1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+
+/* Word lengths of the registry primes. The fold constants 2^(n.UBN_BITS_PER_WORD) mod m
+ * of the (pseudo) Mersenne ones fit 33 bits.
+ */
+#define UBN_FE_W(bits)   ((muBN_size_t)(((bits)+UBN_BITS_PER_WORD-1)/UBN_BITS_PER_WORD))
+#define UBN_FE_MAX_W     UBN_FE_W(521)
+#define UBN_FE_MAX_CW    UBN_FE_W(33)
+
+/* The kernels below are instantiated for each registry word length: the loops run on
+ * constants and are unrolled on 32 and 64 bits targets. They only use the stack.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define UBN_FE_INLINE    __attribute__((always_inline)) static inline
+#else
+#define UBN_FE_INLINE    static inline
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (UBN_BITS_PER_WORD >= 32)
+#define UBN_FE_UNROLL    _Pragma("GCC unroll 16")
+#else
+#define UBN_FE_UNROLL
+#endif
+
+/* 1 if a == p, a may have more or less leading zero words than p */
+static muBN_word_t muBN_fe_match(muBN_t *a, const muBN_uword_t *p, muBN_size_t plen) {
+  muBN_uword_t  x, y;
+  muBN_size_t   i;
+
+  for (i = 0; (i < a->wlen) || (i < plen); i++) {
+    x = (i < a->wlen) ? a->v[a->wlen-1-i] : 0;
+    y = (i < plen)    ? p[plen-1-i]       : 0;
+    if (x != y) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* x = a*b, a and b are n words most significant first, x is 2n words least significant first */
+UBN_FE_INLINE void muBN_fe_kmul(muBN_uword_t *x, const muBN_uword_t *a, const muBN_uword_t *b,
+                                muBN_size_t n) {
+  muBN_udword_t  uv;
+  muBN_uword_t   ai, carry;
+  muBN_size_t    i, j;
+
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    x[i] = 0;
+  }
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    ai    = a[n-1-i];
+    carry = 0;
+    UBN_FE_UNROLL
+    for (j = 0; j < n; j++) {
+      uv     = (muBN_udword_t)ai*(muBN_udword_t)b[n-1-j] + x[i+j] + carry;
+      x[i+j] = (muBN_uword_t)uv;
+      carry  = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    }
+    x[i+n] = carry;
+  }
+}
+
+/* x = a², a is n words most significant first, x is 2n words least significant first.
+ * Products above the diagonal, doubled while the squares are added.
+ */
+UBN_FE_INLINE void muBN_fe_ksqr(muBN_uword_t *x, const muBN_uword_t *a, muBN_size_t n) {
+  muBN_udword_t  uv, sq;
+  muBN_uword_t   ai, carry, sh, w;
+  muBN_size_t    i, j;
+
+  x[0]     = 0;
+  x[2*n-1] = 0;
+  UBN_FE_UNROLL
+  for (i = 0; i < n-1; i++) {
+    ai    = a[n-1-i];
+    carry = 0;
+    UBN_FE_UNROLL
+    for (j = i+1; j < n; j++) {
+      uv     = (muBN_udword_t)ai*(muBN_udword_t)a[n-1-j] + ((i == 0) ? 0 : x[i+j]) + carry;
+      x[i+j] = (muBN_uword_t)uv;
+      carry  = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    }
+    x[i+n] = carry;
+  }
+  sh    = 0;
+  carry = 0;
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    sq       = (muBN_udword_t)a[n-1-i]*(muBN_udword_t)a[n-1-i];
+    w        = x[2*i];
+    uv       = (muBN_udword_t)(muBN_uword_t)((w<<1)|sh) + (muBN_uword_t)sq + carry;
+    sh       = w>>(UBN_BITS_PER_WORD-1);
+    x[2*i]   = (muBN_uword_t)uv;
+    carry    = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    w        = x[2*i+1];
+    uv       = (muBN_udword_t)(muBN_uword_t)((w<<1)|sh) + (muBN_uword_t)(sq>>UBN_BITS_PER_WORD) + carry;
+    sh       = w>>(UBN_BITS_PER_WORD-1);
+    x[2*i+1] = (muBN_uword_t)uv;
+    carry    = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+  }
+}
+
+/* r = hi.2^(n.UBN_BITS_PER_WORD) + x mod m, hi 0 or 1, x < 2m on n words least significant
+ * first. m is subtracted in a copy, then the borrow and hi mask the result: same job for all
+ * values. r is zero padded.
+ */
+UBN_FE_INLINE void muBN_fe_csub(muBN_fe_ctx_t *ctx, muBN_t *r, const muBN_uword_t *x,
+                                muBN_size_t n, muBN_uword_t hi) {
+  muBN_uword_t   y[UBN_FE_MAX_W];
+  muBN_udword_t  uv;
+  muBN_uword_t   bw, mask, *m;
+  muBN_size_t    i;
+
+  m  = &ctx->m.v[ctx->m.wlen-1];
+  bw = 0;
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    uv   = (muBN_udword_t)x[i] - m[-i] - bw;
+    y[i] = (muBN_uword_t)uv;
+    bw   = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD) & 1;
+  }
+  //x is kept if the subtraction borrowed out of hi:x
+  mask = (muBN_uword_t)0 - (bw & (hi^1));
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    r->v[r->wlen-1-i] = (x[i] & mask) | (y[i] & ~mask);
+  }
+  for (; i < r->wlen; i++) {
+    r->v[r->wlen-1-i] = 0;
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+/* c[j] = 32 bits word j of x, x is least significant first */
+UBN_FE_INLINE void muBN_fe_to32(uint32_t *c, const muBN_uword_t *x, muBN_size_t n32) {
+  muBN_size_t  j;
+#if UBN_BITS_PER_WORD >= 32
+
+  UBN_FE_UNROLL
+  for (j = 0; j < n32; j++) {
+    c[j] = (uint32_t)(x[(j*32)/UBN_BITS_PER_WORD] >> ((j*32)%UBN_BITS_PER_WORD));
+  }
+#else
+  muBN_size_t  k;
+
+  for (j = 0; j < n32; j++) {
+    c[j] = 0;
+    for (k = 0; k < (muBN_size_t)(32/UBN_BITS_PER_WORD); k++) {
+      c[j] |= ((uint32_t)x[j*(32/UBN_BITS_PER_WORD)+k]) << (k*UBN_BITS_PER_WORD);
+    }
+  }
+#endif
+}
+
+#if UBN_BITS_PER_WORD < 32
+/* x = c[n32-1]..c[0] in words, least significant first */
+UBN_FE_INLINE void muBN_fe_from32(muBN_uword_t *x, const uint32_t *c, muBN_size_t n32) {
+  muBN_size_t  i;
+
+  for (i = 0; i < n32*(muBN_size_t)(32/UBN_BITS_PER_WORD); i++) {
+    x[i] = (muBN_uword_t)(c[(i*UBN_BITS_PER_WORD)/32] >> ((i*UBN_BITS_PER_WORD)%32));
+  }
+}
+#endif
+
+/* r = top.2^(n.UBN_BITS_PER_WORD) + x mod m, x on n words least significant first, top -1, 0
+ * or 1 and -m < top.2^(n.UBN_BITS_PER_WORD) + x < 2m: x - m and x + m are computed, then the
+ * result is selected by masks. r is zero padded.
+ */
+UBN_FE_INLINE void muBN_fe_nist_final(muBN_fe_ctx_t *ctx, muBN_t *r, const muBN_uword_t *x,
+                                      muBN_size_t n, muBN_word_t top) {
+  muBN_uword_t   y[UBN_FE_W(384)], z[UBN_FE_W(384)];
+  muBN_udword_t  uv, sum;
+  muBN_uword_t   bw, carry, u, msub, madd, *m;
+  muBN_size_t    i;
+
+  m     = &ctx->m.v[ctx->m.wlen-1];
+  bw    = 0;
+  carry = 0;
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    uv    = (muBN_udword_t)x[i] - m[-i] - bw;
+    y[i]  = (muBN_uword_t)uv;
+    bw    = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD) & 1;
+    sum   = (muBN_udword_t)x[i] + m[-i] + carry;
+    z[i]  = (muBN_uword_t)sum;
+    carry = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+  }
+  //u = top+1: x - m if u is 2, or 1 without borrow, x + m if u is 0
+  u    = (muBN_uword_t)(top+1);
+  msub = (muBN_uword_t)0 - ((u>>1) | (u & (bw^1)));
+  madd = (muBN_uword_t)0 - ((u^1) & ((u>>1)^1) & 1);
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    r->v[r->wlen-1-i] = (y[i] & msub) | (z[i] & madd) | (x[i] & ~(msub|madd));
+  }
+  for (; i < r->wlen; i++) {
+    r->v[r->wlen-1-i] = 0;
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+/* Limbs of the NIST folds: the words, or 32 bits ones below 32 bits words */
+#if UBN_BITS_PER_WORD >= 32
+typedef muBN_uword_t  muBN_fe_limb_t;
+typedef muBN_dword_t  muBN_fe_acc_t;
+#define UBN_FE_LIMB   ((muBN_size_t)UBN_BITS_PER_WORD)
+#else
+typedef uint32_t      muBN_fe_limb_t;
+typedef int64_t       muBN_fe_acc_t;
+#define UBN_FE_LIMB   ((muBN_size_t)32)
+#endif
+
+/* s[n-1]..s[0] are signed 32 bits columns of a value v congruent to t, -4.2^32n < v < 8.2^32n.
+ * q = s[n-1] >> 32 is folded first: v' = v - q.2^32n + q.(2^32n mod m), -m < v' < 2m. The low
+ * halves of the columns are then packed in limbs, their high halves added one column up, with
+ * a single signed carry chain: top = v' >> 32n is -1, 0 or 1. r = v' + m, v' or v' - m, both
+ * computed, then selected by masks: same job for all values.
+ */
+UBN_FE_INLINE void muBN_fe_nist_fold(muBN_fe_ctx_t *ctx, muBN_t *r, int64_t *s,
+                                     const int8_t *fold, muBN_size_t n) {
+  muBN_fe_limb_t  c[12];
+  muBN_fe_acc_t   acc, top;
+  int64_t         q, h;
+  muBN_size_t     nl, R, i, j, k;
+#if UBN_BITS_PER_WORD < 32
+  muBN_uword_t    x[UBN_FE_W(384)];
+#endif
+
+  q        = s[n-1] >> 32;
+  s[n-1]  &= 0xFFFFFFFF;
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    s[i] += fold[i] * q;
+  }
+
+  R   = UBN_FE_LIMB/32;
+  nl  = n/R;
+  top = 0;
+  UBN_FE_UNROLL
+  for (j = 0; j < nl; j++) {
+    c[j] = 0;
+    h    = 0;
+    UBN_FE_UNROLL
+    for (k = 0; k < R; k++) {
+      i     = j*R+k;
+      c[j] |= ((muBN_fe_limb_t)(uint32_t)s[i]) << (32*k);
+      if (i) {
+        h += (s[i-1] >> 32) * ((int64_t)1 << (32*k));
+      }
+    }
+    acc  = (muBN_fe_acc_t)c[j] + h + top;
+    c[j] = (muBN_fe_limb_t)acc;
+    top  = acc >> UBN_FE_LIMB;
+  }
+  top += s[n-1] >> 32;
+
+#if UBN_BITS_PER_WORD >= 32
+  muBN_fe_nist_final(ctx, r, c, nl, (muBN_word_t)top);
+#else
+  muBN_fe_from32(x, c, n);
+  muBN_fe_nist_final(ctx, r, x, (n*32)/UBN_BITS_PER_WORD, (muBN_word_t)top);
+#endif
+}
+
+/* FIPS 186-4 D.2.3, x = c[15]..c[0] in 32 bits words: s1 + 2s2 + 2s3 + s4 + s5 - d1 - d2 - d3 - d4
+ * summed column by column.
+ */
+UBN_FE_INLINE void muBN_fe_p256_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x) {
+  uint32_t  c[16];
+  int64_t   s[8];
+
+  muBN_fe_to32(c, x, 16);
+  s[0] = (int64_t)c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14];
+  s[1] = (int64_t)c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15];
+  s[2] = (int64_t)c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+  s[3] = (int64_t)c[3] - c[8] - c[9] + 2*(int64_t)c[11] + 2*(int64_t)c[12] + c[13] - c[15];
+  s[4] = (int64_t)c[4] - c[9] - c[10] + 2*(int64_t)c[12] + 2*(int64_t)c[13] + c[14];
+  s[5] = (int64_t)c[5] - c[10] - c[11] + 2*(int64_t)c[13] + 2*(int64_t)c[14] + c[15];
+  s[6] = (int64_t)c[6] - c[8] - c[9] + c[13] + 3*(int64_t)c[14] + 2*(int64_t)c[15];
+  s[7] = (int64_t)c[7] + c[8] - c[10] - c[11] - c[12] - c[13] + 3*(int64_t)c[15];
+  muBN_fe_nist_fold(ctx, r, s, muBN_fe_p256_fold, 8);
+}
+
+/* FIPS 186-4 D.2.4, x = c[23]..c[0] in 32 bits words: s1 + 2s2 + s3 + s4 + s5 + s6 + s7 - d1 - d2 - d3
+ * summed column by column.
+ */
+UBN_FE_INLINE void muBN_fe_p384_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x) {
+  uint32_t  c[24];
+  int64_t   s[12];
+
+  muBN_fe_to32(c, x, 24);
+  s[0]  = (int64_t)c[0] + c[12] + c[20] + c[21] - c[23];
+  s[1]  = (int64_t)c[1] - c[12] + c[13] - c[20] + c[22] + c[23];
+  s[2]  = (int64_t)c[2] - c[13] + c[14] - c[21] + c[23];
+  s[3]  = (int64_t)c[3] + c[12] - c[14] + c[15] + c[20] + c[21] - c[22] - c[23];
+  s[4]  = (int64_t)c[4] + c[12] + c[13] - c[15] + c[16] + c[20] + 2*(int64_t)c[21] + c[22] - 2*(int64_t)c[23];
+  s[5]  = (int64_t)c[5] + c[13] + c[14] - c[16] + c[17] + c[21] + 2*(int64_t)c[22] + c[23];
+  s[6]  = (int64_t)c[6] + c[14] + c[15] - c[17] + c[18] + c[22] + 2*(int64_t)c[23];
+  s[7]  = (int64_t)c[7] + c[15] + c[16] - c[18] + c[19] + c[23];
+  s[8]  = (int64_t)c[8] + c[16] + c[17] - c[19] + c[20];
+  s[9]  = (int64_t)c[9] + c[17] + c[18] - c[20] + c[21];
+  s[10] = (int64_t)c[10] + c[18] + c[19] - c[21] + c[22];
+  s[11] = (int64_t)c[11] + c[19] + c[20] - c[22] + c[23];
+  muBN_fe_nist_fold(ctx, r, s, muBN_fe_p384_fold, 12);
+}
+
+/* x[0..xl) = x[0..n) + x[n..n+hl).f, f = 2^(n.UBN_BITS_PER_WORD) mod m on fw words most
+ * significant first. One row per word of f: the low halves of the products, the high halves of
+ * the previous ones and the carry are added in a single chain, the products do not wait for it.
+ */
+UBN_FE_INLINE void muBN_fe_pm_fold(muBN_uword_t *x, muBN_size_t n, muBN_size_t hl,
+                                   const muBN_uword_t *f, muBN_size_t fw, muBN_size_t xl) {
+  muBN_uword_t   h[UBN_FE_MAX_W];
+  muBN_udword_t  uv, sum;
+  muBN_uword_t   fj, ph, carry;
+  muBN_size_t    i, j;
+
+  UBN_FE_UNROLL
+  for (i = 0; i < hl; i++) {
+    h[i] = x[n+i];
+  }
+  UBN_FE_UNROLL
+  for (i = n; i < xl; i++) {
+    x[i] = 0;
+  }
+  for (j = 0; j < fw; j++) {
+    fj    = f[fw-1-j];
+    ph    = 0;
+    carry = 0;
+    UBN_FE_UNROLL
+    for (i = 0; i < xl-j; i++) {
+      uv     = (i < hl) ? (muBN_udword_t)h[i]*(muBN_udword_t)fj : 0;
+      sum    = (muBN_udword_t)x[i+j] + (muBN_uword_t)uv + ph + carry;
+      x[i+j] = (muBN_uword_t)sum;
+      carry  = (muBN_uword_t)(sum>>UBN_BITS_PER_WORD);
+      ph     = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+    }
+  }
+}
+
+/* (Pseudo) Mersenne reduction, m = 2^k - c on cw words, x on 2n words least significant first.
+ * With B = 2^(n.UBN_BITS_PER_WORD), two word aligned folds by f = B mod m = c.2^s on fw words,
+ * s = n.UBN_BITS_PER_WORD - k: x < B.(1+f) on n+fw words, then x < B + f² < 2B on n+1 words.
+ * If s is 0 that is below 2m, else the s+1 top bits are folded by c: x < 2^k + 2^(s+1).c < 2m.
+ * Then one masked subtraction. Same job for all values.
+ */
+UBN_FE_INLINE void muBN_fe_pm_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x,
+                                     muBN_size_t n, muBN_size_t k, muBN_size_t fw,
+                                     muBN_size_t cw) {
+  muBN_udword_t  uv;
+  muBN_uword_t   h, carry, *c;
+  muBN_size_t    s, i;
+
+  muBN_fe_pm_fold(x, n, n,  ctx->f.v, fw, n+fw);
+  muBN_fe_pm_fold(x, n, fw, ctx->f.v, fw, n+1);
+
+  s = n*(muBN_size_t)UBN_BITS_PER_WORD - k;
+  if (!s) {
+    muBN_fe_csub(ctx, r, x, n, x[n]);
+    return;
+  }
+  h       = (x[n] << s) | (x[n-1] >> (UBN_BITS_PER_WORD-s));
+  x[n-1] &= (((muBN_uword_t)1)<<(UBN_BITS_PER_WORD-s))-1;
+  c       = &ctx->c.v[cw-1];
+  carry   = 0;
+  UBN_FE_UNROLL
+  for (i = 0; i < n; i++) {
+    uv    = (muBN_udword_t)x[i] + ((i < cw) ? (muBN_udword_t)h*(muBN_udword_t)c[-i] : 0) + carry;
+    x[i]  = (muBN_uword_t)uv;
+    carry = (muBN_uword_t)(uv>>UBN_BITS_PER_WORD);
+  }
+  muBN_fe_csub(ctx, r, x, n, 0);
+}
+
+/* The registry (pseudo) Mersenne primes, with their f and c lengths */
+UBN_FE_INLINE void muBN_fe_k1_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x) {
+  muBN_fe_pm_reduce(ctx, r, x, UBN_FE_W(256), 256, UBN_FE_W(33), UBN_FE_W(33));
+}
+
+UBN_FE_INLINE void muBN_fe_25519_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x) {
+  muBN_fe_pm_reduce(ctx, r, x, UBN_FE_W(255), 255, 1, 1);
+}
+
+UBN_FE_INLINE void muBN_fe_p521_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_uword_t *x) {
+  muBN_fe_pm_reduce(ctx, r, x, UBN_FE_W(521), 521, 1, 1);
+}
+
+/* fixed length product and reduction, one instance per registry prime.
+ * a and b are read on their n low words: a,b < m.
+ */
+#define UBN_FE_KERNELS(name, bits)                                                          \
+static void muBN_fe_mul_##name(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b) {      \
+  muBN_uword_t  x[2*UBN_FE_W(bits)];                                                      \
+                                                                                          \
+  muBN_fe_kmul(x, a->v+a->wlen-UBN_FE_W(bits), b->v+b->wlen-UBN_FE_W(bits), UBN_FE_W(bits)); \
+  muBN_fe_##name##_reduce(ctx, r, x);                                                     \
+}                                                                                         \
+static void muBN_fe_sqr_##name(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a) {                 \
+  muBN_uword_t  x[2*UBN_FE_W(bits)];                                                      \
+                                                                                          \
+  muBN_fe_ksqr(x, a->v+a->wlen-UBN_FE_W(bits), UBN_FE_W(bits));                           \
+  muBN_fe_##name##_reduce(ctx, r, x);                                                     \
+}
+UBN_FE_KERNELS(p256,  256)
+UBN_FE_KERNELS(p384,  384)
+UBN_FE_KERNELS(k1,    256)
+UBN_FE_KERNELS(25519, 255)
+UBN_FE_KERNELS(p521,  521)
+
+muBN_word_t muBN_fe_ctx_init(muBN_fe_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                             muBN_uword_t *temp) {
+  muBN_size_t  wlen, n, cw, i;
+
+  wlen = m->wlen;
+  muBN_init(&ctx->m, buf, wlen);
+  muBN_copy(&ctx->m, m);
+  ctx->m.C = 0;
+  ctx->wlen    = wlen;
+  ctx->k       = muBN_count_bit(m);
+  ctx->tmp_mul = 0;
+  ctx->kind    = UBN_FE_GENERIC;
+  for (i = 0; i < (muBN_size_t)(sizeof(muBN_fe_registry)/sizeof(muBN_fe_registry[0])); i++) {
+    if (muBN_fe_match(m, muBN_fe_registry[i].p, muBN_fe_registry[i].wlen)) {
+      ctx->kind = muBN_fe_registry[i].kind;
+      break;
+    }
+  }
+
+  switch (ctx->kind) {
+  case UBN_FE_PMERSENNE:
+  case UBN_FE_MERSENNE:
+    //c = 2^k - m, on its significant words
+    muBN_init(&ctx->c, buf+wlen, wlen);
+    muBN_copy(&ctx->c, m);
+    muBN_negate(&ctx->c);
+    for (i = 0; i < wlen; i++) {
+      if (i*(muBN_size_t)UBN_BITS_PER_WORD >= ctx->k) {
+        ctx->c.v[wlen-1-i] = 0;
+      } else if ((i+1)*(muBN_size_t)UBN_BITS_PER_WORD > ctx->k) {
+        ctx->c.v[wlen-1-i] &= (((muBN_uword_t)1)<<(ctx->k%UBN_BITS_PER_WORD))-1;
+      }
+    }
+    //f = c.2^s, the fold constant at the word boundary above m
+    n = UBN_FE_W(ctx->k);
+    muBN_init(&ctx->f, buf+2*wlen, wlen);
+    muBN_copy(&ctx->f, &ctx->c);
+    muBN_lshift(&ctx->f, n*(muBN_size_t)UBN_BITS_PER_WORD - ctx->k);
+    for (cw = wlen; (cw > 1) && (!ctx->c.v[wlen-cw]); cw--);
+    muBN_init(&ctx->c, buf+2*wlen-cw, cw);
+    for (cw = wlen; (cw > 1) && (!ctx->f.v[wlen-cw]); cw--);
+    muBN_init(&ctx->f, buf+3*wlen-cw, cw);
+    break;
+  case UBN_FE_GENERIC:
+    if (!muBN_barrett_ctx_init(&ctx->barrett, m, buf+2*wlen, temp)) {
+      return 0;
+    }
+    ctx->tmp_mul = wlen*6+4;
+    break;
+  default:
+    break;
+  }
+  return 1;
+}
+
+void muBN_fe_ctx_clear(muBN_fe_ctx_t *ctx) {
+  if (ctx->kind == UBN_FE_GENERIC) {
+    muBN_barrett_ctx_clear(&ctx->barrett);
+  }
+  if ((ctx->kind == UBN_FE_PMERSENNE) || (ctx->kind == UBN_FE_MERSENNE)) {
+    muBN_zero(&ctx->c);
+    muBN_zero(&ctx->f);
+  }
+  muBN_zero(&ctx->m);
+  ctx->k       = 0;
+  ctx->wlen    = 0;
+  ctx->tmp_mul = 0;
+  ctx->kind    = UBN_FE_GENERIC;
+}
+
+void muBN_fe_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *t, muBN_uword_t *temp) {
+  muBN_uword_t  x[2*UBN_FE_MAX_W];
+  muBN_size_t   n, i;
+
+  if (ctx->kind == UBN_FE_GENERIC) {
+    muBN_barrett_reduce(&ctx->barrett, r, t, temp);
+    return;
+  }
+  //t < m², its words above 2n are zero
+  n = UBN_FE_W(ctx->k);
+  for (i = 0; i < 2*n; i++) {
+    x[i] = (i < t->wlen) ? t->v[t->wlen-1-i] : 0;
+  }
+  switch (ctx->kind) {
+  case UBN_FE_NIST_P256:
+    muBN_fe_p256_reduce(ctx, r, x);
+    break;
+  case UBN_FE_NIST_P384:
+    muBN_fe_p384_reduce(ctx, r, x);
+    break;
+  case UBN_FE_PMERSENNE:
+    if (ctx->k == 255) {
+      muBN_fe_25519_reduce(ctx, r, x);
+    } else {
+      muBN_fe_k1_reduce(ctx, r, x);
+    }
+    break;
+  default:
+    muBN_fe_p521_reduce(ctx, r, x);
+    break;
+  }
+}
+
+void muBN_fe_mul(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b, muBN_uword_t *temp) {
+  muBN_t t;
+
+  //2^255-19 and secp256k1 are the pseudo Mersenne primes, P-521 the Mersenne one
+  switch (ctx->kind) {
+  case UBN_FE_NIST_P256:
+    muBN_fe_mul_p256(ctx, r, a, b);
+    break;
+  case UBN_FE_NIST_P384:
+    muBN_fe_mul_p384(ctx, r, a, b);
+    break;
+  case UBN_FE_PMERSENNE:
+    if (ctx->k == 255) {
+      muBN_fe_mul_25519(ctx, r, a, b);
+    } else {
+      muBN_fe_mul_k1(ctx, r, a, b);
+    }
+    break;
+  case UBN_FE_MERSENNE:
+    muBN_fe_mul_p521(ctx, r, a, b);
+    break;
+  default:
+    muBN_init(&t, temp, 2*ctx->wlen);
+    muBN_mul(&t, a, b);
+    muBN_barrett_reduce(&ctx->barrett, r, &t, temp+2*ctx->wlen);
+    break;
+  }
+}
+
+void muBN_fe_sqr(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  muBN_t t;
+
+  switch (ctx->kind) {
+  case UBN_FE_NIST_P256:
+    muBN_fe_sqr_p256(ctx, r, a);
+    break;
+  case UBN_FE_NIST_P384:
+    muBN_fe_sqr_p384(ctx, r, a);
+    break;
+  case UBN_FE_PMERSENNE:
+    if (ctx->k == 255) {
+      muBN_fe_sqr_25519(ctx, r, a);
+    } else {
+      muBN_fe_sqr_k1(ctx, r, a);
+    }
+    break;
+  case UBN_FE_MERSENNE:
+    muBN_fe_sqr_p521(ctx, r, a);
+    break;
+  default:
+    muBN_init(&t, temp, 2*ctx->wlen);
+    muBN_sqr_words(t.v, a);
+    muBN_barrett_reduce(&ctx->barrett, r, &t, temp+2*ctx->wlen);
+    break;
+  }
+}
@@ -30,8 +30,31 @@
 
 #include "muBN_config.h"
 
-#if UBN_BITS_PER_WORD == 32
-#define UBN_LOG2_BITS_PER_WORD   4UL
+#if UBN_BITS_PER_WORD == 64
+#define UBN_LOG2_BITS_PER_WORD   6UL
+#define UBN_WORD_BIT_MASK        0xFFFFFFFFFFFFFFFFULL
+#define UBN_MAX_UWORD            0xFFFFFFFFFFFFFFFFULL
+#define UBN_WORD_HIGH_BIT        0x8000000000000000ULL
+#define UBN_WORD_LOW_BIT         0x0000000000000001ULL
+#define UBN_WORD_CARRY_BIT       (((muBN_udword_t)1)<<64)
+
+#define UBN_DWORD_HIGH_BIT       (((muBN_udword_t)1)<<127)
+
+typedef uint64_t            muBN_uword_t;
+typedef  int64_t            muBN_word_t;
+typedef unsigned __int128   muBN_udword_t;
+typedef  __int128           muBN_dword_t;
+typedef int32_t             muBN_size_t;
+
+/* UBN_WORD32 cannot be expressed with 64 bits words, use UBN_WORD64 */
+#define UBN_WORD64(h,l)          ((((muBN_uword_t)(h))<<32)|(l))
+
+#ifdef UBN_LITTLE_ENDIAN
+#define uword2BE(w)              __builtin_bswap64(w)
+#endif
+
+#elif UBN_BITS_PER_WORD == 32
+#define UBN_LOG2_BITS_PER_WORD   5UL
 #define UBN_WORD_BIT_MASK        0xFFFFFFFFUL
 #define UBN_MAX_UWORD            0xFFFFFFFFUL
 #define UBN_WORD_HIGH_BIT        0x80000000UL
@@ -47,6 +70,7 @@ typedef  int64_t    muBN_dword_t;
 typedef int32_t     muBN_size_t;
 
 #define UBN_WORD32(x)            (x)
+#define UBN_WORD64(h,l)          UBN_WORD32(h), UBN_WORD32(l)
 
 #ifdef UBN_LITTLE_ENDIAN
 #define uword2BE(w)                                 \
@@ -58,7 +82,7 @@ typedef int32_t     muBN_size_t;
 
 
 #elif UBN_BITS_PER_WORD == 16
-#define UBN_LOG2_BITS_PER_WORD   2UL
+#define UBN_LOG2_BITS_PER_WORD   4UL
 #define UBN_WORD_BIT_MASK        0xFFFFUL
 #define UBN_MAX_UWORD            0xFFFFUL
 #define UBN_WORD_HIGH_BIT        0x8000UL
@@ -74,15 +98,16 @@ typedef  int32_t   muBN_dword_t;
 typedef int16_t     muBN_size_t;
 
 #define UBN_WORD32(x)            ((x)>>16) &0xFFFF, (x)&0xFFFF
+#define UBN_WORD64(h,l)          UBN_WORD32(h), UBN_WORD32(l)
 
 #ifdef UBN_LITTLE_ENDIAN
 #define uword2BE(w)                             \
-  ( ((w)<<8)  & 0xFF00UL ) |                    \
+  ( ( ((w)<<8)  & 0xFF00UL ) |                    \
   ( ((w)>>8)  & 0x00FFUL ) )
 #endif
 
 #elif UBN_BITS_PER_WORD == 8
-#define UBN_LOG2_BITS_PER_WORD   1UL
+#define UBN_LOG2_BITS_PER_WORD   3UL
 #define UBN_WORD_BIT_MASK        0xFFUL
 #define UBN_MAX_UWORD            0xFFUL
 #define UBN_WORD_HIGH_BIT        0x80UL
@@ -98,6 +123,7 @@ typedef  int16_t  muBN_dword_t;
 typedef int16_t  muBN_size_t;
 
 #define UBN_WORD32(x)            ((x)>>24) &0xFF, (x>>16)&0xFF, ((x)>>8) &0xFF, (x)&0xFF
+#define UBN_WORD64(h,l)          UBN_WORD32(h), UBN_WORD32(l)
 
 #ifdef UBN_LITTLE_ENDIAN
 #define uword2BE(w)              (w)
@@ -108,7 +134,7 @@ typedef int16_t  muBN_size_t;
 #endif
 
 #ifndef NULL
-#define NULL ((void*)NULL)
+#define NULL ((void*)0)
 #endif
 
 
@@ -118,6 +144,28 @@ typedef int16_t  muBN_size_t;
 
 #define BE2uword(w)              uword2BE(w)                          
 
+/* Word length from which muBN_mul_karatsuba splits its operands */
+#ifndef UBN_KARATSUBA_THRESHOLD
+#define UBN_KARATSUBA_THRESHOLD  24
+#endif
+
+/* Define UBN_X86_AVX2 in muBN_config.h to build the AVX2 lanes of
+ * muBN_mgt_mul_x4/x8, UBN_X86_IFMA to build the AVX-512 IFMA
+ * Montgomery products and exponentiation, and UBN_X86_ADX to build the
+ * MULX/ADCX/ADOX add, sub, mul and Montgomery mul/sqr (64 bits words,
+ * GCC or clang). They are only used if the CPU reports the instruction
+ * set at run time, and give the same results as the generic code.
+ */
+
+/* Max window width used by Montgomery exponentiation, drives the temp size */
+#ifndef UBN_EXP_WINDOW_MAX
+#define UBN_EXP_WINDOW_MAX       6
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct {  
   uint8_t      OV:     1;
   uint8_t      C:      1;
@@ -500,7 +548,7 @@ muBN_word_t muBN_sub_uword(muBN_t *r,  muBN_t *a, muBN_uword_t w);
 /**
  *  r= a * b, and clear carry
  *
- * @pre r have length a lesat equal to twice the 'a' word-length + 'b' word-length + 1
+ * @pre r have length a lesat equal to 'a' word-length + 'b' word-length
  *
  * @param [out] r
  * @param [in] a
@@ -510,6 +558,27 @@ muBN_word_t muBN_sub_uword(muBN_t *r,  muBN_t *a, muBN_uword_t w);
  */
 void muBN_mul(muBN_t *r, muBN_t *a, muBN_t *b);
 
+/**
+ *  r= a * b, and clear carry
+ *
+ * Same result as muBN_mul. Operands of at least UBN_KARATSUBA_THRESHOLD words
+ * are split with Karatsuba, smaller ones use the schoolbook product. The
+ * signs of the middle operands are applied by masks and the carries run
+ * over the full length: same job for all values of given word-lengths.
+ *
+ * @pre r have length a lesat equal to 'a' word-length + 'b' word-length
+ * @pre r does not overlap a, b or temp
+ *
+ * @param [out] r
+ * @param [in]  a
+ * @param [in]  b
+ * @param [in]  temp  temporary buffer with a word length a least equals to 6*n + 128,
+ *                    with n the max of a and b word-length
+ *
+ * @spa
+ */
+void muBN_mul_karatsuba(muBN_t *r, muBN_t *a, muBN_t *b, muBN_uword_t *temp);
+
 /**
  *  r= a * w, and clear carry
  *
@@ -591,11 +660,42 @@ void  muBN_rand(muBN_t *r);
  * @param a 
  * @param m 
  *
- * @param temp  temporary buffer with a word length a least equals to a.wlen*2 + 2 
+ * @param temp  temporary buffer with a word length a least equals to m.wlen + a.wlen + 2
  *
  */
 void muBN_mod(muBN_t *r,  muBN_t *a, muBN_t *m, muBN_uword_t  *tmp);
 
+/**
+ * q = a / m, r= a % m, in a single pass
+ *
+ * @pre r,m have the same word-length
+ * @pre q has a word length a least equals to a.wlen, or holds the quotient
+ * @pre q and r do not overlap
+ *
+ * @param q 
+ * @param r 
+ * @param a 
+ * @param m 
+ *
+ * @param temp  temporary buffer with a word length a least equals to m.wlen + a.wlen + 2
+ *
+ */
+void muBN_divrem(muBN_t *q, muBN_t *r,  muBN_t *a, muBN_t *m, muBN_uword_t  *tmp);
+
+/**
+ * q = a / d, return a % d
+ *
+ * @pre q,a have the same word-length, q may be a or NULL
+ * @pre d is not zero
+ *
+ * @param q 
+ * @param a 
+ * @param d 
+ *
+ * @return a % d
+ */
+muBN_uword_t muBN_divrem_uword(muBN_t *q, muBN_t *a, muBN_uword_t d);
+
 /**
  * r= a+b % m
  *
@@ -632,7 +732,7 @@ void  muBN_mod_sub(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m);
  * @param a 
  * @param m 
  *
- * @param temp  temporary buffer with a word length a least equals to a.wlen*2 + 2 
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*6 + 2 
  *
  */
 void  muBN_mod_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t *temp);
@@ -655,7 +755,48 @@ void  muBN_mod_mul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m,  muBN_uword_t *t
  */
 muBN_word_t muBN_mod_inv(muBN_t *r, muBN_t *a, muBN_t *m,  muBN_uword_t *temp) ;
 
+/**
+ * r = a⁻¹ mod m, safegcd (Bernstein-Yang divsteps), variable time
+ *
+ * To be used with public inputs only.
+ *
+ * @pre m shall be odd
+ * @pre r,a,m have the same word-length
+ * @pre a<m
+ *
+ * @param r 
+ * @param a 
+ * @param m     odd moduli, prime or not
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*7 + 10
+ *
+ * @return 1 if inverse exist
+ * @return 0 else
+ *
+ */
+muBN_word_t muBN_mod_inv_var(muBN_t *r, muBN_t *a, muBN_t *m,  muBN_uword_t *temp) ;
+
 /*** Secured function ***/
+/**
+ * r = a⁻¹ mod m, safegcd (Bernstein-Yang divsteps)
+ *
+ * The divsteps count only depends on the bit length of m.
+ *
+ * @pre m shall be odd
+ * @pre r,a,m have the same word-length
+ * @pre a<m
+ *
+ * @param r 
+ * @param a 
+ * @param m     odd moduli, prime or not
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*7 + 10
+ *
+ * @return 1 if inverse exist
+ * @return 0 else
+ *
+ * @spa
+ */
+muBN_word_t muBN_mod_inv_sec(muBN_t *r, muBN_t *a, muBN_t *m,  muBN_uword_t *temp) ;
+
 /**
  * r= a+b % m
  *
@@ -699,7 +840,7 @@ void  muBN_mod_sub_sec(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, muBN_uword_t
  *
  * @param [in]  m     modulus
  * @param [out] j1    where to store J1
- * @param [in]  temp  temporary buffer with a word length a least equals to m.wlen*5 + 4
+ * @param [in]  temp  temporary buffer with a word length a least equals to m.wlen*3 + 1
  *
  * @return j0                                                                   
  *
@@ -747,6 +888,114 @@ void muBN_mgt_z2mgt(muBN_t *mr,  muBN_t *a, muBN_t *m, muBN_t *j1, muBN_uword_t
  */
 void muBN_mgt_mul(muBN_t *mr,  muBN_t *ma, muBN_t *mb, muBN_t *m,  muBN_uword_t j0);
 
+/**
+ * mr = MultMont(ma,ma),  with r = a² mod m
+ *
+ * Same result as muBN_mgt_mul(mr,ma,ma,m,j0), but each cross product
+ * ai*aj is computed only once.
+ *
+ * @pre mr,ma,m have the same word-length
+ * @pre ma<m
+ *
+ * @param mr
+ * @param ma
+ * @param m
+ * @param j0
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*2
+ *
+ * @spa
+ */
+void muBN_mgt_sqr(muBN_t *mr,  muBN_t *ma, muBN_t *m,  muBN_uword_t j0, muBN_uword_t *temp);
+
+/**
+ * r = t.R⁻¹ mod m, Montgomery reduction of a double width number
+ *
+ * With t = a.b computed by muBN_mul, same result as muBN_mgt_mul(r,a,b,m,j0).
+ * Sums of such products can be reduced once, see muBN_mgt_sum_of_products.
+ *
+ * @pre t has a word-length of 2*m.wlen, t < m.R
+ * @pre r has the m word-length
+ *
+ * @param r     result, may be the high half of t
+ * @param t     double width number, destroyed
+ * @param m
+ * @param j0
+ */
+void muBN_mgt_redc(muBN_t *r,  muBN_t *t, muBN_t *m,  muBN_uword_t j0);
+
+/**
+ * mr = MultMont(ma,mb) mod m, Almost Montgomery Multiplication
+ *
+ * As muBN_mgt_mul, without the final subtraction: with 4m < R, inputs
+ * in [0, 2m) give a result in [0, 2m), congruent to muBN_mgt_mul one.
+ * Results of muBN_mgt_mul or muBN_amm_mul/sqr can be mixed as inputs,
+ * muBN_mgt_mgt2z gives the reduced z value at the end of the chain.
+ *
+ * @pre mr,ma,mb,m have the same word-length
+ * @pre 4m < R, ma<2m and mb<2m
+ * @pre mr does not overlap ma or mb
+ *
+ * @param mr
+ * @param ma
+ * @param mb
+ * @param m
+ * @param j0
+ *
+ * @spa
+ */
+void muBN_amm_mul(muBN_t *mr,  muBN_t *ma, muBN_t *mb, muBN_t *m,  muBN_uword_t j0);
+
+/**
+ * mr = MultMont(ma,ma) mod m, see muBN_amm_mul and muBN_mgt_sqr
+ *
+ * @pre mr,ma,m have the same word-length
+ * @pre 4m < R, ma<2m
+ *
+ * @param mr
+ * @param ma
+ * @param m
+ * @param j0
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*2
+ *
+ * @spa
+ */
+void muBN_amm_sqr(muBN_t *mr,  muBN_t *ma, muBN_t *m,  muBN_uword_t j0, muBN_uword_t *temp);
+
+/**
+ * mr[i] = MultMont(ma[i],mb[i]) mod m[i], for 4 independent products
+ *
+ * Same results as 4 calls to muBN_mgt_mul. With UBN_X86_AVX2, an AVX2
+ * CPU and moduli of at least 512 bits, the 4 products run in the lanes of
+ * 256 bits registers, with 29 bits digits. Meant for throughput, the
+ * latency is not better than muBN_mgt_mul.
+ *
+ * @pre mr,ma,mb,m are arrays of 4 numbers, all of the same word-length
+ * @pre ma[i]<m[i], mb[i]<m[i], mr[i] does not overlap ma[i] nor mb[i]
+ *
+ * @param mr
+ * @param ma
+ * @param mb
+ * @param m     moduli, may be 4 times the same one
+ * @param j0    j0[i] is the muBN_mgt_cst of m[i]
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*36+32
+ *
+ * @spa
+ */
+void muBN_mgt_mul_x4(muBN_t *mr,  muBN_t *ma, muBN_t *mb, muBN_t *m,  muBN_uword_t *j0,
+                     muBN_uword_t *temp);
+
+/**
+ * mr[i] = MultMont(ma[i],mb[i]) mod m[i], for 8 independent products
+ *
+ * See muBN_mgt_mul_x4, the 8 lanes are run as two interleaved groups of 4.
+ *
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*72+64
+ *
+ * @spa
+ */
+void muBN_mgt_mul_x8(muBN_t *mr,  muBN_t *ma, muBN_t *mb, muBN_t *m,  muBN_uword_t *j0,
+                     muBN_uword_t *temp);
+
 
 /**
  *  mr = ma⁻¹ mod m,  with r = a⁻¹ mod m 
@@ -784,4 +1033,386 @@ muBN_uword_t muBN_mgt_inv(muBN_t *mr, muBN_t *ma, muBN_t *m,
  */
 void muBN_mgt_zmul(muBN_t *r,  muBN_t *a, muBN_t *b, muBN_t *m, 
                   muBN_uword_t j0, muBN_t *j1, muBN_uword_t *tmp);
+
+/**
+ * mr = ma^e mod m,  with r = a^e mod m
+ *
+ * Fast, variable time, version: sliding window over 'e' with a table of
+ * the odd powers of ma. Only for public exponents.
+ *
+ * ma is the Montgomery representetation of a: ma = a.R mod m
+ * mr is the Montgomery representetation of r: mr = r.R mod m
+ *
+ * @pre mr,ma,m,j1 have the same word-length
+ * @pre ma<m 
+ * @pre e does not overlap mr
+ *
+ * @param mr
+ * @param ma
+ * @param e     exponent, any word-length
+ * @param m
+ * @param j0
+ * @param j1
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*(2^UBN_EXP_WINDOW_MAX + 4)
+ *
+ */
+void muBN_mgt_exp(muBN_t *mr, muBN_t *ma, muBN_t *e, muBN_t *m,
+                  muBN_uword_t j0, muBN_t *j1, muBN_uword_t *temp);
+
+/**
+ * mr = ma^e mod m,  with r = a^e mod m
+ *
+ * Secured version: fixed window over the full word-length of 'e', a
+ * multiplication is done for each window and the table entries are read
+ * with a constant time lookup. For secret exponents.
+ *
+ * @pre mr,ma,m,j1 have the same word-length
+ * @pre ma<m 
+ * @pre e does not overlap mr
+ *
+ * @param mr
+ * @param ma
+ * @param e     exponent, any word-length
+ * @param m
+ * @param j0
+ * @param j1
+ * @param temp  temporary buffer with a word length a least equals to m.wlen*(2^UBN_EXP_WINDOW_MAX + 4)
+ *
+ * @spa
+ */
+void muBN_mgt_exp_sec(muBN_t *mr, muBN_t *ma, muBN_t *e, muBN_t *m,
+                      muBN_uword_t j0, muBN_t *j1, muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                Montgomery  Context                                      */
+/* ======================================================================================= */
+
+/**
+ * Odd modulus with its Montgomery constants, computed once by
+ * muBN_mgt_ctx_init. The numbers are views on a caller buffer.
+ * A context is read only once initialized and can be shared, each call
+ * gets its own temp buffer, of the documented tmp_xxx word length.
+ */
+typedef struct {
+  muBN_t        m;        /* modulus                               */
+  muBN_t        one;      /* R mod m, Montgomery representation of 1 */
+  muBN_t        r2;       /* R² mod m, aka J1                      */
+  muBN_uword_t  j0;       /* -m⁻¹ mod 2^b                          */
+  muBN_size_t   wlen;     /* modulus word length                   */
+  muBN_size_t   tmp_sqr;  /* temp word length for sqr and mgt2z    */
+  muBN_size_t   tmp_inv;  /* temp word length for inv              */
+  muBN_size_t   tmp_exp;  /* temp word length for exp and exp_sec  */
+} muBN_mgt_ctx_t;
+
+/**
+ * Setup a Montgomery context for the modulus m.
+ *
+ * @param [out] ctx
+ * @param [in]  m     odd modulus, copied in the context
+ * @param [in]  buf   context storage, word length a least equals to m.wlen*3
+ * @param [in]  temp  temporary buffer with a word length a least equals to m.wlen*3 + 1
+ *
+ * @return 1 if the context is ready
+ * @return 0 if m is even or one
+ */
+muBN_word_t muBN_mgt_ctx_init(muBN_mgt_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                              muBN_uword_t *temp);
+
+/**
+ * Wipe the context and its storage.
+ *
+ * @param [in/out] ctx
+ */
+void muBN_mgt_ctx_clear(muBN_mgt_ctx_t *ctx);
+
+/**
+ * r = Mont(a), see muBN_mgt_z2mgt
+ *
+ * @pre r,a have the ctx word-length, a<m
+ * @pre r and a do not overlap
+ */
+void muBN_mgt_ctx_z2mgt(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a);
+
+/**
+ * r = Mont⁻¹(a), see muBN_mgt_mgt2z. r and a may be the same number.
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_sqr
+ */
+void muBN_mgt_ctx_mgt2z(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp);
+
+/**
+ * r = MultMont(a,b), see muBN_mgt_mul
+ *
+ * @pre r,a,b have the ctx word-length, a<m and b<m
+ * @pre r does not overlap a or b
+ *
+ * @spa
+ */
+void muBN_mgt_ctx_mul(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b);
+
+/**
+ * r = MultMont(a,a), see muBN_mgt_sqr
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_sqr
+ *
+ * @spa
+ */
+void muBN_mgt_ctx_sqr(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp);
+
+/**
+ * r = a⁻¹, in Montgomery representation, see muBN_mod_inv_sec
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_inv
+ *
+ * @return 1 if inverse exist
+ * @return 0 else
+ */
+muBN_uword_t muBN_mgt_ctx_inv(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp);
+
+/**
+ * out[i] = in[i]⁻¹, in Montgomery representation, for i in [0, n)
+ *
+ * Montgomery's simultaneous inversion: one muBN_mgt_ctx_inv plus
+ * 3(n-1) muBN_mgt_mul. Zero inputs are skipped and give a zero output,
+ * they do not spoil the other inverses.
+ *
+ * @pre out[i], in[i] have the ctx word-length, in[i]<m
+ * @pre out and in shall not overlap
+ *
+ * @param out   n results
+ * @param in    n inputs
+ * @param n     number of elements
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_inv + 2*ctx->wlen
+ *
+ * @return 1 if all non zero inputs are invertible
+ * @return 0 else, all out[i] are set to zero
+ */
+muBN_uword_t muBN_mgt_inv_batch(muBN_mgt_ctx_t *ctx, muBN_t *out, muBN_t *in, muBN_size_t n,
+                                muBN_uword_t *temp);
+
+/**
+ * r = MultMont(a[0],b[0]) + ... + MultMont(a[k-1],b[k-1]) mod m
+ *
+ * The k products are accumulated unreduced in double width, then reduced
+ * once with muBN_mgt_redc, e.g. a.b+c.d for the price of one reduction.
+ * The few final subtractions depend on k and on the top word of m only.
+ *
+ * @pre r,a[i],b[i] have the ctx word-length, a[i]<m and b[i]<m
+ * @pre k < 2^UBN_BITS_PER_WORD
+ *
+ * @param r     result, may be one of the a[i] or b[i]
+ * @param a     k numbers
+ * @param b     k numbers
+ * @param k     number of products
+ * @param temp  temporary buffer with a word length a least equals to ctx->wlen*4
+ */
+void muBN_mgt_sum_of_products(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b,
+                              muBN_size_t k, muBN_uword_t *temp);
+
+/**
+ * r = a^e, in Montgomery representation, see muBN_mgt_exp
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_exp
+ */
+void muBN_mgt_ctx_exp(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *e,
+                      muBN_uword_t *temp);
+
+/**
+ * r = a^e, in Montgomery representation, see muBN_mgt_exp_sec
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param temp  temporary buffer with a word length a least equals to ctx->tmp_exp
+ *
+ * @spa
+ */
+void muBN_mgt_ctx_exp_sec(muBN_mgt_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *e,
+                          muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                Barrett  Context                                         */
+/* ======================================================================================= */
+
+/**
+ * Modulus with its Barrett reciprocal mu = floor(B^2k / m), B = 2^b and
+ * k the significant word length of m, computed once by muBN_barrett_ctx_init.
+ * No division is done on reduction, m may be even.
+ * The numbers are views on a caller buffer, the context is read only once
+ * initialized.
+ */
+typedef struct {
+  muBN_t        m;        /* modulus                               */
+  muBN_t        mu;       /* floor(B^2k / m), k+1 words            */
+  muBN_size_t   k;        /* significant word length of m          */
+  muBN_size_t   wlen;     /* modulus word length                   */
+  muBN_size_t   tmp_red;  /* temp word length for reduce           */
+  muBN_size_t   tmp_mul;  /* temp word length for mulmod           */
+} muBN_barrett_ctx_t;
+
+/**
+ * Setup a Barrett context for the modulus m.
+ *
+ * @param [out] ctx
+ * @param [in]  m     modulus, copied in the context
+ * @param [in]  buf   context storage, word length a least equals to m.wlen*2 + 1
+ * @param [in]  temp  temporary buffer with a word length a least equals to m.wlen*4 + 1
+ *
+ * @return 1 if the context is ready
+ * @return 0 if m is zero or a power of 2^b (including one)
+ */
+muBN_word_t muBN_barrett_ctx_init(muBN_barrett_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                                  muBN_uword_t *temp);
+
+/**
+ * Wipe the context and its storage.
+ *
+ * @param [in/out] ctx
+ */
+void muBN_barrett_ctx_clear(muBN_barrett_ctx_t *ctx);
+
+/**
+ * r = x mod m
+ *
+ * The quotient estimate is closed by a fixed count of masked subtractions:
+ * same job for all values of a given word-length.
+ *
+ * @pre r has the ctx word-length
+ * @pre x < B^2k, for instance x < m²
+ *
+ * @param [in]  ctx
+ * @param [out] r
+ * @param [in]  x     any word-length
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_red
+ */
+void muBN_barrett_reduce(muBN_barrett_ctx_t *ctx, muBN_t *r, muBN_t *x, muBN_uword_t *temp);
+
+/**
+ * r = a*b mod m
+ *
+ * @pre r,a,b have the ctx word-length, a<m and b<m
+ *
+ * @param [in]  ctx
+ * @param [out] r
+ * @param [in]  a
+ * @param [in]  b
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_mul
+ */
+void muBN_barrett_mulmod(muBN_barrett_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b,
+                         muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                Special Form Context                                     */
+/* ======================================================================================= */
+
+/**
+ * Reductions of a field context, chosen by muBN_fe_ctx_init from a
+ * registry of known primes:
+ *  - UBN_FE_NIST_P256, UBN_FE_NIST_P384: FIPS 186-4 D.2 32 bits words shuffle
+ *  - UBN_FE_PMERSENNE: m = 2^k - c with a short c, fold by c
+ *                      (secp256k1 2^256-2^32-977, 2^255-19)
+ *  - UBN_FE_MERSENNE:  m = 2^k - 1, shift and add (P-521)
+ *  - UBN_FE_GENERIC:   any other modulus, Barrett
+ */
+enum {
+  UBN_FE_GENERIC,
+  UBN_FE_NIST_P256,
+  UBN_FE_NIST_P384,
+  UBN_FE_PMERSENNE,
+  UBN_FE_MERSENNE
+};
+
+/**
+ * Modulus with its reduction, computed once by muBN_fe_ctx_init.
+ * Numbers are plain ones (not Montgomery). For the registry primes, a*b mod m
+ * is a fixed length product and reduction on the stack, with a fixed number
+ * of folds and a masked final subtraction: same job for all values, tmp_mul
+ * is 0. Other moduli use muBN_mul followed by a Barrett reduction.
+ * The numbers are views on a caller buffer, the context is read only once
+ * initialized.
+ */
+typedef struct {
+  muBN_t              m;        /* modulus                                */
+  muBN_t              c;        /* 2^k - m, (pseudo) Mersenne only        */
+  muBN_t              f;        /* c.2^s, k+s on whole words, idem        */
+  muBN_barrett_ctx_t  barrett;  /* generic only                           */
+  muBN_size_t         k;        /* bit length of m                        */
+  muBN_size_t         wlen;     /* modulus word length                    */
+  muBN_size_t         tmp_mul;  /* temp word length for reduce, mul, sqr  */
+  uint8_t             kind;     /* UBN_FE_xxx                             */
+} muBN_fe_ctx_t;
+
+/**
+ * Setup a field context for the modulus m.
+ *
+ * @param [out] ctx
+ * @param [in]  m     modulus, copied in the context
+ * @param [in]  buf   context storage, word length a least equals to m.wlen*4 + 1
+ * @param [in]  temp  temporary buffer with a word length a least equals to m.wlen*4 + 1
+ *
+ * @return 1 if the context is ready
+ * @return 0 if m is zero or a power of 2^b (including one)
+ */
+muBN_word_t muBN_fe_ctx_init(muBN_fe_ctx_t *ctx, muBN_t *m, muBN_uword_t *buf,
+                             muBN_uword_t *temp);
+
+/**
+ * Wipe the context and its storage.
+ *
+ * @param [in/out] ctx
+ */
+void muBN_fe_ctx_clear(muBN_fe_ctx_t *ctx);
+
+/**
+ * r = t mod m
+ *
+ * @pre r has the ctx word-length
+ * @pre t has the ctx word-length*2, t < m²
+ *
+ * @param [in]  ctx
+ * @param [out] r
+ * @param [in]  t
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_mul,
+ *                   may be NULL if it is 0
+ */
+void muBN_fe_reduce(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *t, muBN_uword_t *temp);
+
+/**
+ * r = a*b mod m
+ *
+ * @pre r,a,b have the ctx word-length, a<m and b<m
+ *
+ * @param [in]  ctx
+ * @param [out] r     may be a or b
+ * @param [in]  a
+ * @param [in]  b
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_mul,
+ *                   may be NULL if it is 0
+ */
+void muBN_fe_mul(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b, muBN_uword_t *temp);
+
+/**
+ * r = a² mod m
+ *
+ * @pre r,a have the ctx word-length, a<m
+ *
+ * @param [in]  ctx
+ * @param [out] r     may be a
+ * @param [in]  a
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_mul,
+ *                   may be NULL if it is 0
+ */
+void muBN_fe_sqr(muBN_fe_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,340 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef muBN_FIXED_H
+#define muBN_FIXED_H
+
+/*
+ * Header only C++ layer over muBN for a word-length N known at compile
+ * time (e.g. 256, 384 or 521 bits curves fields).
+ *
+ * A muBN_fixed<N> holds its N words in the muBN order, most significant
+ * first, so muBN_t views on it can be passed to the generic API, and a
+ * muBN_t of wlen N can be seen as a muBN_fixed<N>.
+ *
+ * All loops run on N, they are fully unrolled and the intermediate words
+ * stay in registers. There is no carry/overflow flag: add/sub return it.
+ * Modular operations are branchless (same time for all values).
+ */
+
+#include <stddef.h>
+#include "muBN.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define UBN_FIXED_UNROLL   _Pragma("GCC unroll 64")
+#else
+#define UBN_FIXED_UNROLL
+#endif
+
+template<size_t N> struct muBN_fixed {
+
+  static constexpr muBN_size_t wlen = (muBN_size_t)N;
+
+  /** words, most significant first */
+  muBN_uword_t v[N];
+
+  /* ------------------------------------------------------------------------------------- */
+  /*                                    muBN_t interop                                     */
+  /* ------------------------------------------------------------------------------------- */
+
+  /**
+   * muBN_t view on this number, for the generic API
+   */
+  muBN_t ubn() {
+    muBN_t r;
+    r.OV   = 0;
+    r.C    = 0;
+    r.rfu  = 0;
+    r.wlen = wlen;
+    r.v    = v;
+    return r;
+  }
+
+  /**
+   * muBN_fixed view on the words of a
+   *
+   * @pre a->wlen == N
+   */
+  static muBN_fixed &of(muBN_t *a) {
+    return *reinterpret_cast<muBN_fixed *>(a->v);
+  }
+
+  /* ------------------------------------------------------------------------------------- */
+  /*                                    Z Arithmetic                                       */
+  /* ------------------------------------------------------------------------------------- */
+
+  /**
+   * r = a+b
+   *
+   * @return the carry
+   */
+  static muBN_uword_t add(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &b) {
+    muBN_udword_t t;
+    muBN_uword_t  c;
+
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      t          = (muBN_udword_t)a.v[N-1-j] + b.v[N-1-j] + c;
+      r.v[N-1-j] = (muBN_uword_t)t;
+      c          = (muBN_uword_t)(t >> UBN_BITS_PER_WORD);
+    }
+    return c;
+  }
+
+  /**
+   * r = a-b
+   *
+   * @return the borrow
+   */
+  static muBN_uword_t sub(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &b) {
+    muBN_udword_t t;
+    muBN_uword_t  c;
+
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      t          = (muBN_udword_t)a.v[N-1-j] - b.v[N-1-j] - c;
+      r.v[N-1-j] = (muBN_uword_t)t;
+      c          = (muBN_uword_t)(t >> UBN_BITS_PER_WORD) & 1;
+    }
+    return c;
+  }
+
+  /**
+   * r = a*b
+   *
+   * @pre r does not overlap a or b
+   */
+  static void mul(muBN_fixed<2*N> &r, const muBN_fixed &a, const muBN_fixed &b) {
+    muBN_udword_t t;
+    muBN_uword_t  c, ai;
+
+    UBN_FIXED_UNROLL
+    for (size_t k = 0; k < 2*N; k++) {
+      r.v[k] = 0;
+    }
+    UBN_FIXED_UNROLL
+    for (size_t i = 0; i < N; i++) {
+      ai = a.v[N-1-i];
+      c  = 0;
+      UBN_FIXED_UNROLL
+      for (size_t j = 0; j < N; j++) {
+        t = (muBN_udword_t)ai * b.v[N-1-j] + r.v[2*N-1-i-j] + c;
+        r.v[2*N-1-i-j] = (muBN_uword_t)t;
+        c = (muBN_uword_t)(t >> UBN_BITS_PER_WORD);
+      }
+      r.v[N-1-i] = c;
+    }
+  }
+
+  /* ------------------------------------------------------------------------------------- */
+  /*                                   Mod Arithmetic                                      */
+  /* ------------------------------------------------------------------------------------- */
+
+  /**
+   * r = a+b mod m
+   *
+   * @pre a<m and b<m
+   */
+  static void mod_add(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &b,
+                      const muBN_fixed &m) {
+    muBN_uword_t  t[N];
+    muBN_udword_t x;
+    muBN_uword_t  c;
+
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      x    = (muBN_udword_t)a.v[N-1-j] + b.v[N-1-j] + c;
+      t[j] = (muBN_uword_t)x;
+      c    = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+    }
+    final_sub(r, t, c, m);
+  }
+
+  /**
+   * r = a-b mod m
+   *
+   * @pre a<m and b<m
+   */
+  static void mod_sub(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &b,
+                      const muBN_fixed &m) {
+    muBN_uword_t  t[N];
+    muBN_udword_t x;
+    muBN_uword_t  c, mask;
+
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      x    = (muBN_udword_t)a.v[N-1-j] - b.v[N-1-j] - c;
+      t[j] = (muBN_uword_t)x;
+      c    = (muBN_uword_t)(x >> UBN_BITS_PER_WORD) & 1;
+    }
+    mask = (muBN_uword_t)0 - c;
+    c    = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      x = (muBN_udword_t)t[j] + (m.v[N-1-j] & mask) + c;
+      r.v[N-1-j] = (muBN_uword_t)x;
+      c = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+    }
+  }
+
+  /* ------------------------------------------------------------------------------------- */
+  /*                                 Montgomery Arithmetic                                 */
+  /* ------------------------------------------------------------------------------------- */
+
+  /**
+   * mr = MultMont(ma,mb), see muBN_mgt_mul
+   *
+   * Same result as muBN_mgt_mul, r may be a or b.
+   *
+   * @pre ma<m and mb<m
+   */
+  static void mgt_mul(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &b,
+                      const muBN_fixed &m, muBN_uword_t j0) {
+    muBN_uword_t  t[N+2];
+    muBN_udword_t x;
+    muBN_uword_t  c, ai, u;
+
+    //CIOS, t least significant word first
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N+2; j++) {
+      t[j] = 0;
+    }
+    UBN_FIXED_UNROLL
+    for (size_t i = 0; i < N; i++) {
+      ai = a.v[N-1-i];
+      c  = 0;
+      UBN_FIXED_UNROLL
+      for (size_t j = 0; j < N; j++) {
+        x    = (muBN_udword_t)ai * b.v[N-1-j] + t[j] + c;
+        t[j] = (muBN_uword_t)x;
+        c    = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+      }
+      x      = (muBN_udword_t)t[N] + c;
+      t[N]   = (muBN_uword_t)x;
+      t[N+1] = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+
+      u = (muBN_uword_t)((muBN_udword_t)t[0] * j0);
+      x = (muBN_udword_t)u * m.v[N-1] + t[0];
+      c = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+      UBN_FIXED_UNROLL
+      for (size_t j = 1; j < N; j++) {
+        x      = (muBN_udword_t)u * m.v[N-1-j] + t[j] + c;
+        t[j-1] = (muBN_uword_t)x;
+        c      = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+      }
+      x      = (muBN_udword_t)t[N] + c;
+      t[N-1] = (muBN_uword_t)x;
+      t[N]   = t[N+1] + (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+    }
+    final_sub(r, t, t[N], m);
+  }
+
+  /**
+   * mr = MultMont(ma,ma), see muBN_mgt_sqr
+   *
+   * Same result as mgt_mul(r,a,a,m,j0), r may be a.
+   *
+   * @pre ma<m
+   */
+  static void mgt_sqr(muBN_fixed &r, const muBN_fixed &a, const muBN_fixed &m,
+                      muBN_uword_t j0) {
+    muBN_uword_t  t[2*N];
+    muBN_udword_t x;
+    muBN_uword_t  c, cc, ai, u;
+
+    //1. t = a², least significant word first
+    UBN_FIXED_UNROLL
+    for (size_t k = 0; k < 2*N; k++) {
+      t[k] = 0;
+    }
+    UBN_FIXED_UNROLL
+    for (size_t i = 0; i+1 < N; i++) {
+      ai = a.v[N-1-i];
+      c  = 0;
+      UBN_FIXED_UNROLL
+      for (size_t j = i+1; j < N; j++) {
+        x      = (muBN_udword_t)ai * a.v[N-1-j] + t[i+j] + c;
+        t[i+j] = (muBN_uword_t)x;
+        c      = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+      }
+      t[i+N] = c;
+    }
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t k = 0; k < 2*N; k++) {
+      u    = t[k];
+      t[k] = (muBN_uword_t)(u << 1) | c;
+      c    = u >> (UBN_BITS_PER_WORD-1);
+    }
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t i = 0; i < N; i++) {
+      ai       = a.v[N-1-i];
+      x        = (muBN_udword_t)ai * ai + t[2*i] + c;
+      t[2*i]   = (muBN_uword_t)x;
+      x        = (x >> UBN_BITS_PER_WORD) + t[2*i+1];
+      t[2*i+1] = (muBN_uword_t)x;
+      c        = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+    }
+
+    //2. t = t.R⁻¹, in t[N..2N-1]
+    cc = 0;
+    UBN_FIXED_UNROLL
+    for (size_t i = 0; i < N; i++) {
+      u = (muBN_uword_t)((muBN_udword_t)t[i] * j0);
+      c = 0;
+      UBN_FIXED_UNROLL
+      for (size_t j = 0; j < N; j++) {
+        x      = (muBN_udword_t)u * m.v[N-1-j] + t[i+j] + c;
+        t[i+j] = (muBN_uword_t)x;
+        c      = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+      }
+      x      = (muBN_udword_t)t[i+N] + c + cc;
+      t[i+N] = (muBN_uword_t)x;
+      cc     = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+    }
+    final_sub(r, t+N, cc, m);
+  }
+
+private:
+  /* r = hi:t mod m, t least significant word first, hi:t < 2m */
+  static void final_sub(muBN_fixed &r, const muBN_uword_t *t, muBN_uword_t hi,
+                        const muBN_fixed &m) {
+    muBN_uword_t  s[N];
+    muBN_udword_t x;
+    muBN_uword_t  c, mask;
+
+    c = 0;
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      x    = (muBN_udword_t)t[j] - m.v[N-1-j] - c;
+      s[j] = (muBN_uword_t)x;
+      c    = (muBN_uword_t)(x >> UBN_BITS_PER_WORD) & 1;
+    }
+    //keep t only if hi == 0 and t < m
+    mask = (muBN_uword_t)0 - ((hi | (c ^ 1)) & 1);
+    UBN_FIXED_UNROLL
+    for (size_t j = 0; j < N; j++) {
+      r.v[N-1-j] = (s[j] & mask) | (t[j] & ~mask);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,1611 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "muEC.h"
+
+/* ======================================================================================= */
+/*                                     Curves                                              */
+/* ======================================================================================= */
+
+/* Curve parameters, most significant word first, SEC 2 v2 */
+/* P-256 */
+static const muBN_uword_t muEC_p256_p[] = {
+  UBN_WORD64(0xFFFFFFFF,0x00000001), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0x00000000,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF)
+};
+static const muBN_uword_t muEC_p256_b[] = {
+  UBN_WORD64(0x5AC635D8,0xAA3A93E7), UBN_WORD64(0xB3EBBD55,0x769886BC),
+  UBN_WORD64(0x651D06B0,0xCC53B0F6), UBN_WORD64(0x3BCE3C3E,0x27D2604B)
+};
+static const muBN_uword_t muEC_p256_gx[] = {
+  UBN_WORD64(0x6B17D1F2,0xE12C4247), UBN_WORD64(0xF8BCE6E5,0x63A440F2),
+  UBN_WORD64(0x77037D81,0x2DEB33A0), UBN_WORD64(0xF4A13945,0xD898C296)
+};
+static const muBN_uword_t muEC_p256_gy[] = {
+  UBN_WORD64(0x4FE342E2,0xFE1A7F9B), UBN_WORD64(0x8EE7EB4A,0x7C0F9E16),
+  UBN_WORD64(0x2BCE3357,0x6B315ECE), UBN_WORD64(0xCBB64068,0x37BF51F5)
+};
+static const muBN_uword_t muEC_p256_n[] = {
+  UBN_WORD64(0xFFFFFFFF,0x00000000), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xBCE6FAAD,0xA7179E84), UBN_WORD64(0xF3B9CAC2,0xFC632551)
+};
+
+/* P-384 */
+static const muBN_uword_t muEC_p384_p[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFE),
+  UBN_WORD64(0xFFFFFFFF,0x00000000), UBN_WORD64(0x00000000,0xFFFFFFFF)
+};
+static const muBN_uword_t muEC_p384_b[] = {
+  UBN_WORD64(0xB3312FA7,0xE23EE7E4), UBN_WORD64(0x988E056B,0xE3F82D19),
+  UBN_WORD64(0x181D9C6E,0xFE814112), UBN_WORD64(0x0314088F,0x5013875A),
+  UBN_WORD64(0xC656398D,0x8A2ED19D), UBN_WORD64(0x2A85C8ED,0xD3EC2AEF)
+};
+static const muBN_uword_t muEC_p384_gx[] = {
+  UBN_WORD64(0xAA87CA22,0xBE8B0537), UBN_WORD64(0x8EB1C71E,0xF320AD74),
+  UBN_WORD64(0x6E1D3B62,0x8BA79B98), UBN_WORD64(0x59F741E0,0x82542A38),
+  UBN_WORD64(0x5502F25D,0xBF55296C), UBN_WORD64(0x3A545E38,0x72760AB7)
+};
+static const muBN_uword_t muEC_p384_gy[] = {
+  UBN_WORD64(0x3617DE4A,0x96262C6F), UBN_WORD64(0x5D9E98BF,0x9292DC29),
+  UBN_WORD64(0xF8F41DBD,0x289A147C), UBN_WORD64(0xE9DA3113,0xB5F0B8C0),
+  UBN_WORD64(0x0A60B1CE,0x1D7E819D), UBN_WORD64(0x7A431D7C,0x90EA0E5F)
+};
+static const muBN_uword_t muEC_p384_n[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xC7634D81,0xF4372DDF),
+  UBN_WORD64(0x581A0DB2,0x48B0A77A), UBN_WORD64(0xECEC196A,0xCCC52973)
+};
+
+/* secp256k1 */
+static const muBN_uword_t muEC_secp256k1_p[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF),
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFE,0xFFFFFC2F)
+};
+static const muBN_uword_t muEC_secp256k1_b[] = {
+  UBN_WORD64(0x00000000,0x00000000), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0x00000000,0x00000000), UBN_WORD64(0x00000000,0x00000007)
+};
+static const muBN_uword_t muEC_secp256k1_gx[] = {
+  UBN_WORD64(0x79BE667E,0xF9DCBBAC), UBN_WORD64(0x55A06295,0xCE870B07),
+  UBN_WORD64(0x029BFCDB,0x2DCE28D9), UBN_WORD64(0x59F2815B,0x16F81798)
+};
+static const muBN_uword_t muEC_secp256k1_gy[] = {
+  UBN_WORD64(0x483ADA77,0x26A3C465), UBN_WORD64(0x5DA4FBFC,0x0E1108A8),
+  UBN_WORD64(0xFD17B448,0xA6855419), UBN_WORD64(0x9C47D08F,0xFB10D4B8)
+};
+static const muBN_uword_t muEC_secp256k1_n[] = {
+  UBN_WORD64(0xFFFFFFFF,0xFFFFFFFF), UBN_WORD64(0xFFFFFFFF,0xFFFFFFFE),
+  UBN_WORD64(0xBAAEDCE6,0xAF48A03B), UBN_WORD64(0xBFD25E8C,0xD0364141)
+};
+
+static const muBN_uword_t muEC_secp256k1_beta[] = {
+  UBN_WORD64(0x7AE96A2B,0x657C0710), UBN_WORD64(0x6E64479E,0xAC3434E9),
+  UBN_WORD64(0x9CF04975,0x12F58995), UBN_WORD64(0xC1396C28,0x719501EE)
+};
+
+/* GLV decomposition, lambda.(x,y) = (beta.x,y). The short basis of the lattice of the
+ * (k1,k2) with k1 + k2.lambda = 0 mod n is (a1,b1) = (b2,-mb1), (a2,b2), with
+ * a2 = b2 + mb1. g1 = round(2^384.b2/n), g2 = round(2^384.mb1/n).
+ */
+static const muBN_uword_t muEC_secp256k1_lambda[] = {
+  UBN_WORD64(0x5363AD4C,0xC05C30E0), UBN_WORD64(0xA5261C02,0x8812645A),
+  UBN_WORD64(0x122E22EA,0x20816678), UBN_WORD64(0xDF02967C,0x1B23BD72)
+};
+static const muBN_uword_t muEC_secp256k1_g1[] = {
+  UBN_WORD64(0x3086D221,0xA7D46BCD), UBN_WORD64(0xE86C90E4,0x9284EB15),
+  UBN_WORD64(0x3DAA8A14,0x71E8CA7F), UBN_WORD64(0xE893209A,0x45DBB031)
+};
+static const muBN_uword_t muEC_secp256k1_g2[] = {
+  UBN_WORD64(0xE4437ED6,0x010E8828), UBN_WORD64(0x6F547FA9,0x0ABFE4C4),
+  UBN_WORD64(0x221208AC,0x9DF506C6), UBN_WORD64(0x1571B4AE,0x8AC47F71)
+};
+static const muBN_uword_t muEC_secp256k1_mb1[] = {
+  UBN_WORD64(0x00000000,0x00000000), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0xE4437ED6,0x010E8828), UBN_WORD64(0x6F547FA9,0x0ABFE4C3)
+};
+static const muBN_uword_t muEC_secp256k1_b2[] = {
+  UBN_WORD64(0x00000000,0x00000000), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0x3086D221,0xA7D46BCD), UBN_WORD64(0xE86C90E4,0x9284EB15)
+};
+
+static const struct {
+  const muBN_uword_t  *p;
+  const muBN_uword_t  *b;
+  const muBN_uword_t  *gx;
+  const muBN_uword_t  *gy;
+  const muBN_uword_t  *n;
+  const muBN_uword_t  *beta;
+  muBN_size_t         wlen;
+  uint8_t             a;
+} muEC_curves[] = {
+  /* UEC_P256 */
+  {muEC_p256_p, muEC_p256_b, muEC_p256_gx, muEC_p256_gy, muEC_p256_n, NULL,
+   sizeof(muEC_p256_p)/sizeof(muBN_uword_t), UEC_A_M3},
+  /* UEC_P384 */
+  {muEC_p384_p, muEC_p384_b, muEC_p384_gx, muEC_p384_gy, muEC_p384_n, NULL,
+   sizeof(muEC_p384_p)/sizeof(muBN_uword_t), UEC_A_M3},
+  /* UEC_SECP256K1 */
+  {muEC_secp256k1_p, muEC_secp256k1_b, muEC_secp256k1_gx, muEC_secp256k1_gy, muEC_secp256k1_n,
+   muEC_secp256k1_beta, sizeof(muEC_secp256k1_p)/sizeof(muBN_uword_t), UEC_A_0},
+};
+
+#define UEC_NB_CURVES  (sizeof(muEC_curves)/sizeof(muEC_curves[0]))
+
+/* ======================================================================================= */
+/*                                     Context                                             */
+/* ======================================================================================= */
+
+/* r = v[0..wlen-1] */
+static void muEC_load(muBN_t *r, const muBN_uword_t *v) {
+  muBN_size_t i;
+
+  for (i = 0; i < r->wlen; i++) {
+    r->v[i] = v[i];
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+muBN_size_t muEC_curve_wlen(uint8_t curve) {
+  if (curve >= UEC_NB_CURVES) {
+    return 0;
+  }
+  return muEC_curves[curve].wlen;
+}
+
+muBN_word_t muEC_ctx_init(muEC_ctx_t *ctx, uint8_t curve, muBN_uword_t *buf,
+                          muBN_uword_t *temp) {
+  muBN_size_t  wlen;
+
+  if (curve >= UEC_NB_CURVES) {
+    return 0;
+  }
+  wlen = muEC_curves[curve].wlen;
+
+  //p is staged in the slot of n, loaded last
+  muBN_init(&ctx->one,  buf+wlen*4+1, wlen);
+  muBN_init(&ctx->b,    buf+wlen*5+1, wlen);
+  muBN_init(&ctx->gx,   buf+wlen*6+1, wlen);
+  muBN_init(&ctx->gy,   buf+wlen*7+1, wlen);
+  muBN_init(&ctx->n,    buf+wlen*8+1, wlen);
+  muBN_init(&ctx->beta, buf+wlen*9+1, wlen);
+  muEC_load(&ctx->n, muEC_curves[curve].p);
+  if (!muBN_fe_ctx_init(&ctx->fp, &ctx->n, buf, temp)) {
+    return 0;
+  }
+  muBN_one(&ctx->one);
+  muEC_load(&ctx->b,  muEC_curves[curve].b);
+  muEC_load(&ctx->gx, muEC_curves[curve].gx);
+  muEC_load(&ctx->gy, muEC_curves[curve].gy);
+  muBN_zero(&ctx->beta);
+  if (muEC_curves[curve].beta) {
+    muEC_load(&ctx->beta, muEC_curves[curve].beta);
+  }
+  muEC_load(&ctx->n, muEC_curves[curve].n);
+
+  ctx->wlen    = wlen;
+  ctx->nbits   = muBN_count_bit(&ctx->n);
+  ctx->curve   = curve;
+  ctx->a       = muEC_curves[curve].a;
+  ctx->tmp_pt  = wlen*16;
+  //muBN_mod_inv_sec and its result, then the scaling
+  ctx->tmp_inv = wlen*(7+1+4)+10;
+  //table of 8 points, selected point and -y, then the table setup
+  ctx->tmp_mul = wlen*(8*3+3+1+3+8) + ctx->tmp_inv;
+  return 1;
+}
+
+void muEC_ctx_clear(muEC_ctx_t *ctx) {
+  muBN_fe_ctx_clear(&ctx->fp);
+  muBN_zero(&ctx->one);
+  muBN_zero(&ctx->b);
+  muBN_zero(&ctx->gx);
+  muBN_zero(&ctx->gy);
+  muBN_zero(&ctx->n);
+  muBN_zero(&ctx->beta);
+  ctx->wlen    = 0;
+  ctx->nbits   = 0;
+  ctx->tmp_pt  = 0;
+  ctx->tmp_inv = 0;
+  ctx->tmp_mul = 0;
+}
+
+/* ======================================================================================= */
+/*                                  Field helpers                                          */
+/* ======================================================================================= */
+
+/* Field products of the registry primes, fixed length and without temp. r may be a or b */
+static void muEC_fmul(muEC_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b) {
+  muBN_fe_mul(&ctx->fp, r, a, b, NULL);
+}
+
+static void muEC_fsqr(muEC_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  (void)temp;
+  muBN_fe_sqr(&ctx->fp, r, a, NULL);
+}
+
+/* r = a⁻¹ mod p, r shall not overlap a */
+static muBN_word_t muEC_finv(muEC_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_uword_t *temp) {
+  return muBN_mod_inv_sec(r, a, &ctx->fp.m, temp);
+}
+
+/* r = a+b mod p, a,b < p, r may be a or b. The carry and the borrow of a+b-p select
+ * a masked subtraction of p: same job for all values, without temp.
+ */
+static void muEC_fadd(muEC_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b) {
+  muBN_udword_t  x;
+  muBN_uword_t   c, bw, mask;
+  muBN_uword_t   *m;
+  muBN_size_t    i;
+
+  m = ctx->fp.m.v;
+  c = 0;
+  for (i = ctx->wlen-1; i >= 0; i--) {
+    x       = (muBN_udword_t)a->v[i] + b->v[i] + c;
+    r->v[i] = (muBN_uword_t)x;
+    c       = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+  }
+  bw = 0;
+  for (i = ctx->wlen-1; i >= 0; i--) {
+    x  = (muBN_udword_t)r->v[i] - m[i] - bw;
+    bw = (muBN_uword_t)(x >> UBN_BITS_PER_WORD) & 1;
+  }
+  //subtract p if a+b carried or a+b >= p
+  mask = (muBN_uword_t)0 - (c | (bw ^ 1));
+  bw   = 0;
+  for (i = ctx->wlen-1; i >= 0; i--) {
+    x       = (muBN_udword_t)r->v[i] - (m[i] & mask) - bw;
+    r->v[i] = (muBN_uword_t)x;
+    bw      = (muBN_uword_t)(x >> UBN_BITS_PER_WORD) & 1;
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+/* r = a-b mod p, a,b < p, r may be a or b. p is added back under the borrow mask */
+static void muEC_fsub(muEC_ctx_t *ctx, muBN_t *r, muBN_t *a, muBN_t *b) {
+  muBN_udword_t  x;
+  muBN_uword_t   c, mask;
+  muBN_uword_t   *m;
+  muBN_size_t    i;
+
+  m = ctx->fp.m.v;
+  c = 0;
+  for (i = ctx->wlen-1; i >= 0; i--) {
+    x       = (muBN_udword_t)a->v[i] - b->v[i] - c;
+    r->v[i] = (muBN_uword_t)x;
+    c       = (muBN_uword_t)(x >> UBN_BITS_PER_WORD) & 1;
+  }
+  mask = (muBN_uword_t)0 - c;
+  c    = 0;
+  for (i = ctx->wlen-1; i >= 0; i--) {
+    x       = (muBN_udword_t)r->v[i] + (m[i] & mask) + c;
+    r->v[i] = (muBN_uword_t)x;
+    c       = (muBN_uword_t)(x >> UBN_BITS_PER_WORD);
+  }
+  r->C  = 0;
+  r->OV = 0;
+}
+
+/* r = a if cond, cond is 0 or 1, r is left as is else. Same job in both cases */
+static void muEC_fcmov(muBN_t *r, muBN_t *a, muBN_uword_t cond) {
+  muBN_uword_t  mask;
+  muBN_size_t   i;
+
+  mask = (muBN_uword_t)0 - cond;
+  for (i = 0; i < r->wlen; i++) {
+    r->v[i] = (r->v[i] & ~mask) | (a->v[i] & mask);
+  }
+}
+
+/* F(i): i-th field element of temp */
+#define F(i)  (temp+(i)*ctx->wlen)
+
+/* ======================================================================================= */
+/*                                     Points                                              */
+/* ======================================================================================= */
+
+void muEC_point_init(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *buf) {
+  muBN_init(&P->x, buf,             ctx->wlen);
+  muBN_init(&P->y, buf+ctx->wlen,   ctx->wlen);
+  muBN_init(&P->z, buf+ctx->wlen*2, ctx->wlen);
+  muEC_set_infinity(ctx, P);
+}
+
+void muEC_set_infinity(muEC_ctx_t *ctx, muEC_point_t *P) {
+  muBN_copy(&P->x, &ctx->one);
+  muBN_copy(&P->y, &ctx->one);
+  muBN_zero(&P->z);
+}
+
+muBN_word_t muEC_is_infinity(muEC_ctx_t *ctx, muEC_point_t *P) {
+  (void)ctx;
+  return muBN_is_zero(&P->z);
+}
+
+void muEC_set_generator(muEC_ctx_t *ctx, muEC_point_t *P) {
+  muBN_copy(&P->x, &ctx->gx);
+  muBN_copy(&P->y, &ctx->gy);
+  muBN_copy(&P->z, &ctx->one);
+}
+
+void muEC_copy(muEC_point_t *R, muEC_point_t *P) {
+  if (R != P) {
+    muBN_copy(&R->x, &P->x);
+    muBN_copy(&R->y, &P->y);
+    muBN_copy(&R->z, &P->z);
+  }
+}
+
+muBN_word_t muEC_set_affine(muEC_ctx_t *ctx, muEC_point_t *P, muBN_t *x, muBN_t *y,
+                            muBN_uword_t *temp) {
+  if ((muBN_ucmp(x, &ctx->fp.m) >= 0) || (muBN_ucmp(y, &ctx->fp.m) >= 0)) {
+    muEC_set_infinity(ctx, P);
+    return 0;
+  }
+  muBN_copy(&P->x, x);
+  muBN_copy(&P->y, y);
+  muBN_copy(&P->z, &ctx->one);
+  if (!muEC_is_on_curve(ctx, P, temp)) {
+    muEC_set_infinity(ctx, P);
+    return 0;
+  }
+  return 1;
+}
+
+muBN_word_t muEC_get_affine(muEC_ctx_t *ctx, muBN_t *x, muBN_t *y, muEC_point_t *P,
+                            muBN_uword_t *temp) {
+  muEC_point_t  T;
+
+  if (muEC_is_infinity(ctx, P)) {
+    muBN_zero(x);
+    muBN_zero(y);
+    return 0;
+  }
+  muBN_init(&T.x, F(0), ctx->wlen);
+  muBN_init(&T.y, F(1), ctx->wlen);
+  muBN_init(&T.z, F(2), ctx->wlen);
+  muEC_copy(&T, P);
+  muEC_normalize(ctx, &T, F(3));
+  muBN_copy(x, &T.x);
+  muBN_copy(y, &T.y);
+  return 1;
+}
+
+/* (X,Y,Z) = (X.zi², Y.zi³, 1) */
+static void muEC_scale(muEC_ctx_t *ctx, muEC_point_t *P, muBN_t *zi, muBN_uword_t *temp) {
+  muBN_t  zi2, t;
+
+  muBN_init(&zi2, F(0), ctx->wlen);
+  muBN_init(&t,   F(1), ctx->wlen);
+  muEC_fsqr(ctx, &zi2, zi, F(2));
+  muEC_fmul(ctx, &t, &P->x, &zi2);
+  muBN_copy(&P->x, &t);
+  muEC_fmul(ctx, &t, &zi2, zi);
+  muEC_fmul(ctx, &zi2, &P->y, &t);
+  muBN_copy(&P->y, &zi2);
+  muBN_copy(&P->z, &ctx->one);
+}
+
+void muEC_normalize(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *temp) {
+  muBN_t  zi;
+
+  if (muEC_is_infinity(ctx, P)) {
+    return;
+  }
+  muBN_init(&zi, F(0), ctx->wlen);
+  muEC_finv(ctx, &zi, &P->z, F(1));
+  muEC_scale(ctx, P, &zi, F(1));
+}
+
+/* P[i] if P is given, else a view V on the i-th point of tab, stored x,y,z */
+static muEC_point_t *muEC_nth(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *tab,
+                              muBN_size_t i, muEC_point_t *V) {
+  if (P) {
+    return &P[i];
+  }
+  tab += (uint32_t)i*ctx->wlen*3;
+  muBN_init(&V->x, tab,             ctx->wlen);
+  muBN_init(&V->y, tab+ctx->wlen,   ctx->wlen);
+  muBN_init(&V->z, tab+ctx->wlen*2, ctx->wlen);
+  return V;
+}
+
+/* Montgomery's simultaneous inversion over the points of P, or of tab */
+static void muEC_normalize_all(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *tab,
+                               muBN_size_t n, muBN_uword_t *temp) {
+  muEC_point_t  V, *Pi;
+  muBN_t        c, zi, t;
+  muBN_size_t   i, last;
+
+  //c[i] = z[0]...z[i], infinity skipped
+  last = -1;
+  for (i = 0; i < n; i++) {
+    muBN_init(&c, F(i), ctx->wlen);
+    Pi = muEC_nth(ctx, P, tab, i, &V);
+    if (muEC_is_infinity(ctx, Pi)) {
+      continue;
+    }
+    if (last < 0) {
+      muBN_copy(&c, &Pi->z);
+    } else {
+      muBN_init(&t, F(last), ctx->wlen);
+      muEC_fmul(ctx, &c, &t, &Pi->z);
+    }
+    last = i;
+  }
+  if (last < 0) {
+    return;
+  }
+
+  //zi = (z[0]...z[last])⁻¹, then walk back
+  muBN_init(&zi, F(n),   ctx->wlen);
+  muBN_init(&t,  F(n+1), ctx->wlen);
+  muBN_init(&c,  F(last), ctx->wlen);
+  muEC_finv(ctx, &zi, &c, F(n+1));
+  for (i = last; i >= 0; i--) {
+    if (muEC_is_infinity(ctx, muEC_nth(ctx, P, tab, i, &V))) {
+      continue;
+    }
+    //previous non infinity point
+    for (last = i-1; (last >= 0) && muEC_is_infinity(ctx, muEC_nth(ctx, P, tab, last, &V)); last--);
+    Pi = muEC_nth(ctx, P, tab, i, &V);
+    if (last >= 0) {
+      //z[i]⁻¹ = zi.c[last], zi = zi.z[i]
+      muBN_init(&c, F(last), ctx->wlen);
+      muEC_fmul(ctx, &t, &zi, &c);
+      muBN_init(&c, F(i), ctx->wlen);
+      muEC_fmul(ctx, &c, &zi, &Pi->z);
+      muBN_copy(&zi, &c);
+      muBN_init(&c, F(n+2), ctx->wlen);
+      muBN_copy(&c, &t);
+    } else {
+      muBN_init(&c, F(n+2), ctx->wlen);
+      muBN_copy(&c, &zi);
+    }
+    muEC_scale(ctx, Pi, &c, F(n+3));
+  }
+}
+
+void muEC_normalize_batch(muEC_ctx_t *ctx, muEC_point_t *P, muBN_size_t n,
+                          muBN_uword_t *temp) {
+  muEC_normalize_all(ctx, P, NULL, n, temp);
+}
+
+muBN_word_t muEC_is_on_curve(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *temp) {
+  muBN_t  z2, z4, l, r, t;
+
+  if (muEC_is_infinity(ctx, P)) {
+    return 1;
+  }
+  muBN_init(&z2, F(0), ctx->wlen);
+  muBN_init(&z4, F(1), ctx->wlen);
+  muBN_init(&l,  F(2), ctx->wlen);
+  muBN_init(&r,  F(3), ctx->wlen);
+  muBN_init(&t,  F(4), ctx->wlen);
+
+  //Y² = X³ + a.X.Z⁴ + b.Z⁶
+  muEC_fsqr(ctx, &z2, &P->z, F(5));
+  muEC_fsqr(ctx, &z4, &z2, F(5));
+  muEC_fsqr(ctx, &l, &P->y, F(5));
+  muEC_fsqr(ctx, &t, &P->x, F(5));
+  if (ctx->a == UEC_A_M3) {
+    muEC_fsub(ctx, &t, &t, &z4);
+    muEC_fsub(ctx, &t, &t, &z4);
+    muEC_fsub(ctx, &t, &t, &z4);
+  }
+  muEC_fmul(ctx, &r, &t, &P->x);
+  muEC_fmul(ctx, &t, &z4, &z2);
+  muEC_fmul(ctx, &z4, &t, &ctx->b);
+  muEC_fadd(ctx, &r, &r, &z4);
+  return muBN_ucmp(&l, &r) == 0;
+}
+
+/* ======================================================================================= */
+/*                                   Arithmetic                                            */
+/* ======================================================================================= */
+
+void muEC_neg(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P) {
+  muEC_copy(R, P);
+  if (!muBN_is_zero(&R->y)) {
+    muBN_sub(&R->y, &ctx->fp.m, &R->y);
+  }
+}
+
+void muEC_dbl(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muBN_uword_t *temp) {
+  muBN_t  x3, y3, z3, t0, t1, t2, t3;
+
+  muBN_init(&x3, F(0), ctx->wlen);
+  muBN_init(&y3, F(1), ctx->wlen);
+  muBN_init(&z3, F(2), ctx->wlen);
+  muBN_init(&t0, F(3), ctx->wlen);
+  muBN_init(&t1, F(4), ctx->wlen);
+  muBN_init(&t2, F(5), ctx->wlen);
+  muBN_init(&t3, F(6), ctx->wlen);
+
+  if (ctx->a == UEC_A_M3) {
+    //t0 = delta = Z1², t1 = gamma = Y1², t2 = beta = X1.gamma
+    muEC_fsqr(ctx, &t0, &P->z, F(7));
+    muEC_fsqr(ctx, &t1, &P->y, F(7));
+    muEC_fmul(ctx, &t2, &P->x, &t1);
+    //t3 = alpha = 3.(X1-delta).(X1+delta)
+    muEC_fsub(ctx, &x3, &P->x, &t0);
+    muEC_fadd(ctx, &y3, &P->x, &t0);
+    muEC_fmul(ctx, &t3, &x3, &y3);
+    muEC_fadd(ctx, &x3, &t3, &t3);
+    muEC_fadd(ctx, &t3, &t3, &x3);
+    //Z3 = (Y1+Z1)² - gamma - delta
+    muEC_fadd(ctx, &y3, &P->y, &P->z);
+    muEC_fsqr(ctx, &z3, &y3, F(7));
+    muEC_fsub(ctx, &z3, &z3, &t1);
+    muEC_fsub(ctx, &z3, &z3, &t0);
+    //X3 = alpha² - 8.beta
+    muEC_fadd(ctx, &t2, &t2, &t2);
+    muEC_fadd(ctx, &t2, &t2, &t2);
+    muEC_fsqr(ctx, &x3, &t3, F(7));
+    muEC_fsub(ctx, &x3, &x3, &t2);
+    muEC_fsub(ctx, &x3, &x3, &t2);
+    //Y3 = alpha.(4.beta - X3) - 8.gamma²
+    muEC_fsub(ctx, &t2, &t2, &x3);
+    muEC_fmul(ctx, &y3, &t3, &t2);
+    muEC_fsqr(ctx, &t0, &t1, F(7));
+    muEC_fadd(ctx, &t0, &t0, &t0);
+    muEC_fadd(ctx, &t0, &t0, &t0);
+    muEC_fadd(ctx, &t0, &t0, &t0);
+    muEC_fsub(ctx, &y3, &y3, &t0);
+  } else {
+    //Z3 = 2.Y1.Z1
+    muEC_fmul(ctx, &z3, &P->y, &P->z);
+    muEC_fadd(ctx, &z3, &z3, &z3);
+    //t0 = A = X1², t1 = B = Y1², t2 = C = B²
+    muEC_fsqr(ctx, &t0, &P->x, F(7));
+    muEC_fsqr(ctx, &t1, &P->y, F(7));
+    muEC_fsqr(ctx, &t2, &t1, F(7));
+    //t3 = D = 2.((X1+B)² - A - C)
+    muEC_fadd(ctx, &x3, &P->x, &t1);
+    muEC_fsqr(ctx, &t3, &x3, F(7));
+    muEC_fsub(ctx, &t3, &t3, &t0);
+    muEC_fsub(ctx, &t3, &t3, &t2);
+    muEC_fadd(ctx, &t3, &t3, &t3);
+    //t1 = E = 3.A, X3 = E² - 2.D
+    muEC_fadd(ctx, &t1, &t0, &t0);
+    muEC_fadd(ctx, &t1, &t1, &t0);
+    muEC_fsqr(ctx, &x3, &t1, F(7));
+    muEC_fsub(ctx, &x3, &x3, &t3);
+    muEC_fsub(ctx, &x3, &x3, &t3);
+    //Y3 = E.(D - X3) - 8.C
+    muEC_fsub(ctx, &t3, &t3, &x3);
+    muEC_fmul(ctx, &y3, &t1, &t3);
+    muEC_fadd(ctx, &t2, &t2, &t2);
+    muEC_fadd(ctx, &t2, &t2, &t2);
+    muEC_fadd(ctx, &t2, &t2, &t2);
+    muEC_fsub(ctx, &y3, &y3, &t2);
+  }
+  muBN_copy(&R->x, &x3);
+  muBN_copy(&R->y, &y3);
+  muBN_copy(&R->z, &z3);
+}
+
+/* Common tail of add and add_mixed, with H = U2-U1, r = S2-S1:
+ * X3 = r'² - J - 2V, Y3 = r'.(V - X3) - 2.S1.J, with r' = 2r, I = 4H², J = H.I, V = U1.I
+ * z3 is already computed, x3,y3 and t are free.
+ */
+static void muEC_add_tail(muEC_ctx_t *ctx, muEC_point_t *R,
+                          muBN_t *h, muBN_t *r, muBN_t *u1, muBN_t *s1,
+                          muBN_t *x3, muBN_t *y3, muBN_t *z3, muBN_t *t,
+                          muBN_uword_t *temp) {
+  //I = 4.H² in x3, J = H.I in y3, V = U1.I in t
+  muEC_fsqr(ctx, t, h, temp);
+  muEC_fadd(ctx, t, t, t);
+  muEC_fadd(ctx, x3, t, t);
+  muEC_fmul(ctx, y3, h, x3);
+  muEC_fmul(ctx, t, u1, x3);
+  //r = 2r, X3 = r² - J - 2V in x3
+  muEC_fadd(ctx, r, r, r);
+  muEC_fsqr(ctx, x3, r, temp);
+  muEC_fsub(ctx, x3, x3, y3);
+  muEC_fsub(ctx, x3, x3, t);
+  muEC_fsub(ctx, x3, x3, t);
+  //Y3 = r.(V - X3) - 2.S1.J
+  muEC_fmul(ctx, h, s1, y3);
+  muEC_fadd(ctx, h, h, h);
+  muEC_fsub(ctx, t, t, x3);
+  muEC_fmul(ctx, y3, r, t);
+  muEC_fsub(ctx, y3, y3, h);
+
+  muBN_copy(&R->x, x3);
+  muBN_copy(&R->y, y3);
+  muBN_copy(&R->z, z3);
+}
+
+void muEC_add_mixed(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muEC_point_t *Q,
+                    muBN_uword_t *temp) {
+  muBN_t  z1z1, u2, s2, h, r, x3, y3, z3, t;
+
+  if (muEC_is_infinity(ctx, Q)) {
+    muEC_copy(R, P);
+    return;
+  }
+  if (muEC_is_infinity(ctx, P)) {
+    muEC_copy(R, Q);
+    return;
+  }
+  muBN_init(&z1z1, F(0), ctx->wlen);
+  muBN_init(&u2,   F(1), ctx->wlen);
+  muBN_init(&s2,   F(2), ctx->wlen);
+  muBN_init(&h,    F(3), ctx->wlen);
+  muBN_init(&r,    F(4), ctx->wlen);
+  muBN_init(&x3,   F(5), ctx->wlen);
+  muBN_init(&y3,   F(6), ctx->wlen);
+  muBN_init(&z3,   F(7), ctx->wlen);
+  muBN_init(&t,    F(8), ctx->wlen);
+
+  //U2 = X2.Z1², S2 = Y2.Z1³
+  muEC_fsqr(ctx, &z1z1, &P->z, F(9));
+  muEC_fmul(ctx, &u2, &Q->x, &z1z1);
+  muEC_fmul(ctx, &t, &P->z, &z1z1);
+  muEC_fmul(ctx, &s2, &Q->y, &t);
+  //H = U2 - X1, r = S2 - Y1
+  muEC_fsub(ctx, &h, &u2, &P->x);
+  muEC_fsub(ctx, &r, &s2, &P->y);
+  if (muBN_is_zero(&h)) {
+    if (muBN_is_zero(&r)) {
+      muEC_dbl(ctx, R, P, temp);
+    } else {
+      muEC_set_infinity(ctx, R);
+    }
+    return;
+  }
+  //Z3 = (Z1+H)² - Z1Z1 - H²
+  muEC_fadd(ctx, &t, &P->z, &h);
+  muEC_fsqr(ctx, &z3, &t, F(9));
+  muEC_fsub(ctx, &z3, &z3, &z1z1);
+  muEC_fsqr(ctx, &t, &h, F(9));
+  muEC_fsub(ctx, &z3, &z3, &t);
+  //U1 = X1, S1 = Y1
+  muBN_copy(&u2, &P->x);
+  muBN_copy(&s2, &P->y);
+  muEC_add_tail(ctx, R, &h, &r, &u2, &s2, &x3, &y3, &z3, &t, F(9));
+}
+
+void muEC_add(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muEC_point_t *Q,
+              muBN_uword_t *temp) {
+  muBN_t  z1z1, z2z2, u1, u2, s1, s2, x3, y3, z3, t;
+
+  if (muEC_is_infinity(ctx, Q)) {
+    muEC_copy(R, P);
+    return;
+  }
+  if (muEC_is_infinity(ctx, P)) {
+    muEC_copy(R, Q);
+    return;
+  }
+  muBN_init(&z1z1, F(0), ctx->wlen);
+  muBN_init(&z2z2, F(1), ctx->wlen);
+  muBN_init(&u1,   F(2), ctx->wlen);
+  muBN_init(&u2,   F(3), ctx->wlen);
+  muBN_init(&s1,   F(4), ctx->wlen);
+  muBN_init(&s2,   F(5), ctx->wlen);
+  muBN_init(&x3,   F(6), ctx->wlen);
+  muBN_init(&y3,   F(7), ctx->wlen);
+  muBN_init(&z3,   F(8), ctx->wlen);
+  muBN_init(&t,    F(9), ctx->wlen);
+
+  //U1 = X1.Z2², U2 = X2.Z1², S1 = Y1.Z2³, S2 = Y2.Z1³
+  muEC_fsqr(ctx, &z1z1, &P->z, F(10));
+  muEC_fsqr(ctx, &z2z2, &Q->z, F(10));
+  muEC_fmul(ctx, &u1, &P->x, &z2z2);
+  muEC_fmul(ctx, &u2, &Q->x, &z1z1);
+  muEC_fmul(ctx, &t, &Q->z, &z2z2);
+  muEC_fmul(ctx, &s1, &P->y, &t);
+  muEC_fmul(ctx, &t, &P->z, &z1z1);
+  muEC_fmul(ctx, &s2, &Q->y, &t);
+  //H = U2 - U1 in u2, r = S2 - S1 in s2
+  muEC_fsub(ctx, &u2, &u2, &u1);
+  muEC_fsub(ctx, &s2, &s2, &s1);
+  if (muBN_is_zero(&u2)) {
+    if (muBN_is_zero(&s2)) {
+      muEC_dbl(ctx, R, P, temp);
+    } else {
+      muEC_set_infinity(ctx, R);
+    }
+    return;
+  }
+  //Z3 = ((Z1+Z2)² - Z1Z1 - Z2Z2).H
+  muEC_fadd(ctx, &t, &P->z, &Q->z);
+  muEC_fsqr(ctx, &x3, &t, F(10));
+  muEC_fsub(ctx, &x3, &x3, &z1z1);
+  muEC_fsub(ctx, &x3, &x3, &z2z2);
+  muEC_fmul(ctx, &z3, &x3, &u2);
+  muEC_add_tail(ctx, R, &u2, &s2, &u1, &s1, &x3, &y3, &z3, &t, F(10));
+}
+
+/* ======================================================================================= */
+/*                               Scalar multiplication                                     */
+/* ======================================================================================= */
+
+/* Window width of the scalar multiplications, a table holds the 2^(w-1) odd multiples */
+#define UEC_MUL_W       4
+#define UEC_MUL_TAB     (1<<(UEC_MUL_W-1))
+#define UEC_MUL_DIGITS  ((UEC_MAX_BITS+1+UEC_MUL_W-1)/UEC_MUL_W)
+
+/* Number of digits of muEC_recode for the ctx order */
+#define UEC_NB_DIGITS(ctx)  (((ctx)->nbits+1+UEC_MUL_W-1)/UEC_MUL_W)
+
+/* Regular odd recoding of k < n: k, or k+n if k is even, is written
+ * sum(d[i].2^(wi)) with d[i] odd in [-(2^w-1), 2^w-1] and d[last] > 0. Each step clears
+ * the w+1 low bits, sets bit w and shifts by w: the remaining number stays odd, and
+ * below 2^(nbits+1-wi).
+ * temp: 2*(wlen+1) words. Return the number of digits.
+ */
+static muBN_size_t muEC_recode(muEC_ctx_t *ctx, int8_t *d, muBN_t *k, muBN_uword_t *temp) {
+  muBN_t        kk, kn;
+  muBN_uword_t  low;
+  muBN_size_t   i, nd;
+
+  muBN_init(&kk, temp,             ctx->wlen+1);
+  muBN_init(&kn, temp+ctx->wlen+1, ctx->wlen+1);
+  muBN_copy(&kk, k);
+  muBN_copy(&kn, &ctx->n);
+  muBN_add(&kn, &kn, &kk);
+  muEC_fcmov(&kk, &kn, (kk.v[ctx->wlen]&1)^1);
+
+  nd = UEC_NB_DIGITS(ctx);
+  for (i = 0; i < nd-1; i++) {
+    low  = kk.v[ctx->wlen] & ((1<<(UEC_MUL_W+1))-1);
+    d[i] = (int8_t)((int)low - (1<<UEC_MUL_W));
+    kk.v[ctx->wlen] = (kk.v[ctx->wlen] & ~(muBN_uword_t)((1<<(UEC_MUL_W+1))-1)) | (1<<UEC_MUL_W);
+    muBN_urshift(&kk, UEC_MUL_W);
+  }
+  d[i] = (int8_t)kk.v[ctx->wlen];
+  muBN_zero(&kk);
+  muBN_zero(&kn);
+  return nd;
+}
+
+/* S = sign(d).T[(|d|-1)/2], d odd. Entry j of the table is x at tab+j*stride, then y.
+ * All the entries are read, S is normalized.
+ */
+static void muEC_select(muEC_ctx_t *ctx, muEC_point_t *S, const muBN_uword_t *tab,
+                        muBN_size_t stride, int8_t d, muBN_t *ny) {
+  muBN_uword_t  neg, idx, mask, j;
+  muBN_size_t   i, wlen;
+
+  wlen = ctx->wlen;
+  neg  = (muBN_uword_t)((uint8_t)d >> 7);
+  idx  = (muBN_uword_t)(((d ^ -(int8_t)neg) + (int8_t)neg - 1) >> 1);
+  for (j = 0; j < UEC_MUL_TAB; j++, tab += stride) {
+    mask = (muBN_uword_t)0 - (muBN_uword_t)(j == idx);
+    for (i = 0; i < wlen; i++) {
+      S->x.v[i] = (S->x.v[i] & ~mask) | (tab[i]      & mask);
+      S->y.v[i] = (S->y.v[i] & ~mask) | (tab[wlen+i] & mask);
+    }
+  }
+  muBN_copy(&S->z, &ctx->one);
+  muBN_sub(ny, &ctx->fp.m, &S->y);
+  muEC_fcmov(&S->y, ny, neg);
+}
+
+/* T[j] = (2j+1).P, j < UEC_MUL_TAB. temp: 3*wlen + tmp_pt */
+static void muEC_odd_multiples(muEC_ctx_t *ctx, muEC_point_t *T, muEC_point_t *P,
+                               muBN_uword_t *temp) {
+  muEC_point_t  P2;
+  muBN_size_t   j;
+
+  muEC_point_init(ctx, &P2, temp);
+  temp += ctx->wlen*3;
+  muEC_dbl(ctx, &P2, P, temp);
+  muEC_copy(&T[0], P);
+  for (j = 1; j < UEC_MUL_TAB; j++) {
+    muEC_add(ctx, &T[j], &T[j-1], &P2, temp);
+  }
+}
+
+void muEC_mul(muEC_ctx_t *ctx, muEC_point_t *R, muBN_t *k, muEC_point_t *P,
+              muBN_uword_t *temp) {
+  muEC_point_t  T[UEC_MUL_TAB], S;
+  muBN_t        ny;
+  muBN_uword_t  *t;
+  int8_t        d[UEC_MUL_DIGITS];
+  muBN_size_t   nd, i, j, wlen;
+
+  if (muEC_is_infinity(ctx, P)) {
+    muEC_set_infinity(ctx, R);
+    return;
+  }
+  wlen = ctx->wlen;
+  for (j = 0; j < UEC_MUL_TAB; j++) {
+    muEC_point_init(ctx, &T[j], temp+j*wlen*3);
+  }
+  t = temp + UEC_MUL_TAB*wlen*3;
+  muEC_point_init(ctx, &S, t);
+  muBN_init(&ny, t+wlen*3, wlen);
+  t += wlen*4;
+
+  nd = muEC_recode(ctx, d, k, t);
+  muEC_odd_multiples(ctx, T, P, t);
+  muEC_normalize_batch(ctx, T, UEC_MUL_TAB, t);
+
+  muEC_select(ctx, &S, temp, wlen*3, d[nd-1], &ny);
+  muEC_copy(R, &S);
+  for (i = nd-2; i >= 0; i--) {
+    for (j = 0; j < UEC_MUL_W; j++) {
+      muEC_dbl(ctx, R, R, t);
+    }
+    muEC_select(ctx, &S, temp, wlen*3, d[i], &ny);
+    muEC_add_mixed(ctx, R, R, &S, t);
+  }
+  for (i = 0; i < nd; i++) {
+    d[i] = 0;
+  }
+}
+
+/* ======================================================================================= */
+/*                                    Fixed base                                           */
+/* ======================================================================================= */
+
+uint32_t muEC_comb_wlen(muEC_ctx_t *ctx, muBN_size_t spacing) {
+  uint32_t nq;
+
+  if (spacing < 1) {
+    return 0;
+  }
+  nq = (UEC_NB_DIGITS(ctx)+spacing-1)/spacing;
+  return nq*UEC_MUL_TAB*2*(uint32_t)ctx->wlen;
+}
+
+muBN_word_t muEC_comb_init(muEC_ctx_t *ctx, muEC_comb_t *comb, muEC_point_t *P,
+                           muBN_size_t spacing, muBN_uword_t *buf, muBN_uword_t *temp) {
+  muEC_point_t  T[UEC_MUL_TAB], B;
+  muBN_uword_t  *t, *v;
+  muBN_size_t   q, i, j, wlen;
+
+  if ((spacing < 1) || muEC_is_infinity(ctx, P)) {
+    return 0;
+  }
+  wlen = ctx->wlen;
+  comb->v       = buf;
+  comb->spacing = spacing;
+  comb->nq      = (UEC_NB_DIGITS(ctx)+spacing-1)/spacing;
+  comb->tmp_mul = wlen*4 + ctx->tmp_pt;
+
+  for (j = 0; j < UEC_MUL_TAB; j++) {
+    muEC_point_init(ctx, &T[j], temp+j*wlen*3);
+  }
+  t = temp + UEC_MUL_TAB*wlen*3;
+  muEC_point_init(ctx, &B, t);
+  t += wlen*3;
+
+  //table q holds the odd multiples of B = 2^(w.spacing.q).P
+  muEC_copy(&B, P);
+  v = buf;
+  for (q = 0; q < comb->nq; q++) {
+    muEC_odd_multiples(ctx, T, &B, t);
+    muEC_normalize_batch(ctx, T, UEC_MUL_TAB, t);
+    for (j = 0; j < UEC_MUL_TAB; j++) {
+      for (i = 0; i < wlen; i++) {
+        v[i]      = T[j].x.v[i];
+        v[wlen+i] = T[j].y.v[i];
+      }
+      v += 2*wlen;
+    }
+    if (q+1 < comb->nq) {
+      for (i = 0; i < UEC_MUL_W*spacing; i++) {
+        muEC_dbl(ctx, &B, &B, t);
+      }
+    }
+  }
+  return 1;
+}
+
+void muEC_comb_mul(muEC_ctx_t *ctx, muEC_comb_t *comb, muEC_point_t *R, muBN_t *k,
+                   muBN_uword_t *temp) {
+  muEC_point_t  S;
+  muBN_t        ny;
+  muBN_uword_t  *t;
+  int8_t        d[UEC_MUL_DIGITS];
+  muBN_size_t   nd, r, q, i, wlen;
+
+  wlen = ctx->wlen;
+  muEC_point_init(ctx, &S, temp);
+  muBN_init(&ny, temp+wlen*3, wlen);
+  t = temp+wlen*4;
+
+  //k.P = sum_r 2^(w.r) sum_q d[q.spacing+r].2^(w.spacing.q).P
+  nd = muEC_recode(ctx, d, k, t);
+  muEC_set_infinity(ctx, R);
+  for (r = comb->spacing-1; r >= 0; r--) {
+    if (r != comb->spacing-1) {
+      for (i = 0; i < UEC_MUL_W; i++) {
+        muEC_dbl(ctx, R, R, t);
+      }
+    }
+    for (q = 0; q < comb->nq; q++) {
+      i = q*comb->spacing + r;
+      if (i < nd) {
+        muEC_select(ctx, &S, comb->v + (uint32_t)q*UEC_MUL_TAB*2*wlen, 2*wlen, d[i], &ny);
+        muEC_add_mixed(ctx, R, R, &S, t);
+      }
+    }
+  }
+  for (i = 0; i < nd; i++) {
+    d[i] = 0;
+  }
+}
+
+void muEC_comb_clear(muEC_ctx_t *ctx, muEC_comb_t *comb) {
+  uint32_t i, n;
+
+  n = comb->nq*UEC_MUL_TAB*2*(uint32_t)ctx->wlen;
+  for (i = 0; i < n; i++) {
+    comb->v[i] = 0;
+  }
+  comb->nq      = 0;
+  comb->spacing = 0;
+  comb->tmp_mul = 0;
+}
+
+/* ======================================================================================= */
+/*                                   Endomorphism                                          */
+/* ======================================================================================= */
+
+muBN_word_t muEC_has_endo(muEC_ctx_t *ctx) {
+  return !muBN_is_zero(&ctx->beta);
+}
+
+void muEC_endo(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muBN_uword_t *temp) {
+  muBN_t  x;
+
+  muBN_init(&x, temp, ctx->wlen);
+  muEC_fmul(ctx, &x, &ctx->beta, &P->x);
+  muEC_copy(R, P);
+  muBN_copy(&R->x, &x);
+}
+
+/* r = round(a.b / 2^shift), temp: a.wlen + b.wlen words */
+static void muEC_mul_round(muBN_t *r, muBN_t *a, muBN_t *b, muBN_size_t shift,
+                           muBN_uword_t *temp) {
+  muBN_t        ab;
+  muBN_uword_t  half;
+
+  muBN_init(&ab, temp, a->wlen+b->wlen);
+  muBN_mul(&ab, a, b);
+  half = (muBN_uword_t)muBN_test_bit(&ab, shift-1);
+  muBN_urshift(&ab, shift);
+  muBN_copy(r, &ab);
+  muBN_add_uword(r, r, half);
+  muBN_zero(&ab);
+}
+
+muBN_word_t muEC_glv_split(muEC_ctx_t *ctx, muBN_t *k1, muBN_t *k2, uint8_t *neg, muBN_t *k,
+                           muBN_uword_t *temp) {
+  muBN_t  c1, c2, t, g;
+
+  if (!muEC_has_endo(ctx)) {
+    return 0;
+  }
+  muBN_init(&c1, F(0), ctx->wlen);
+  muBN_init(&c2, F(1), ctx->wlen);
+  muBN_init(&t,  F(2), ctx->wlen);
+  muBN_init(&g,  F(3), ctx->wlen);
+
+  //c1 = round(k.b2/n), c2 = round(k.mb1/n)
+  muEC_load(&g, muEC_secp256k1_g1);
+  muEC_mul_round(&c1, k, &g, 384, F(4));
+  muEC_load(&g, muEC_secp256k1_g2);
+  muEC_mul_round(&c2, k, &g, 384, F(4));
+  //k2 = c1.mb1 - c2.b2, k1 = k - k2.lambda mod n
+  muEC_load(&g, muEC_secp256k1_mb1);
+  muBN_mod_mul(&t, &c1, &g, &ctx->n, F(4));
+  muEC_load(&g, muEC_secp256k1_b2);
+  muBN_mod_mul(&c1, &c2, &g, &ctx->n, F(4));
+  muBN_mod_sub(k2, &t, &c1, &ctx->n);
+  muEC_load(&g, muEC_secp256k1_lambda);
+  muBN_mod_mul(&t, k2, &g, &ctx->n, F(4));
+  muBN_mod_sub(k1, k, &t, &ctx->n);
+
+  //keep the representatives below n/2, below 2^128
+  muBN_copy(&t, &ctx->n);
+  muBN_urshift1(&t);
+  neg[0] = (muBN_ucmp(k1, &t) > 0);
+  neg[1] = (muBN_ucmp(k2, &t) > 0);
+  if (neg[0]) {
+    muBN_sub(k1, &ctx->n, k1);
+  }
+  if (neg[1]) {
+    muBN_sub(k2, &ctx->n, k2);
+  }
+  muBN_zero(&c1);
+  muBN_zero(&c2);
+  muBN_zero(&t);
+  return 1;
+}
+
+/* ======================================================================================= */
+/*                              Multi-scalar multiplication                                */
+/* ======================================================================================= */
+
+/* Word length of a buffer of 'bytes' bytes */
+#define UEC_BYTES2WORDS(bytes)  (((bytes)+sizeof(muBN_uword_t)-1)/sizeof(muBN_uword_t))
+
+/* Bucket states of the Pippenger accumulation */
+#define UEC_BKT_EMPTY  0
+#define UEC_BKT_SET    1
+#define UEC_BKT_BUSY   2       /* set, and target of a pending addition */
+
+/* Pending addition code of a bucket doubling, else point index*2 + sign */
+#define UEC_MSM_DBL    0xFFFFFFFFUL
+
+/* Terms of the sum: k[i],P[i] from the caller arrays, or packed in ktab (wlen words
+ * each) and ptab (x,y,z)
+ */
+typedef struct {
+  muBN_t        *k;
+  muEC_point_t  *P;
+  muBN_uword_t  *ktab;
+  muBN_uword_t  *ptab;
+  muBN_size_t   n;
+  uint8_t       endo;    /* P[2i+1] = ±lambda.P[2i] */
+} muEC_msm_in_t;
+
+static muBN_t *muEC_msm_k(muEC_ctx_t *ctx, muEC_msm_in_t *in, muBN_size_t i, muBN_t *V) {
+  if (in->k) {
+    return &in->k[i];
+  }
+  muBN_init(V, in->ktab + (uint32_t)i*ctx->wlen, ctx->wlen);
+  return V;
+}
+
+/* Read the 'c' bits of k starting at bit 'pos', bits above k are 0 */
+static uint32_t muEC_bits(muBN_t *k, muBN_size_t pos, muBN_size_t c) {
+  uint32_t d;
+
+  d = 0;
+  while (c--) {
+    d <<= 1;
+    if ((uint32_t)(pos+c) < (uint32_t)k->wlen*UBN_BITS_PER_WORD) {
+      d |= (uint32_t)muBN_test_bit(k, pos+c);
+    }
+  }
+  return d;
+}
+
+/* Width UEC_MUL_W+1 NAF of k < 2^bits: k = sum(d[i].2^i), i <= bits, the non zero
+ * digits are odd in [-(2^w-1), 2^w-1] and followed by at least w zeros.
+ */
+static void muEC_wnaf(int8_t *d, muBN_t *k, muBN_size_t bits) {
+  muBN_size_t  i, c;
+  uint32_t     carry, word;
+
+  for (i = 0; i <= bits; i++) {
+    d[i] = 0;
+  }
+  carry = 0;
+  i     = 0;
+  while (i <= bits) {
+    if (muEC_bits(k, i, 1) == carry) {
+      i++;
+      continue;
+    }
+    c = bits+1-i;
+    if (c > UEC_MUL_W+1) {
+      c = UEC_MUL_W+1;
+    }
+    word  = muEC_bits(k, i, c) + carry;
+    carry = (word >> UEC_MUL_W) & 1;
+    d[i]  = (int8_t)((int32_t)word - (int32_t)(carry << (UEC_MUL_W+1)));
+    i += c;
+  }
+}
+
+/* Signed windows of c bits of k < 2^bits: k = sum(d[j].2^(cj)), j < nw = (bits+c)/c,
+ * d[j] in [-2^(c-1)+1, 2^(c-1)].
+ */
+static void muEC_sdigits(int16_t *d, muBN_t *k, muBN_size_t nw, muBN_size_t c) {
+  muBN_size_t  j;
+  uint32_t     carry, word;
+
+  carry = 0;
+  for (j = 0; j < nw; j++) {
+    word  = muEC_bits(k, j*c, c) + carry;
+    carry = (word > ((uint32_t)1 << (c-1)));
+    d[j]  = (int16_t)((int32_t)word - (int32_t)(carry << c));
+  }
+}
+
+/* Pippenger window width for n points. Rough cost in field products, per window:
+ * 6 per point for the batched affine additions, 27 per bucket for their sum.
+ */
+static muBN_size_t muEC_msm_window(muEC_ctx_t *ctx, muBN_size_t n) {
+  uint64_t     cost, best;
+  muBN_size_t  c, w;
+
+  best = 0;
+  w    = 2;
+  for (c = 2; c <= UEC_MSM_WINDOW_MAX; c++) {
+    cost = (uint64_t)((ctx->nbits+c)/c) * (6*(uint64_t)n + 27*((uint64_t)1 << (c-1)));
+    if ((best == 0) || (cost < best)) {
+      best = cost;
+      w    = c;
+    }
+  }
+  return w;
+}
+
+static uint32_t muEC_msm_core_tmp(muEC_ctx_t *ctx, muBN_size_t n) {
+  uint32_t  wlen, nn, nb, nw, a, b;
+  muBN_size_t c;
+
+  wlen = (uint32_t)ctx->wlen;
+  nn   = (uint32_t)n;
+  if (n <= UEC_MSM_STRAUS_MAX) {
+    //accumulator, tables, digits, -y, then the tables setup or the additions
+    a = wlen*3 + ctx->tmp_pt;
+    b = ctx->tmp_inv + nn*UEC_MUL_TAB*wlen;
+    return wlen*3 + nn*UEC_MUL_TAB*wlen*3 + UEC_BYTES2WORDS(nn*(ctx->nbits+1)) + wlen +
+      ((a > b) ? a : b);
+  }
+  c  = muEC_msm_window(ctx, n);
+  nb = (uint32_t)1 << (c-1);
+  nw = (uint32_t)(ctx->nbits+c)/c;
+  //buckets, pending denominators, states, S, T and the field temps, or the normalization
+  a = nb*wlen*2 + UEC_MSM_BATCH*wlen*2 + UEC_BYTES2WORDS(nb) + wlen*(6+5) +
+    ((ctx->tmp_inv > ctx->tmp_pt) ? ctx->tmp_inv : ctx->tmp_pt);
+  b = ctx->tmp_inv + nn*wlen;
+  //accumulator, additions indexes, digits, normalized points
+  return wlen*3 + UEC_BYTES2WORDS(UEC_MSM_BATCH*4*sizeof(uint32_t)) +
+    UEC_BYTES2WORDS(nn*nw*sizeof(int16_t)) + nn*wlen*3 + ((a > b) ? a : b);
+}
+
+/* A = sum(k[i].P[i]), interleaved wNAF */
+static void muEC_msm_straus(muEC_ctx_t *ctx, muEC_point_t *A, muEC_msm_in_t *in,
+                            muBN_size_t bits, muBN_uword_t *temp) {
+  muEC_point_t  T[UEC_MUL_TAB], S, V, *P;
+  muBN_uword_t  *tab, *t;
+  muBN_t        ny, kv;
+  int8_t        *d, di;
+  muBN_size_t   n, i, j, b, wlen;
+
+  wlen = ctx->wlen;
+  n    = in->n;
+  tab  = temp;
+  d    = (int8_t*)(temp + (uint32_t)n*UEC_MUL_TAB*wlen*3);
+  t    = temp + (uint32_t)n*UEC_MUL_TAB*wlen*3 + UEC_BYTES2WORDS((uint32_t)n*(ctx->nbits+1));
+  muBN_init(&ny, t, wlen);
+  t += wlen;
+
+  //odd multiples of every P[i], normalized all together
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < UEC_MUL_TAB; j++) {
+      muEC_point_init(ctx, &T[j], tab + ((uint32_t)i*UEC_MUL_TAB+j)*wlen*3);
+    }
+    P = muEC_nth(ctx, in->P, in->ptab, i, &V);
+    if (muEC_is_infinity(ctx, P)) {
+      for (b = 0; b <= bits; b++) {
+        d[(uint32_t)i*(bits+1)+b] = 0;
+      }
+      continue;
+    }
+    if (in->endo && (i & 1)) {
+      //±lambda times the previous table, one product per entry
+      muEC_nth(ctx, in->P, in->ptab, i-1, &S);
+      b = (muBN_ucmp(&P->y, &S.y) != 0);
+      for (j = 0; j < UEC_MUL_TAB; j++) {
+        muEC_endo(ctx, &T[j], muEC_nth(ctx, NULL, tab, (i-1)*UEC_MUL_TAB+j, &S), t);
+        if (b) {
+          muEC_neg(ctx, &T[j], &T[j]);
+        }
+      }
+    } else {
+      muEC_odd_multiples(ctx, T, P, t);
+    }
+    muEC_wnaf(d + (uint32_t)i*(bits+1), muEC_msm_k(ctx, in, i, &kv), bits);
+  }
+  muEC_normalize_all(ctx, NULL, tab, n*UEC_MUL_TAB, t);
+
+  muEC_set_infinity(ctx, A);
+  for (b = bits; b >= 0; b--) {
+    if (!muEC_is_infinity(ctx, A)) {
+      muEC_dbl(ctx, A, A, t);
+    }
+    for (i = 0; i < n; i++) {
+      di = d[(uint32_t)i*(bits+1)+b];
+      if (di == 0) {
+        continue;
+      }
+      if (di > 0) {
+        muEC_nth(ctx, NULL, tab, i*UEC_MUL_TAB + (di-1)/2, &S);
+      } else {
+        muEC_nth(ctx, NULL, tab, i*UEC_MUL_TAB + (-di-1)/2, &S);
+        muBN_sub(&ny, &ctx->fp.m, &S.y);
+        S.y = ny;
+      }
+      muEC_add_mixed(ctx, A, A, &S, t);
+    }
+  }
+}
+
+/* Pippenger state: affine buckets, filled by batches of affine additions sharing one
+ * inversion. A bucket is the target of at most one pending addition, the additions to
+ * a busy bucket wait in a queue.
+ */
+typedef struct {
+  muEC_ctx_t    *ctx;
+  muBN_uword_t  *pts;     /* normalized points, x,y,z               */
+  muBN_uword_t  *bkt;     /* bucket coordinates, x,y                */
+  uint8_t       *st;      /* bucket UEC_BKT_xxx states              */
+  muBN_uword_t  *den;     /* denominators of the pending additions  */
+  muBN_uword_t  *pre;     /* and their prefix products              */
+  uint32_t      *eb;      /* pending additions, bucket              */
+  uint32_t      *ep;      /* and code                               */
+  uint32_t      *qb;      /* queued additions, bucket               */
+  uint32_t      *qp;      /* and code                               */
+  muBN_size_t   ne;
+  muBN_size_t   nq;
+  muBN_uword_t  *temp;    /* 5 field elements, then ctx->tmp_inv    */
+} muEC_msm_t;
+
+static void muEC_msm_bucket(muEC_msm_t *s, uint32_t b, muBN_t *x, muBN_t *y) {
+  muBN_size_t wlen = s->ctx->wlen;
+
+  muBN_init(x, s->bkt + b*wlen*2,      wlen);
+  muBN_init(y, s->bkt + b*wlen*2+wlen, wlen);
+}
+
+static void muEC_msm_point(muEC_msm_t *s, uint32_t code, muBN_t *x, muBN_t *y) {
+  muBN_size_t wlen = s->ctx->wlen;
+
+  muBN_init(x, s->pts + (code>>1)*wlen*3,      wlen);
+  muBN_init(y, s->pts + (code>>1)*wlen*3+wlen, wlen);
+}
+
+/* Perform the pending additions: lambda = (yp-yb)/(xp-xb), or (3.xb²+a)/2.yb for a
+ * doubling, xb = lambda² - xb - xp, yb = lambda.(xb - x3) - yb
+ */
+static void muEC_msm_flush(muEC_msm_t *s) {
+  muEC_ctx_t    *ctx;
+  muBN_uword_t  *temp;
+  muBN_t        xb, yb, xp, yp, den, pre, zi, inv, lam, t, x3;
+  muBN_size_t   e, wlen;
+
+  if (s->ne == 0) {
+    return;
+  }
+  ctx  = s->ctx;
+  temp = s->temp;
+  wlen = ctx->wlen;
+  muBN_init(&zi,  F(0), wlen);
+  muBN_init(&inv, F(1), wlen);
+  muBN_init(&lam, F(2), wlen);
+  muBN_init(&t,   F(3), wlen);
+  muBN_init(&x3,  F(4), wlen);
+
+  //pre[e] = den[0]...den[e]
+  for (e = 0; e < s->ne; e++) {
+    muEC_msm_bucket(s, s->eb[e], &xb, &yb);
+    muBN_init(&den, s->den + (uint32_t)e*wlen, wlen);
+    muBN_init(&pre, s->pre + (uint32_t)e*wlen, wlen);
+    if (s->ep[e] == UEC_MSM_DBL) {
+      muEC_fadd(ctx, &den, &yb, &yb);
+    } else {
+      muEC_msm_point(s, s->ep[e], &xp, &yp);
+      muEC_fsub(ctx, &den, &xp, &xb);
+    }
+    if (e == 0) {
+      muBN_copy(&pre, &den);
+    } else {
+      muBN_init(&t, s->pre + (uint32_t)(e-1)*wlen, wlen);
+      muEC_fmul(ctx, &pre, &t, &den);
+    }
+  }
+  muBN_init(&t,   F(3), wlen);
+  muBN_init(&pre, s->pre + (uint32_t)(s->ne-1)*wlen, wlen);
+  muEC_finv(ctx, &zi, &pre, F(5));
+
+  for (e = s->ne-1; e >= 0; e--) {
+    //inv = den[e]⁻¹ = zi.pre[e-1], zi = zi.den[e]
+    muBN_init(&den, s->den + (uint32_t)e*wlen, wlen);
+    if (e > 0) {
+      muBN_init(&pre, s->pre + (uint32_t)(e-1)*wlen, wlen);
+      muEC_fmul(ctx, &inv, &zi, &pre);
+      muEC_fmul(ctx, &t, &zi, &den);
+      muBN_copy(&zi, &t);
+    } else {
+      muBN_copy(&inv, &zi);
+    }
+    muEC_msm_bucket(s, s->eb[e], &xb, &yb);
+    if (s->ep[e] == UEC_MSM_DBL) {
+      muEC_fsqr(ctx, &t, &xb, F(5));
+      muEC_fadd(ctx, &lam, &t, &t);
+      muEC_fadd(ctx, &t, &t, &lam);
+      if (ctx->a == UEC_A_M3) {
+        muEC_fsub(ctx, &t, &t, &ctx->one);
+        muEC_fsub(ctx, &t, &t, &ctx->one);
+        muEC_fsub(ctx, &t, &t, &ctx->one);
+      }
+      xp = xb;
+    } else {
+      //-P: lambda = -(yp+yb)/den, its sign only matters for y3
+      muEC_msm_point(s, s->ep[e], &xp, &yp);
+      if (s->ep[e] & 1) {
+        muEC_fadd(ctx, &t, &yp, &yb);
+      } else {
+        muEC_fsub(ctx, &t, &yp, &yb);
+      }
+    }
+    muEC_fmul(ctx, &lam, &t, &inv);
+    muEC_fsqr(ctx, &x3, &lam, F(5));
+    muEC_fsub(ctx, &x3, &x3, &xb);
+    muEC_fsub(ctx, &x3, &x3, &xp);
+    if ((s->ep[e] != UEC_MSM_DBL) && (s->ep[e] & 1)) {
+      muEC_fsub(ctx, &t, &x3, &xb);
+    } else {
+      muEC_fsub(ctx, &t, &xb, &x3);
+    }
+    muEC_fmul(ctx, &inv, &lam, &t);
+    muEC_fsub(ctx, &yb, &inv, &yb);
+    muBN_copy(&xb, &x3);
+    s->st[s->eb[e]] = UEC_BKT_SET;
+  }
+  s->ne = 0;
+}
+
+/* bucket b += (-1)^code.P[code/2], return 0 if b is busy */
+static muBN_word_t muEC_msm_push(muEC_msm_t *s, uint32_t b, uint32_t code) {
+  muEC_ctx_t  *ctx;
+  muBN_t      xb, yb, xp, yp, y;
+
+  if (s->st[b] == UEC_BKT_BUSY) {
+    return 0;
+  }
+  ctx = s->ctx;
+  muEC_msm_bucket(s, b, &xb, &yb);
+  muEC_msm_point(s, code, &xp, &yp);
+  muBN_init(&y, s->temp, ctx->wlen);
+  muBN_copy(&y, &yp);
+  if (code & 1) {
+    muBN_sub(&y, &ctx->fp.m, &yp);
+  }
+  if (s->st[b] == UEC_BKT_EMPTY) {
+    muBN_copy(&xb, &xp);
+    muBN_copy(&yb, &y);
+    s->st[b] = UEC_BKT_SET;
+    return 1;
+  }
+  if (muBN_ucmp(&xb, &xp) == 0) {
+    if (muBN_ucmp(&yb, &y) != 0) {
+      s->st[b] = UEC_BKT_EMPTY;
+      return 1;
+    }
+    code = UEC_MSM_DBL;
+  }
+  s->eb[s->ne] = b;
+  s->ep[s->ne] = code;
+  s->ne++;
+  s->st[b] = UEC_BKT_BUSY;
+  if (s->ne == UEC_MSM_BATCH) {
+    muEC_msm_flush(s);
+  }
+  return 1;
+}
+
+/* Flush the pending additions, then retry the queued ones */
+static void muEC_msm_drain(muEC_msm_t *s) {
+  muBN_size_t j, nq;
+
+  muEC_msm_flush(s);
+  nq = 0;
+  for (j = 0; j < s->nq; j++) {
+    if (!muEC_msm_push(s, s->qb[j], s->qp[j])) {
+      s->qb[nq] = s->qb[j];
+      s->qp[nq] = s->qp[j];
+      nq++;
+    }
+  }
+  s->nq = nq;
+}
+
+static void muEC_msm_add(muEC_msm_t *s, uint32_t b, uint32_t code) {
+  while (!muEC_msm_push(s, b, code)) {
+    if (s->nq < UEC_MSM_BATCH) {
+      s->qb[s->nq] = b;
+      s->qp[s->nq] = code;
+      s->nq++;
+      return;
+    }
+    muEC_msm_drain(s);
+  }
+}
+
+/* A = sum(k[i].P[i]), Pippenger buckets */
+static void muEC_msm_pippenger(muEC_ctx_t *ctx, muEC_point_t *A, muEC_msm_in_t *in,
+                               muBN_size_t bits, muBN_uword_t *temp) {
+  muEC_msm_t    s;
+  muEC_point_t  V, S, T, *P;
+  muBN_t        kv;
+  int16_t       *d, di;
+  muBN_uword_t  *t;
+  uint32_t      nb, b;
+  muBN_size_t   n, c, nw, i, j, wlen;
+
+  wlen = ctx->wlen;
+  n    = in->n;
+  c    = muEC_msm_window(ctx, n);
+  nb   = (uint32_t)1 << (c-1);
+  nw   = (bits+c)/c;
+
+  //pending and queued additions, digits of k[i], normalized copies of P[i]
+  s.ctx  = ctx;
+  s.eb   = (uint32_t*)temp;
+  s.ep   = s.eb + UEC_MSM_BATCH;
+  s.qb   = s.ep + UEC_MSM_BATCH;
+  s.qp   = s.qb + UEC_MSM_BATCH;
+  t      = temp + UEC_BYTES2WORDS(UEC_MSM_BATCH*4*sizeof(uint32_t));
+  d      = (int16_t*)t;
+  t     += UEC_BYTES2WORDS((uint32_t)n*((ctx->nbits+c)/c)*sizeof(int16_t));
+  s.pts  = t;
+  t     += (uint32_t)n*wlen*3;
+  for (i = 0; i < n; i++) {
+    P = muEC_nth(ctx, in->P, in->ptab, i, &S);
+    muEC_copy(muEC_nth(ctx, NULL, s.pts, i, &V), P);
+    if (muEC_is_infinity(ctx, P)) {
+      for (j = 0; j < nw; j++) {
+        d[(uint32_t)i*nw+j] = 0;
+      }
+      continue;
+    }
+    muEC_sdigits(d + (uint32_t)i*nw, muEC_msm_k(ctx, in, i, &kv), nw, c);
+  }
+  muEC_normalize_all(ctx, NULL, s.pts, n, t);
+
+  s.bkt  = t;
+  t     += nb*wlen*2;
+  s.den  = t;
+  s.pre  = t + UEC_MSM_BATCH*wlen;
+  t     += UEC_MSM_BATCH*wlen*2;
+  s.st   = (uint8_t*)t;
+  t     += UEC_BYTES2WORDS(nb);
+  muEC_point_init(ctx, &S, t);
+  muEC_point_init(ctx, &T, t+wlen*3);
+  s.temp = t + wlen*6;
+  s.ne   = 0;
+  s.nq   = 0;
+  muBN_init(&V.z, ctx->one.v, wlen);
+
+  muEC_set_infinity(ctx, A);
+  for (j = nw-1; j >= 0; j--) {
+    if (!muEC_is_infinity(ctx, A)) {
+      for (i = 0; i < c; i++) {
+        muEC_dbl(ctx, A, A, s.temp);
+      }
+    }
+    //buckets[b] = sum of the P[i] with a digit ±(b+1)
+    for (b = 0; b < nb; b++) {
+      s.st[b] = UEC_BKT_EMPTY;
+    }
+    for (i = 0; i < n; i++) {
+      di = d[(uint32_t)i*nw+j];
+      if (di > 0) {
+        muEC_msm_add(&s, (uint32_t)(di-1), (uint32_t)i<<1);
+      } else if (di < 0) {
+        muEC_msm_add(&s, (uint32_t)(-di-1), ((uint32_t)i<<1)|1);
+      }
+    }
+    while (s.nq > 0) {
+      muEC_msm_drain(&s);
+    }
+    muEC_msm_flush(&s);
+
+    //sum((b+1).buckets[b]) as running sums
+    muEC_set_infinity(ctx, &S);
+    muEC_set_infinity(ctx, &T);
+    for (b = nb; b-- > 0; ) {
+      if (s.st[b] != UEC_BKT_EMPTY) {
+        muEC_msm_bucket(&s, b, &V.x, &V.y);
+        muEC_add_mixed(ctx, &S, &S, &V, s.temp);
+      }
+      muEC_add(ctx, &T, &T, &S, s.temp);
+    }
+    muEC_add(ctx, A, A, &T, s.temp);
+  }
+}
+
+/* R = sum(k[i].P[i]) */
+static void muEC_msm_core(muEC_ctx_t *ctx, muEC_point_t *R, muEC_msm_in_t *in,
+                          muBN_uword_t *temp) {
+  muEC_point_t  A;
+  muBN_t        kv;
+  muBN_size_t   i, bits, b;
+
+  bits = 0;
+  for (i = 0; i < in->n; i++) {
+    b = muBN_count_bit(muEC_msm_k(ctx, in, i, &kv));
+    if (b > bits) {
+      bits = b;
+    }
+  }
+  muEC_point_init(ctx, &A, temp);
+  if (bits > 0) {
+    if (in->n <= UEC_MSM_STRAUS_MAX) {
+      muEC_msm_straus(ctx, &A, in, bits, temp+ctx->wlen*3);
+    } else {
+      muEC_msm_pippenger(ctx, &A, in, bits, temp+ctx->wlen*3);
+    }
+  }
+  muEC_copy(R, &A);
+}
+
+uint32_t muEC_msm_tmp(muEC_ctx_t *ctx, muBN_size_t n) {
+  uint32_t  a;
+
+  if (!muEC_has_endo(ctx) || (n > UEC_MSM_STRAUS_MAX/2)) {
+    return muEC_msm_core_tmp(ctx, n);
+  }
+  //2n scalars and points, then the split or the sum
+  a = muEC_msm_core_tmp(ctx, 2*n);
+  if (a < (uint32_t)ctx->tmp_pt) {
+    a = (uint32_t)ctx->tmp_pt;
+  }
+  return (uint32_t)n*2*ctx->wlen*4 + a;
+}
+
+void muEC_msm(muEC_ctx_t *ctx, muEC_point_t *R, muBN_t *k, muEC_point_t *P, muBN_size_t n,
+              muBN_uword_t *temp) {
+  muEC_msm_in_t  in;
+  muEC_point_t   Q1, Q2;
+  muBN_t         k1, k2;
+  uint8_t        neg[2];
+  muBN_size_t    i, wlen;
+
+  in.k    = k;
+  in.P    = P;
+  in.ktab = NULL;
+  in.ptab = NULL;
+  in.n    = n;
+  in.endo = 0;
+  if (!muEC_has_endo(ctx) || (n > UEC_MSM_STRAUS_MAX/2)) {
+    muEC_msm_core(ctx, R, &in, temp);
+    return;
+  }
+
+  //k[i].P[i] = k1.(±P[i]) + k2.(±lambda.P[i]), k1 and k2 on half the bits. Only for
+  //interleaved wNAF: with buckets, twice the points make up for half the bits
+  wlen    = ctx->wlen;
+  in.k    = NULL;
+  in.P    = NULL;
+  in.ktab = temp;
+  in.ptab = temp + (uint32_t)n*2*wlen;
+  in.n    = 2*n;
+  in.endo = 1;
+  temp   += (uint32_t)n*2*wlen*4;
+  for (i = 0; i < n; i++) {
+    muEC_msm_k(ctx, &in, 2*i,   &k1);
+    muEC_msm_k(ctx, &in, 2*i+1, &k2);
+    muEC_nth(ctx, NULL, in.ptab, 2*i,   &Q1);
+    muEC_nth(ctx, NULL, in.ptab, 2*i+1, &Q2);
+    muEC_glv_split(ctx, &k1, &k2, neg, &k[i], temp);
+    muEC_endo(ctx, &Q2, &P[i], temp);
+    muEC_copy(&Q1, &P[i]);
+    if (neg[0]) {
+      muEC_neg(ctx, &Q1, &Q1);
+    }
+    if (neg[1]) {
+      muEC_neg(ctx, &Q2, &Q2);
+    }
+  }
+  muEC_msm_core(ctx, R, &in, temp);
+}
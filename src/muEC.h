@@ -0,0 +1,476 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef muEC_H
+#define muEC_H
+
+/*
+ * Short Weierstrass curves y² = x³ + ax + b over GF(p), on top of the muBN
+ * field arithmetic of the registry primes (muBN_fe_xxx).
+ *
+ * Points are kept in Jacobian coordinates (X,Y,Z), standing for the
+ * affine point (X/Z², Y/Z³), with the three coordinates as plain numbers
+ * mod p. Z = 0 is the point at infinity. A point with Z = 1 is said
+ * normalized, its X,Y are the affine coordinates.
+ *
+ * As for muBN, all storage is provided by the caller: the context and the
+ * points are views on caller buffers, each call gets a temp buffer of the
+ * documented tmp_xxx word length.
+ */
+
+#include "muBN.h"
+
+/* Word length of a number of 'bits' bits */
+#define UEC_WLEN(bits)           (((bits)+UBN_BITS_PER_WORD-1)/UBN_BITS_PER_WORD)
+
+/* Largest field and order size of the supported curves */
+#define UEC_MAX_BITS             384
+#define UEC_MAX_WLEN             UEC_WLEN(UEC_MAX_BITS)
+
+/* Largest number of points for which muEC_msm interleaves wNAF (Straus),
+ * Pippenger buckets are used above */
+#ifndef UEC_MSM_STRAUS_MAX
+#define UEC_MSM_STRAUS_MAX       64
+#endif
+
+/* Number of affine bucket additions sharing one inversion in muEC_msm */
+#ifndef UEC_MSM_BATCH
+#define UEC_MSM_BATCH            64
+#endif
+
+/* Max Pippenger window width of muEC_msm, drives the temp size */
+#ifndef UEC_MSM_WINDOW_MAX
+#define UEC_MSM_WINDOW_MAX       15
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Supported curves
+ */
+enum {
+  UEC_P256,        /* NIST P-256, secp256r1 */
+  UEC_P384,        /* NIST P-384, secp384r1 */
+  UEC_SECP256K1    /* SEC 2 secp256k1       */
+};
+
+/**
+ * Curve coefficient a, selects the doubling formula
+ */
+enum {
+  UEC_A_M3,        /* a = -3 */
+  UEC_A_0          /* a = 0  */
+};
+
+/**
+ * Curve context, computed once by muEC_ctx_init.
+ * Read only once initialized, it can be shared.
+ */
+typedef struct {
+  muBN_fe_ctx_t   fp;       /* field GF(p)                              */
+  muBN_t          one;      /* 1                                        */
+  muBN_t          b;        /* b                                        */
+  muBN_t          gx;       /* Gx                                       */
+  muBN_t          gy;       /* Gy                                       */
+  muBN_t          n;        /* order of G                               */
+  muBN_t          beta;     /* beta of the endomorphism, else 0         */
+  muBN_size_t     wlen;     /* p and n word length                      */
+  muBN_size_t     nbits;    /* bit length of n                          */
+  muBN_size_t     tmp_pt;   /* temp word length for dbl, add, on_curve  */
+  muBN_size_t     tmp_inv;  /* temp word length for normalize, affine   */
+  muBN_size_t     tmp_mul;  /* temp word length for mul                 */
+  uint8_t         curve;    /* UEC_xxx curve                            */
+  uint8_t         a;        /* UEC_A_xxx                                */
+} muEC_ctx_t;
+
+/**
+ * Jacobian point, the coordinates have the ctx word-length
+ */
+typedef struct {
+  muBN_t  x;
+  muBN_t  y;
+  muBN_t  z;
+} muEC_point_t;
+
+/**
+ * Fixed base tables of a point P, see muEC_comb_init.
+ * Table q holds the 8 odd multiples of 2^(4.spacing.q).P, normalized,
+ * each one as x then y.
+ */
+typedef struct {
+  muBN_uword_t  *v;        /* nq tables, caller storage               */
+  muBN_size_t   spacing;   /* 4 bits windows per table                */
+  muBN_size_t   nq;        /* number of tables                        */
+  muBN_size_t   tmp_mul;   /* temp word length for muEC_comb_mul      */
+} muEC_comb_t;
+
+/* ======================================================================================= */
+/*                                     Context                                             */
+/* ======================================================================================= */
+
+/**
+ * Word length of the curve numbers.
+ *
+ * @param [in]  curve  UEC_xxx
+ *
+ * @return the word length, 0 if the curve is unknown
+ */
+muBN_size_t muEC_curve_wlen(uint8_t curve);
+
+/**
+ * Setup a curve context.
+ *
+ * @param [out] ctx
+ * @param [in]  curve  UEC_xxx
+ * @param [in]  buf    context storage, word length a least equals to wlen*10 + 1
+ * @param [in]  temp   temporary buffer with a word length a least equals to wlen*3 + 1
+ *
+ * with wlen = muEC_curve_wlen(curve)
+ *
+ * @return 1 if the context is ready
+ * @return 0 if the curve is unknown
+ */
+muBN_word_t muEC_ctx_init(muEC_ctx_t *ctx, uint8_t curve, muBN_uword_t *buf,
+                          muBN_uword_t *temp);
+
+/**
+ * Wipe the context and its storage.
+ *
+ * @param [in/out] ctx
+ */
+void muEC_ctx_clear(muEC_ctx_t *ctx);
+
+/* ======================================================================================= */
+/*                                     Points                                              */
+/* ======================================================================================= */
+
+/**
+ * Setup P as a view on buf, and set it to infinity.
+ *
+ * @param [in]  ctx
+ * @param [out] P
+ * @param [in]  buf  point storage, word length a least equals to ctx->wlen*3
+ */
+void muEC_point_init(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *buf);
+
+/**
+ * P = O, the point at infinity
+ */
+void muEC_set_infinity(muEC_ctx_t *ctx, muEC_point_t *P);
+
+/**
+ * @return 1 if P is the point at infinity, 0 else
+ */
+muBN_word_t muEC_is_infinity(muEC_ctx_t *ctx, muEC_point_t *P);
+
+/**
+ * P = G, normalized
+ */
+void muEC_set_generator(muEC_ctx_t *ctx, muEC_point_t *P);
+
+/**
+ * R = P
+ */
+void muEC_copy(muEC_point_t *R, muEC_point_t *P);
+
+/**
+ * P = (x,y), normalized
+ *
+ * @pre x,y have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] P
+ * @param [in]  x     affine x, plain number
+ * @param [in]  y     affine y, plain number
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ *
+ * @return 1 if x<p, y<p and (x,y) is on the curve
+ * @return 0 else, P is set to infinity
+ */
+muBN_word_t muEC_set_affine(muEC_ctx_t *ctx, muEC_point_t *P, muBN_t *x, muBN_t *y,
+                            muBN_uword_t *temp);
+
+/**
+ * (x,y) = affine coordinates of P, plain numbers. One field inversion.
+ *
+ * @pre x,y have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] x
+ * @param [out] y
+ * @param [in]  P
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_inv
+ *
+ * @return 1 if P is not the point at infinity
+ * @return 0 else, x and y are set to zero
+ */
+muBN_word_t muEC_get_affine(muEC_ctx_t *ctx, muBN_t *x, muBN_t *y, muEC_point_t *P,
+                            muBN_uword_t *temp);
+
+/**
+ * Normalize P (Z = 1) with one field inversion.
+ * The point at infinity is kept as is.
+ *
+ * @param [in]     ctx
+ * @param [in/out] P
+ * @param [in]     temp  temporary buffer with a word length a least equals to ctx->tmp_inv
+ */
+void muEC_normalize(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *temp);
+
+/**
+ * Normalize P[0..n-1] with one field inversion, Montgomery's simultaneous
+ * inversion. Points at infinity are kept as is.
+ *
+ * @param [in]     ctx
+ * @param [in/out] P
+ * @param [in]     n     number of points
+ * @param [in]     temp  temporary buffer with a word length a least equals to
+ *                       ctx->tmp_inv + n*ctx->wlen
+ */
+void muEC_normalize_batch(muEC_ctx_t *ctx, muEC_point_t *P, muBN_size_t n,
+                          muBN_uword_t *temp);
+
+/**
+ * @param [in] ctx
+ * @param [in] P
+ * @param [in] temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ *
+ * @return 1 if P is on the curve (infinity included), 0 else
+ */
+muBN_word_t muEC_is_on_curve(muEC_ctx_t *ctx, muEC_point_t *P, muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                   Arithmetic                                            */
+/* ======================================================================================= */
+
+/**
+ * R = -P
+ *
+ * @param R  may be P
+ */
+void muEC_neg(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P);
+
+/**
+ * R = 2P
+ *
+ * 3M+5S with a = -3 (dbl-2001-b), 2M+5S with a = 0 (dbl-2009-l).
+ * P = O gives O without special case.
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be P
+ * @param [in]  P
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ */
+void muEC_dbl(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muBN_uword_t *temp);
+
+/**
+ * R = P + Q, Q normalized or infinity
+ *
+ * 7M+4S (madd-2007-bl). P = Q, P = -Q and infinity operands are handled.
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be P or Q
+ * @param [in]  P
+ * @param [in]  Q     normalized
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ */
+void muEC_add_mixed(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muEC_point_t *Q,
+                    muBN_uword_t *temp);
+
+/**
+ * R = P + Q
+ *
+ * 11M+5S (add-2007-bl). P = Q, P = -Q and infinity operands are handled.
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be P or Q
+ * @param [in]  P
+ * @param [in]  Q
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ */
+void muEC_add(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muEC_point_t *Q,
+              muBN_uword_t *temp);
+
+/**
+ * R = k.P
+ *
+ * Regular signed window: k is recoded in odd digits of 4 bits, so that
+ * the sequence of doublings and additions only depends on the bit length
+ * of n, and the table of the 8 odd multiples of P, normalized with one
+ * inversion, is read by scanning all its entries.
+ *
+ * @pre k has the ctx word-length, k < n
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be P
+ * @param [in]  k     plain number
+ * @param [in]  P
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_mul
+ */
+void muEC_mul(muEC_ctx_t *ctx, muEC_point_t *R, muBN_t *k, muEC_point_t *P,
+              muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                    Fixed base                                           */
+/* ======================================================================================= */
+
+/**
+ * Word length of the fixed base tables for the given spacing.
+ *
+ * The scalar is cut in d = (nbits+4)/4 signed 4 bits windows, there is one
+ * table for every 'spacing' windows: spacing = 1 gives d tables and no
+ * doubling, larger spacings divide the storage by spacing for
+ * 4.(spacing-1) doublings per multiplication.
+ *
+ * @return the word length, 0 if spacing < 1
+ */
+uint32_t muEC_comb_wlen(muEC_ctx_t *ctx, muBN_size_t spacing);
+
+/**
+ * Compute the fixed base tables of P, e.g. the generator.
+ *
+ * @param [in]  ctx
+ * @param [out] comb
+ * @param [in]  P        base point, not infinity
+ * @param [in]  spacing  see muEC_comb_wlen
+ * @param [in]  buf      table storage, word length a least equals to
+ *                       muEC_comb_wlen(ctx, spacing)
+ * @param [in]  temp     temporary buffer with a word length a least equals to ctx->tmp_mul
+ *
+ * @return 1 if the tables are ready
+ * @return 0 if spacing < 1 or P is infinity
+ */
+muBN_word_t muEC_comb_init(muEC_ctx_t *ctx, muEC_comb_t *comb, muEC_point_t *P,
+                           muBN_size_t spacing, muBN_uword_t *buf, muBN_uword_t *temp);
+
+/**
+ * R = k.P, P the base of comb
+ *
+ * Same odd recoding as muEC_mul, then one mixed addition per window and
+ * 4.(spacing-1) doublings, without any table setup. As for muEC_mul,
+ * each lookup reads all the entries of the table.
+ *
+ * @pre k has the ctx word-length, k < n
+ *
+ * @param [in]  ctx
+ * @param [in]  comb
+ * @param [out] R
+ * @param [in]  k     plain number
+ * @param [in]  temp  temporary buffer with a word length a least equals to comb->tmp_mul
+ */
+void muEC_comb_mul(muEC_ctx_t *ctx, muEC_comb_t *comb, muEC_point_t *R, muBN_t *k,
+                   muBN_uword_t *temp);
+
+/**
+ * Wipe the tables.
+ */
+void muEC_comb_clear(muEC_ctx_t *ctx, muEC_comb_t *comb);
+
+/* ======================================================================================= */
+/*                                   Endomorphism                                          */
+/* ======================================================================================= */
+
+/**
+ * @return 1 if the curve has an efficient endomorphism (secp256k1), 0 else
+ */
+muBN_word_t muEC_has_endo(muEC_ctx_t *ctx);
+
+/**
+ * R = lambda.P = (beta.X, Y, Z), one field product.
+ *
+ * @pre muEC_has_endo(ctx)
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be P
+ * @param [in]  P
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->wlen
+ */
+void muEC_endo(muEC_ctx_t *ctx, muEC_point_t *R, muEC_point_t *P, muBN_uword_t *temp);
+
+/**
+ * GLV decomposition: k = (-1)^neg[0].k1 + (-1)^neg[1].k2.lambda mod n,
+ * with k1, k2 of at most 128 bits.
+ *
+ * c1 = round(k.b2/n) and c2 = round(-k.b1/n) are obtained with two
+ * products by precomputed 2^384/n multiples, then k2 = -c1.b1 - c2.b2 and
+ * k1 = k - k2.lambda mod n, each one kept as its representative of least
+ * absolute value.
+ *
+ * @pre k1, k2, k have the ctx word-length, k < n, k1 and k2 do not overlap k
+ *
+ * @param [in]  ctx
+ * @param [out] k1
+ * @param [out] k2
+ * @param [out] neg   neg[0], neg[1]: 1 if k1, k2 stand for -k1, -k2
+ * @param [in]  k
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_pt
+ *
+ * @return 1 if k is split
+ * @return 0 if the curve has no endomorphism
+ */
+muBN_word_t muEC_glv_split(muEC_ctx_t *ctx, muBN_t *k1, muBN_t *k2, uint8_t *neg, muBN_t *k,
+                           muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                              Multi-scalar multiplication                                */
+/* ======================================================================================= */
+
+/**
+ * Word length of the temp buffer of muEC_msm for n points.
+ */
+uint32_t muEC_msm_tmp(muEC_ctx_t *ctx, muBN_size_t n);
+
+/**
+ * R = k[0].P[0] + ... + k[n-1].P[n-1]
+ *
+ * Up to UEC_MSM_STRAUS_MAX points, the width 5 NAF of the scalars are
+ * interleaved over tables of odd multiples, normalized with a single
+ * inversion: the doublings are shared by all the points. Above, Pippenger
+ * buckets: for each window of c bits (chosen from n), the points are
+ * added to the bucket of their signed digit, with affine additions
+ * batched by UEC_MSM_BATCH to share one inversion, then the buckets are
+ * summed with running sums.
+ *
+ * The length of the largest scalar is used, short scalars are cheaper.
+ * On curves with an endomorphism, up to UEC_MSM_STRAUS_MAX/2 points,
+ * each k[i].P[i] is first split in k1.P[i] + k2.lambda.P[i]
+ * (muEC_glv_split): 2n points with half length scalars, half the
+ * doublings, and the tables of the lambda.P[i] are derived from the ones
+ * of P[i]. An ECDSA verification u1.G + u2.Q is then a 4 points, 128
+ * bits, joint multiplication.
+ *
+ * Not constant time: for public scalars and points, e.g. verifications.
+ *
+ * @pre k[i] have the ctx word-length, k[i] < n
+ *
+ * @param [in]  ctx
+ * @param [out] R     may be one of P[i]
+ * @param [in]  k     n plain numbers
+ * @param [in]  P     n points
+ * @param [in]  n
+ * @param [in]  temp  temporary buffer with a word length a least equals to
+ *                    muEC_msm_tmp(ctx, n)
+ */
+void muEC_msm(muEC_ctx_t *ctx, muEC_point_t *R, muBN_t *k, muEC_point_t *P, muBN_size_t n,
+              muBN_uword_t *temp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "muECDSA.h"
+
+/* F(i): i-th number of temp */
+#define F(i)  (temp+(i)*wlen)
+
+static uint32_t muECDSA_max(uint32_t a, uint32_t b) {
+  return a > b ? a : b;
+}
+
+/* ======================================================================================= */
+/*                                     Context                                             */
+/* ======================================================================================= */
+
+muBN_word_t muECDSA_ctx_init(muECDSA_ctx_t *ctx, muEC_ctx_t *ec, muEC_comb_t *G,
+                             muBN_uword_t *buf, muBN_uword_t *temp) {
+  uint32_t     t;
+  muBN_size_t  wlen;
+
+  ctx->ec = ec;
+  ctx->G  = G;
+  if (!muBN_mgt_ctx_init(&ctx->fn, &ec->n, buf, temp)) {
+    return 0;
+  }
+  wlen = ec->wlen;
+
+  //sign: 12 numbers, then k.G and the inversions
+  t = muECDSA_max((uint32_t)wlen*3 + ec->tmp_mul, ec->tmp_inv);
+  t = muECDSA_max(t, (uint32_t)wlen*3);
+  if (G) {
+    t = muECDSA_max(t, G->tmp_mul);
+  }
+  ctx->tmp_sign = (uint32_t)wlen*12 + t;
+
+  //verify: 12 numbers, then msm or two comb_mul
+  t = muECDSA_max(muEC_msm_tmp(ec, 2), (uint32_t)wlen*4 + ec->tmp_pt);
+  t = muECDSA_max(t, ec->tmp_inv);
+  t = muECDSA_max(t, (uint32_t)wlen*3);
+  ctx->tmp_verify = (uint32_t)wlen*12 + t;
+
+  //ecdh: 7 numbers, then mul
+  t = muECDSA_max(ec->tmp_mul, ec->tmp_pt);
+  t = muECDSA_max(t, ec->tmp_inv);
+  ctx->tmp_ecdh = (uint32_t)wlen*7 + t;
+  return 1;
+}
+
+void muECDSA_ctx_clear(muECDSA_ctx_t *ctx) {
+  muBN_mgt_ctx_clear(&ctx->fn);
+  ctx->G          = NULL;
+  ctx->tmp_sign   = 0;
+  ctx->tmp_verify = 0;
+  ctx->tmp_ecdh   = 0;
+}
+
+/* ======================================================================================= */
+/*                                     Helpers                                             */
+/* ======================================================================================= */
+
+/* 1 if k in [1,n-1] */
+static muBN_word_t muECDSA_scalar_ok(muECDSA_ctx_t *ctx, muBN_t *k) {
+  return !muBN_is_zero(k) && (muBN_ucmp(k, &ctx->ec->n) < 0);
+}
+
+/* r = x mod n, x < p < 2n for all the supported curves */
+static void muECDSA_mod_n(muECDSA_ctx_t *ctx, muBN_t *r, muBN_t *x) {
+  if (r != x) {
+    muBN_copy(r, x);
+  }
+  if (muBN_ucmp(r, &ctx->ec->n) >= 0) {
+    muBN_sub(r, r, &ctx->ec->n);
+  }
+}
+
+/* e = the nbits leftmost bits of h, mod n */
+static void muECDSA_bits2int(muECDSA_ctx_t *ctx, muBN_t *e, const uint8_t *h, uint32_t hlen) {
+  muBN_size_t  nbits, wlen;
+  uint32_t     i, nbytes;
+
+  nbits  = ctx->ec->nbits;
+  wlen   = ctx->ec->wlen;
+  nbytes = ((uint32_t)nbits+7)/8;
+  if (hlen > nbytes) {
+    hlen = nbytes;
+  }
+  muBN_zero(e);
+  for (i = 0; i < hlen; i++) {
+    e->v[wlen-1-i/sizeof(muBN_uword_t)] |=
+      (muBN_uword_t)h[hlen-1-i] << (8*(i%sizeof(muBN_uword_t)));
+  }
+  if (hlen*8 > (uint32_t)nbits) {
+    muBN_urshift(e, (muBN_size_t)(hlen*8-nbits));
+  }
+  muECDSA_mod_n(ctx, e, e);
+}
+
+/* R = k.G, constant time, with the generator tables if any.
+ * temp: max(G->tmp_mul, 3*wlen + ec->tmp_mul)
+ */
+static void muECDSA_mul_g(muECDSA_ctx_t *ctx, muEC_point_t *R, muBN_t *k, muBN_uword_t *temp) {
+  muEC_point_t  G;
+
+  if (ctx->G) {
+    muEC_comb_mul(ctx->ec, ctx->G, R, k, temp);
+    return;
+  }
+  muEC_point_init(ctx->ec, &G, temp);
+  muEC_set_generator(ctx->ec, &G);
+  muEC_mul(ctx->ec, R, k, &G, temp+ctx->ec->wlen*3);
+}
+
+/* ======================================================================================= */
+/*                                    Public keys                                          */
+/* ======================================================================================= */
+
+uint32_t muECDSA_key_wlen(muECDSA_ctx_t *ctx, muBN_size_t spacing) {
+  return (uint32_t)ctx->ec->wlen*3 + muEC_comb_wlen(ctx->ec, spacing);
+}
+
+muBN_word_t muECDSA_key_init(muECDSA_ctx_t *ctx, muECDSA_key_t *key, muBN_t *qx, muBN_t *qy,
+                             muBN_size_t spacing, muBN_uword_t *buf, muBN_uword_t *temp) {
+  muEC_ctx_t  *ec;
+
+  ec = ctx->ec;
+  key->comb.v       = NULL;
+  key->comb.spacing = 0;
+  key->comb.nq      = 0;
+  key->comb.tmp_mul = 0;
+  muEC_point_init(ec, &key->Q, buf);
+  if (!muEC_set_affine(ec, &key->Q, qx, qy, temp)) {
+    return 0;
+  }
+  if (spacing != 0) {
+    if (!muEC_comb_init(ec, &key->comb, &key->Q, spacing, buf+ec->wlen*3, temp)) {
+      key->comb.v = NULL;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void muECDSA_key_clear(muECDSA_ctx_t *ctx, muECDSA_key_t *key) {
+  if (key->comb.v) {
+    muEC_comb_clear(ctx->ec, &key->comb);
+    key->comb.v = NULL;
+  }
+  muBN_zero(&key->Q.x);
+  muBN_zero(&key->Q.y);
+  muBN_zero(&key->Q.z);
+}
+
+muBN_word_t muECDSA_public_key(muECDSA_ctx_t *ctx, muBN_t *qx, muBN_t *qy, muBN_t *d,
+                               muBN_uword_t *temp) {
+  muEC_point_t  R;
+  muBN_size_t   wlen;
+
+  if (!muECDSA_scalar_ok(ctx, d)) {
+    return 0;
+  }
+  wlen = ctx->ec->wlen;
+  muEC_point_init(ctx->ec, &R, F(0));
+  muECDSA_mul_g(ctx, &R, d, F(12));
+  muEC_get_affine(ctx->ec, qx, qy, &R, F(12));
+  return 1;
+}
+
+/* ======================================================================================= */
+/*                                     Signature                                           */
+/* ======================================================================================= */
+
+muBN_word_t muECDSA_sign(muECDSA_ctx_t *ctx, muBN_t *r, muBN_t *s,
+                         const uint8_t *h, uint32_t hlen,
+                         muBN_t *d, muBN_t *k, muBN_t *b, muBN_uword_t *temp) {
+  muEC_point_t  R;
+  muBN_t        x, y, e, t1, t2, t3;
+  muBN_mgt_ctx_t  *fn;
+  muBN_size_t   wlen;
+  muBN_word_t   ok;
+
+  muBN_zero(r);
+  muBN_zero(s);
+  if (!muECDSA_scalar_ok(ctx, d) || !muECDSA_scalar_ok(ctx, k) || !muECDSA_scalar_ok(ctx, b)) {
+    return 0;
+  }
+  fn   = &ctx->fn;
+  wlen = ctx->ec->wlen;
+  muEC_point_init(ctx->ec, &R, F(0));
+  muBN_init(&x,  F(3), wlen);
+  muBN_init(&y,  F(4), wlen);
+  muBN_init(&e,  F(5), wlen);
+  muBN_init(&t1, F(6), wlen);
+  muBN_init(&t2, F(7), wlen);
+  muBN_init(&t3, F(8), wlen);
+
+  //r = x(k.G) mod n
+  muECDSA_mul_g(ctx, &R, k, F(12));
+  muEC_get_affine(ctx->ec, &x, &y, &R, F(12));
+  muECDSA_mod_n(ctx, r, &x);
+  ok = !muBN_is_zero(r);
+
+  //Mont(k⁻¹) = Mont((k.b)⁻¹).b
+  muBN_mgt_ctx_z2mgt(fn, &t1, k);
+  muBN_mgt_ctx_z2mgt(fn, &t2, b);
+  muBN_mgt_ctx_mul(fn, &t3, &t1, &t2);
+  muBN_mgt_inv(&t1, &t3, &fn->m, F(12));
+  muBN_mgt_ctx_mul(fn, &t3, &t1, &t2);
+
+  //s = k⁻¹.(e + r.d)
+  muECDSA_bits2int(ctx, &e, h, hlen);
+  muBN_mgt_ctx_z2mgt(fn, &t1, d);
+  muBN_mgt_ctx_mul(fn, &t2, &t1, r);
+  muBN_mod_add_sec(&t1, &e, &t2, &fn->m, F(12));
+  muBN_mgt_ctx_mul(fn, s, &t3, &t1);
+  ok &= !muBN_is_zero(s);
+
+  muBN_zero(&y);
+  muBN_zero(&t1);
+  muBN_zero(&t2);
+  muBN_zero(&t3);
+  muEC_set_infinity(ctx->ec, &R);
+  return ok;
+}
+
+muBN_word_t muECDSA_verify(muECDSA_ctx_t *ctx, muECDSA_key_t *key, muBN_t *r, muBN_t *s,
+                           const uint8_t *h, uint32_t hlen, muBN_uword_t *temp) {
+  muEC_point_t  R, P[2];
+  muBN_t        u[2], e, w, x, y;
+  muEC_ctx_t    *ec;
+  muBN_size_t   wlen;
+
+  if (!muECDSA_scalar_ok(ctx, r) || !muECDSA_scalar_ok(ctx, s)) {
+    return 0;
+  }
+  ec   = ctx->ec;
+  wlen = ec->wlen;
+  muEC_point_init(ec, &R,    F(0));
+  muEC_point_init(ec, &P[0], F(3));
+  muBN_init(&u[0], F(6),  wlen);
+  muBN_init(&u[1], F(7),  wlen);
+  muBN_init(&e,    F(8),  wlen);
+  muBN_init(&w,    F(9),  wlen);
+  muBN_init(&x,    F(10), wlen);
+  muBN_init(&y,    F(11), wlen);
+
+  //u1 = e.w, u2 = r.w, w = s⁻¹
+  muECDSA_bits2int(ctx, &e, h, hlen);
+  muBN_mgt_ctx_z2mgt(&ctx->fn, &x, s);
+  if (!muBN_mgt_inv(&w, &x, &ctx->fn.m, F(12))) {
+    return 0;
+  }
+  muBN_mgt_ctx_mul(&ctx->fn, &u[0], &e, &w);
+  muBN_mgt_ctx_mul(&ctx->fn, &u[1], r,  &w);
+
+  //R = u1.G + u2.Q
+  if (ctx->G && key->comb.v) {
+    muEC_comb_mul(ec, ctx->G,     &R,    &u[0], F(12));
+    muEC_comb_mul(ec, &key->comb, &P[0], &u[1], F(12));
+    muEC_add(ec, &R, &R, &P[0], F(12));
+  } else {
+    muEC_set_generator(ec, &P[0]);
+    P[1] = key->Q;
+    muEC_msm(ec, &R, u, P, 2, F(12));
+  }
+
+  if (!muEC_get_affine(ec, &x, &y, &R, F(12))) {
+    return 0;
+  }
+  muECDSA_mod_n(ctx, &x, &x);
+  return muBN_ucmp(&x, r) == 0;
+}
+
+/* ======================================================================================= */
+/*                                       ECDH                                              */
+/* ======================================================================================= */
+
+muBN_word_t muECDH(muECDSA_ctx_t *ctx, muBN_t *z, muBN_t *d, muBN_t *qx, muBN_t *qy,
+                   muBN_uword_t *temp) {
+  muEC_point_t  R, Q;
+  muBN_t        y;
+  muEC_ctx_t    *ec;
+  muBN_size_t   wlen;
+  muBN_word_t   ok;
+
+  muBN_zero(z);
+  ec   = ctx->ec;
+  wlen = ec->wlen;
+  if (!muECDSA_scalar_ok(ctx, d)) {
+    return 0;
+  }
+  muEC_point_init(ec, &R, F(0));
+  muEC_point_init(ec, &Q, F(3));
+  muBN_init(&y, F(6), wlen);
+  if (!muEC_set_affine(ec, &Q, qx, qy, F(7))) {
+    return 0;
+  }
+  muEC_mul(ec, &R, d, &Q, F(7));
+  ok = muEC_get_affine(ec, z, &y, &R, F(7));
+  muBN_zero(&y);
+  muEC_set_infinity(ec, &R);
+  return ok;
+}
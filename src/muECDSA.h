@@ -0,0 +1,227 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef muECDSA_H
+#define muECDSA_H
+
+/*
+ * ECDSA (FIPS 186-4, SEC 1) and ECDH over the muEC curves.
+ *
+ * Scalars mod n are plain muBN numbers of the curve word-length, the
+ * inversions mod n go through Montgomery inversion (muBN_mgt_inv) in a
+ * Montgomery context of n held by the ECDSA context.
+ *
+ * Both sides of a verification can use fixed base tables (muEC_comb):
+ * the generator ones, shared by the context, and optional per public key
+ * ones kept in a muECDSA_key_t. With both, u1.G + u2.Q is two fixed base
+ * multiplications without any doubling nor table setup, for keys that are
+ * verified against many times. Else muEC_msm computes u1.G + u2.Q.
+ *
+ * The library has no random source: the signer provides the nonce k, and
+ * a random blinding b for the inversion of k, which is not constant time.
+ */
+
+#include "muEC.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * ECDSA context. Read only once initialized, it can be shared.
+ */
+typedef struct {
+  muEC_ctx_t      *ec;         /* curve                                    */
+  muBN_mgt_ctx_t  fn;          /* Montgomery context of the order n        */
+  muEC_comb_t     *G;          /* generator tables, or NULL                */
+  uint32_t        tmp_sign;    /* temp word length for sign, public_key    */
+  uint32_t        tmp_verify;  /* temp word length for verify              */
+  uint32_t        tmp_ecdh;    /* temp word length for muECDH              */
+} muECDSA_ctx_t;
+
+/**
+ * Public key Q, with its optional fixed base tables.
+ */
+typedef struct {
+  muEC_point_t  Q;      /* normalized                               */
+  muEC_comb_t   comb;   /* tables of Q, comb.v is NULL without them */
+} muECDSA_key_t;
+
+/* ======================================================================================= */
+/*                                     Context                                             */
+/* ======================================================================================= */
+
+/**
+ * Setup an ECDSA context.
+ *
+ * @param [out] ctx
+ * @param [in]  ec    curve context, shall outlive ctx
+ * @param [in]  G     tables of the generator (muEC_comb_init), shall outlive ctx, may be
+ *                    NULL: sign then uses muEC_mul and verify muEC_msm
+ * @param [in]  buf   context storage, word length a least equals to ec->wlen*3
+ * @param [in]  temp  temporary buffer with a word length a least equals to ec->wlen*3 + 1
+ *
+ * @return 1 if the context is ready
+ * @return 0 else
+ */
+muBN_word_t muECDSA_ctx_init(muECDSA_ctx_t *ctx, muEC_ctx_t *ec, muEC_comb_t *G,
+                             muBN_uword_t *buf, muBN_uword_t *temp);
+
+/**
+ * Wipe the context and its storage.
+ */
+void muECDSA_ctx_clear(muECDSA_ctx_t *ctx);
+
+/* ======================================================================================= */
+/*                                    Public keys                                          */
+/* ======================================================================================= */
+
+/**
+ * Word length of a public key storage, the point and the tables for the
+ * given spacing (see muEC_comb_wlen), or only the point if spacing is 0.
+ */
+uint32_t muECDSA_key_wlen(muECDSA_ctx_t *ctx, muBN_size_t spacing);
+
+/**
+ * Setup the public key (qx,qy), and its tables if spacing is not 0.
+ *
+ * The key can then be cached and reused by any number of verifications.
+ * With spacing 1, the tables halve the verification time on P-256.
+ *
+ * @pre qx,qy have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] key
+ * @param [in]  qx       affine x, plain number
+ * @param [in]  qy       affine y, plain number
+ * @param [in]  spacing  0, or see muEC_comb_wlen
+ * @param [in]  buf      key storage, word length a least equals to
+ *                       muECDSA_key_wlen(ctx, spacing)
+ * @param [in]  temp     temporary buffer with a word length a least equals to
+ *                       ctx->ec->tmp_mul
+ *
+ * @return 1 if the key is ready
+ * @return 0 if (qx,qy) is not a point of the curve
+ */
+muBN_word_t muECDSA_key_init(muECDSA_ctx_t *ctx, muECDSA_key_t *key, muBN_t *qx, muBN_t *qy,
+                             muBN_size_t spacing, muBN_uword_t *buf, muBN_uword_t *temp);
+
+/**
+ * Wipe the key and its tables.
+ */
+void muECDSA_key_clear(muECDSA_ctx_t *ctx, muECDSA_key_t *key);
+
+/**
+ * (qx,qy) = d.G, constant time.
+ *
+ * @pre qx,qy,d have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] qx    plain number
+ * @param [out] qy    plain number
+ * @param [in]  d     private key
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_sign
+ *
+ * @return 1
+ * @return 0 if d is not in [1,n-1]
+ */
+muBN_word_t muECDSA_public_key(muECDSA_ctx_t *ctx, muBN_t *qx, muBN_t *qy, muBN_t *d,
+                               muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                     Signature                                           */
+/* ======================================================================================= */
+
+/**
+ * (r,s) = ECDSA signature of the hash h
+ *
+ *   r = x(k.G) mod n,  s = k⁻¹.(e + r.d) mod n
+ *
+ * e being the nbits leftmost bits of h, mod n. k.G is computed in
+ * constant time, and k⁻¹ = b.(k.b)⁻¹ so that the variable time inversion
+ * only sees k.b.
+ *
+ * @pre r,s,d,k,b have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] r
+ * @param [out] s
+ * @param [in]  h     hash, big endian
+ * @param [in]  hlen  hash byte length
+ * @param [in]  d     private key
+ * @param [in]  k     secret nonce, random (or RFC 6979) and never reused
+ * @param [in]  b     random blinding
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_sign
+ *
+ * @return 1 if (r,s) is a signature
+ * @return 0 if d, k or b is not in [1,n-1], or r or s is 0: retry with another k
+ */
+muBN_word_t muECDSA_sign(muECDSA_ctx_t *ctx, muBN_t *r, muBN_t *s,
+                         const uint8_t *h, uint32_t hlen,
+                         muBN_t *d, muBN_t *k, muBN_t *b, muBN_uword_t *temp);
+
+/**
+ * Verify (r,s) against the hash h and the public key, variable time.
+ *
+ *   w = s⁻¹, x(e.w.G + r.w.Q) mod n = r
+ *
+ * With the generator and the key tables, two muEC_comb_mul, else one
+ * muEC_msm.
+ *
+ * @pre r,s have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [in]  key
+ * @param [in]  r
+ * @param [in]  s
+ * @param [in]  h     hash, big endian
+ * @param [in]  hlen  hash byte length
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_verify
+ *
+ * @return 1 if (r,s) is valid
+ * @return 0 else
+ */
+muBN_word_t muECDSA_verify(muECDSA_ctx_t *ctx, muECDSA_key_t *key, muBN_t *r, muBN_t *s,
+                           const uint8_t *h, uint32_t hlen, muBN_uword_t *temp);
+
+/* ======================================================================================= */
+/*                                       ECDH                                              */
+/* ======================================================================================= */
+
+/**
+ * z = x(d.Q), the shared secret of d and the peer key Q = (qx,qy),
+ * constant time in d.
+ *
+ * @pre z,d,qx,qy have the ctx word-length
+ *
+ * @param [in]  ctx
+ * @param [out] z     plain number
+ * @param [in]  d     private key
+ * @param [in]  qx    peer affine x, plain number
+ * @param [in]  qy    peer affine y, plain number
+ * @param [in]  temp  temporary buffer with a word length a least equals to ctx->tmp_ecdh
+ *
+ * @return 1
+ * @return 0 if d is not in [1,n-1] or (qx,qy) is not a point of the curve, z is 0
+ */
+muBN_word_t muECDH(muECDSA_ctx_t *ctx, muBN_t *z, muBN_t *d, muBN_t *qx, muBN_t *qy,
+                   muBN_uword_t *temp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,781 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "muEd25519.h"
+
+/* ======================================================================================= */
+/*                                      Constants                                          */
+/* ======================================================================================= */
+
+/* Little endian field constants */
+static const uint8_t mu_ed25519_d[32] = {
+  0xa3,0x78,0x59,0x13,0xca,0x4d,0xeb,0x75,0xab,0xd8,0x41,0x41,0x4d,0x0a,0x70,0x00,
+  0x98,0xe8,0x79,0x77,0x79,0x40,0xc7,0x8c,0x73,0xfe,0x6f,0x2b,0xee,0x6c,0x03,0x52
+};
+static const uint8_t mu_ed25519_sqrtm1[32] = {
+  0xb0,0xa0,0x0e,0x4a,0x27,0x1b,0xee,0xc4,0x78,0xe4,0x2f,0xad,0x06,0x18,0x43,0x2f,
+  0xa7,0xd7,0xfb,0x3d,0x99,0x00,0x4d,0x2b,0x0b,0xdf,0xc1,0x4f,0x80,0x24,0x83,0x2b
+};
+/* Encoded base point, y = 4/5, x even */
+static const uint8_t mu_ed25519_B[32] = {
+  0x58,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,
+  0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66,0x66
+};
+
+/* Group order l = 2^252 + 27742317777372353535851937790883648493, most significant word first */
+static const muBN_uword_t mu_ed25519_l[] = {
+  UBN_WORD64(0x10000000,0x00000000), UBN_WORD64(0x00000000,0x00000000),
+  UBN_WORD64(0x14DEF9DE,0xA2F79CD6), UBN_WORD64(0x5812631A,0x5CF5D3ED)
+};
+
+#define UED25519_W     UED25519_WLEN
+#define UED25519_TAB   8             /* odd multiples in variable base tables, |digit| <= 15 */
+
+/* ======================================================================================= */
+/*                                      Points                                             */
+/* ======================================================================================= */
+
+/*
+ * Extended point (X,Y,Z,T). The same structure holds:
+ *  - projective points, T unused, as doubling inputs
+ *  - completed points ((X:Z),(Y:T)), the add and dbl outputs, turned
+ *    to projective for 3 products or to extended for 4
+ */
+typedef struct {
+  mu25519_fe_t  X;
+  mu25519_fe_t  Y;
+  mu25519_fe_t  Z;
+  mu25519_fe_t  T;
+} mu_ed25519_pt_t;
+
+/* Cached extended point (Y+X, Y-X, Z, 2dT) */
+typedef struct {
+  mu25519_fe_t  ypx;
+  mu25519_fe_t  ymx;
+  mu25519_fe_t  z;
+  mu25519_fe_t  t2d;
+} mu_ed25519_cached_t;
+
+static void mu_ed25519_identity(mu_ed25519_pt_t *r) {
+  mu25519_fe_0(&r->X);
+  mu25519_fe_1(&r->Y);
+  mu25519_fe_1(&r->Z);
+  mu25519_fe_0(&r->T);
+}
+
+/* completed to projective */
+static void mu_ed25519_p1p2(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p) {
+  mu25519_fe_mul(&r->X, &p->X, &p->T);
+  mu25519_fe_mul(&r->Y, &p->Y, &p->Z);
+  mu25519_fe_mul(&r->Z, &p->Z, &p->T);
+}
+
+/* completed to extended */
+static void mu_ed25519_p1p3(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p) {
+  mu25519_fe_mul(&r->X, &p->X, &p->T);
+  mu25519_fe_mul(&r->Y, &p->Y, &p->Z);
+  mu25519_fe_mul(&r->Z, &p->Z, &p->T);
+  mu25519_fe_mul(&r->T, &p->X, &p->Y);
+}
+
+static void mu_ed25519_cached(mu_ed25519_ctx_t *ctx, mu_ed25519_cached_t *r, mu_ed25519_pt_t *p) {
+  mu25519_fe_add(&r->ypx, &p->Y, &p->X);
+  mu25519_fe_sub(&r->ymx, &p->Y, &p->X);
+  mu25519_fe_copy(&r->z, &p->Z);
+  mu25519_fe_mul(&r->t2d, &p->T, &ctx->d2);
+}
+
+/* r = 2p, completed from projective, dbl-2008-hwcd with a = -1 */
+static void mu_ed25519_dbl(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p) {
+  mu25519_fe_t t;
+
+  mu25519_fe_sqr(&r->X, &p->X);
+  mu25519_fe_sqr(&r->Z, &p->Y);
+  mu25519_fe_sqr(&r->T, &p->Z);
+  mu25519_fe_add(&r->T, &r->T, &r->T);
+  mu25519_fe_add(&r->Y, &p->X, &p->Y);
+  mu25519_fe_sqr(&t, &r->Y);
+  mu25519_fe_add(&r->Y, &r->Z, &r->X);
+  mu25519_fe_sub(&r->Z, &r->Z, &r->X);
+  mu25519_fe_sub(&r->X, &t, &r->Y);
+  mu25519_fe_sub(&r->T, &r->T, &r->Z);
+}
+
+/*
+ * r = p + q or p - q if neg, completed, add-2008-hwcd-3.
+ * q is given by its (y+x, y-x, 2dt) and z, z = NULL for 1.
+ */
+static void mu_ed25519_add_core(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p, mu25519_fe_t *ypx,
+                                mu25519_fe_t *ymx, mu25519_fe_t *t2d, mu25519_fe_t *z,
+                                int neg) {
+  mu25519_fe_t t;
+
+  mu25519_fe_add(&r->X, &p->Y, &p->X);
+  mu25519_fe_sub(&r->Y, &p->Y, &p->X);
+  mu25519_fe_mul(&r->Z, &r->X, neg ? ymx : ypx);
+  mu25519_fe_mul(&r->Y, &r->Y, neg ? ypx : ymx);
+  mu25519_fe_mul(&r->T, t2d, &p->T);
+  if (z) {
+    mu25519_fe_mul(&r->X, &p->Z, z);
+    mu25519_fe_add(&t, &r->X, &r->X);
+  } else {
+    mu25519_fe_add(&t, &p->Z, &p->Z);
+  }
+  mu25519_fe_sub(&r->X, &r->Z, &r->Y);
+  mu25519_fe_add(&r->Y, &r->Z, &r->Y);
+  if (neg) {
+    mu25519_fe_sub(&r->Z, &t, &r->T);
+    mu25519_fe_add(&r->T, &t, &r->T);
+  } else {
+    mu25519_fe_add(&r->Z, &t, &r->T);
+    mu25519_fe_sub(&r->T, &t, &r->T);
+  }
+}
+
+static void mu_ed25519_add(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p, mu_ed25519_cached_t *q,
+                           int neg) {
+  mu_ed25519_add_core(r, p, &q->ypx, &q->ymx, &q->t2d, &q->z, neg);
+}
+
+static void mu_ed25519_madd(mu_ed25519_pt_t *r, mu_ed25519_pt_t *p, mu_ed25519_niels_t *q,
+                            int neg) {
+  mu_ed25519_add_core(r, p, &q->ypx, &q->ymx, &q->t2d, NULL, neg);
+}
+
+/* s = encoding of p, y with the sign of x on bit 255 */
+static void mu_ed25519_tobytes(uint8_t *s, mu_ed25519_pt_t *p) {
+  mu25519_fe_t zi, x, y;
+
+  mu25519_fe_inv(&zi, &p->Z);
+  mu25519_fe_mul(&x, &p->X, &zi);
+  mu25519_fe_mul(&y, &p->Y, &zi);
+  mu25519_fe_tobytes(s, &y);
+  s[31] ^= (uint8_t)(mu25519_fe_isneg(&x) << 7);
+}
+
+/*
+ * r = P or -P if neg, P decoded from s, RFC 8032 5.1.3.
+ * Non canonical y and x = 0 with sign 1 are rejected.
+ */
+static muBN_word_t mu_ed25519_frombytes(mu_ed25519_ctx_t *ctx, mu_ed25519_pt_t *r,
+                                        const uint8_t *s, int neg) {
+  mu25519_fe_t u, v, v3, vxx, t;
+  uint8_t      c[32];
+  int          i, sign;
+
+  mu25519_fe_frombytes(&r->Y, s);
+  mu25519_fe_tobytes(c, &r->Y);
+  c[31] |= s[31] & 0x80;
+  for (i = 0; i < 32; i++) {
+    if (c[i] != s[i]) {
+      return 0;
+    }
+  }
+  sign = s[31] >> 7;
+
+  /* x = (u/v)^((p+3)/8) = u.v³.(u.v⁷)^((p-5)/8), u = y²-1, v = dy²+1 */
+  mu25519_fe_1(&r->Z);
+  mu25519_fe_sqr(&u, &r->Y);
+  mu25519_fe_mul(&v, &u, &ctx->d);
+  mu25519_fe_sub(&u, &u, &r->Z);
+  mu25519_fe_add(&v, &v, &r->Z);
+  mu25519_fe_sqr(&v3, &v);
+  mu25519_fe_mul(&v3, &v3, &v);
+  mu25519_fe_sqr(&t, &v3);
+  mu25519_fe_mul(&t, &t, &v);
+  mu25519_fe_mul(&t, &t, &u);
+  mu25519_fe_pow22523(&t, &t);
+  mu25519_fe_mul(&t, &t, &v3);
+  mu25519_fe_mul(&r->X, &t, &u);
+
+  /* v.x² = u, or -u and x.sqrt(-1) */
+  mu25519_fe_sqr(&vxx, &r->X);
+  mu25519_fe_mul(&vxx, &vxx, &v);
+  mu25519_fe_sub(&t, &vxx, &u);
+  if (!mu25519_fe_iszero(&t)) {
+    mu25519_fe_add(&t, &vxx, &u);
+    if (!mu25519_fe_iszero(&t)) {
+      return 0;
+    }
+    mu25519_fe_mul(&r->X, &r->X, &ctx->sqrtm1);
+  }
+  if (mu25519_fe_iszero(&r->X) && sign) {
+    return 0;
+  }
+  if ((mu25519_fe_isneg(&r->X) ^ sign ^ neg) & 1) {
+    mu25519_fe_neg(&r->X, &r->X);
+  }
+  mu25519_fe_mul(&r->T, &r->X, &r->Y);
+  return 1;
+}
+
+/* 1 if [8]p is the neutral point, p projective */
+static muBN_word_t mu_ed25519_is_small(mu_ed25519_pt_t *p) {
+  mu_ed25519_pt_t t, u;
+
+  mu_ed25519_dbl(&t, p);
+  mu_ed25519_p1p2(&u, &t);
+  mu_ed25519_dbl(&t, &u);
+  mu_ed25519_p1p2(&u, &t);
+  mu_ed25519_dbl(&t, &u);
+  mu_ed25519_p1p2(&u, &t);
+  mu25519_fe_sub(&u.Y, &u.Y, &u.Z);
+  return mu25519_fe_iszero(&u.X) && mu25519_fe_iszero(&u.Y);
+}
+
+/* ======================================================================================= */
+/*                                      Scalars                                            */
+/* ======================================================================================= */
+
+/* r = little endian s of len bytes */
+static void mu_ed25519_sc_load(muBN_t *r, const uint8_t *s, uint32_t len) {
+  uint32_t i;
+
+  muBN_zero(r);
+  for (i = 0; i < len; i++) {
+    r->v[r->wlen-1-i/(UBN_BITS_PER_WORD/8)] |=
+      ((muBN_uword_t)s[i]) << (8*(i%(UBN_BITS_PER_WORD/8)));
+  }
+}
+
+/* s = 32 bytes little endian a */
+static void mu_ed25519_sc_store(uint8_t *s, muBN_t *a) {
+  uint32_t i;
+
+  for (i = 0; i < 32; i++) {
+    s[i] = (uint8_t)(a->v[a->wlen-1-i/(UBN_BITS_PER_WORD/8)] >> (8*(i%(UBN_BITS_PER_WORD/8))));
+  }
+}
+
+/* r = s mod l, s little endian of len bytes, len <= 64 */
+static void mu_ed25519_sc_reduce(mu_ed25519_ctx_t *ctx, muBN_t *r, const uint8_t *s,
+                                 uint32_t len) {
+  muBN_uword_t xbuf[2*UED25519_W];
+  muBN_uword_t temp[4*UED25519_W+4];
+  muBN_t       x;
+  uint32_t     i;
+
+  muBN_init(&x, xbuf, 2*UED25519_W);
+  mu_ed25519_sc_load(&x, s, len);
+  muBN_barrett_reduce(&ctx->l, r, &x, temp);
+  for (i = 0; i < 2*UED25519_W; i++) {
+    xbuf[i] = 0;
+  }
+}
+
+/* s = a.b + c mod l, all little endian, a of alen bytes, b and c of 32 */
+static void mu_ed25519_sc_muladd(mu_ed25519_ctx_t *ctx, uint8_t *s, const uint8_t *a,
+                                 uint32_t alen, const uint8_t *b, const uint8_t *c) {
+  muBN_uword_t buf[4*UED25519_W];
+  muBN_uword_t temp[6*UED25519_W+4];
+  muBN_t       A, B, C, S;
+  uint32_t     i;
+
+  muBN_init(&A, buf,               UED25519_W);
+  muBN_init(&B, buf+UED25519_W,    UED25519_W);
+  muBN_init(&C, buf+2*UED25519_W,  UED25519_W);
+  muBN_init(&S, buf+3*UED25519_W,  UED25519_W);
+  mu_ed25519_sc_reduce(ctx, &A, a, alen);
+  mu_ed25519_sc_reduce(ctx, &B, b, 32);
+  mu_ed25519_sc_reduce(ctx, &C, c, 32);
+  muBN_barrett_mulmod(&ctx->l, &S, &A, &B, temp);
+  muBN_mod_add_sec(&A, &S, &C, &ctx->l.m, temp);
+  mu_ed25519_sc_store(s, &A);
+  for (i = 0; i < 4*UED25519_W; i++) {
+    buf[i] = 0;
+  }
+}
+
+/* 1 if the little endian s is below l */
+static muBN_word_t mu_ed25519_sc_check(mu_ed25519_ctx_t *ctx, const uint8_t *s) {
+  muBN_uword_t buf[UED25519_W];
+  muBN_t       S;
+
+  muBN_init(&S, buf, UED25519_W);
+  mu_ed25519_sc_load(&S, s, 32);
+  return muBN_ucmp(&S, &ctx->l.m) < 0;
+}
+
+/* k = SHA-512(R || A || m) mod l */
+static void mu_ed25519_hram(mu_ed25519_ctx_t *ctx, uint8_t *k, const uint8_t *R,
+                            const uint8_t *A, const uint8_t *m, uint32_t mlen) {
+  muSHA512_t   sha;
+  uint8_t      h[USHA512_DIGEST];
+  muBN_uword_t buf[UED25519_W];
+  muBN_t       K;
+
+  muSHA512_init(&sha);
+  muSHA512_update(&sha, R, 32);
+  muSHA512_update(&sha, A, 32);
+  muSHA512_update(&sha, m, mlen);
+  muSHA512_final(&sha, h);
+  muBN_init(&K, buf, UED25519_W);
+  mu_ed25519_sc_reduce(ctx, &K, h, USHA512_DIGEST);
+  mu_ed25519_sc_store(k, &K);
+}
+
+/*
+ * Signed sliding window of a, r[i] odd in [-max,max] or 0, a < 2^255.
+ */
+static void mu_ed25519_slide(int8_t *r, const uint8_t *a, int max) {
+  int i, b, k;
+
+  for (i = 0; i < 256; i++) {
+    r[i] = 1 & (a[i>>3] >> (i&7));
+  }
+  for (i = 0; i < 256; i++) {
+    if (!r[i]) {
+      continue;
+    }
+    for (b = 1; (b <= 6) && (i+b < 256); b++) {
+      if (!r[i+b]) {
+        continue;
+      }
+      if (r[i] + (r[i+b] << b) <= max) {
+        r[i]   = (int8_t)(r[i] + (r[i+b] << b));
+        r[i+b] = 0;
+      } else if (r[i] - (r[i+b] << b) >= -max) {
+        r[i] = (int8_t)(r[i] - (r[i+b] << b));
+        for (k = i+b; k < 256; k++) {
+          if (!r[k]) {
+            r[k] = 1;
+            break;
+          }
+          r[k] = 0;
+        }
+      } else {
+        break;
+      }
+    }
+  }
+}
+
+/* ======================================================================================= */
+/*                                      Fixed base                                         */
+/* ======================================================================================= */
+
+/* 1 if a = b, a,b < 2^31 */
+static mu25519_limb_t mu_ed25519_eq(uint32_t a, uint32_t b) {
+  return ((a ^ b) - 1) >> 31;
+}
+
+/* t = b.256^pos.B, constant time, b in [-8,8] */
+static void mu_ed25519_select(mu_ed25519_ctx_t *ctx, mu_ed25519_niels_t *t, int pos, int8_t b) {
+  mu25519_fe_t   n;
+  mu25519_limb_t neg, eq;
+  uint32_t       babs;
+  int            j;
+
+  neg  = ((uint8_t)b) >> 7;
+  babs = (uint32_t)(b - 2*(-(int)neg & b));
+  mu25519_fe_1(&t->ypx);
+  mu25519_fe_1(&t->ymx);
+  mu25519_fe_0(&t->t2d);
+  for (j = 0; j < 8; j++) {
+    eq = mu_ed25519_eq(babs, (uint32_t)j+1);
+    mu25519_fe_cmov(&t->ypx, &ctx->base[pos][j].ypx, eq);
+    mu25519_fe_cmov(&t->ymx, &ctx->base[pos][j].ymx, eq);
+    mu25519_fe_cmov(&t->t2d, &ctx->base[pos][j].t2d, eq);
+  }
+  mu25519_fe_cswap(&t->ypx, &t->ymx, neg);
+  mu25519_fe_neg(&n, &t->t2d);
+  mu25519_fe_cmov(&t->t2d, &n, neg);
+}
+
+/*
+ * r = [a]B, a < 2^255, constant time. Signed radix 16 digits e_i,
+ * r = 16.sum(e_2i+1.256^i.B) + sum(e_2i.256^i.B): 64 additions of
+ * table points, 4 doublings.
+ */
+static void mu_ed25519_base_mul(mu_ed25519_ctx_t *ctx, mu_ed25519_pt_t *r, const uint8_t *a) {
+  mu_ed25519_niels_t t;
+  mu_ed25519_pt_t    p;
+  int8_t             e[64], carry;
+  int                i;
+
+  for (i = 0; i < 32; i++) {
+    e[2*i]   = a[i] & 15;
+    e[2*i+1] = (a[i] >> 4) & 15;
+  }
+  carry = 0;
+  for (i = 0; i < 63; i++) {
+    e[i]  = (int8_t)(e[i] + carry);
+    carry = (int8_t)((e[i] + 8) >> 4);
+    e[i]  = (int8_t)(e[i] - (carry << 4));
+  }
+  e[63] = (int8_t)(e[63] + carry);
+
+  mu_ed25519_identity(r);
+  for (i = 1; i < 64; i += 2) {
+    mu_ed25519_select(ctx, &t, i/2, e[i]);
+    mu_ed25519_madd(&p, r, &t, 0);
+    mu_ed25519_p1p3(r, &p);
+  }
+  mu_ed25519_dbl(&p, r);
+  mu_ed25519_p1p2(r, &p);
+  mu_ed25519_dbl(&p, r);
+  mu_ed25519_p1p2(r, &p);
+  mu_ed25519_dbl(&p, r);
+  mu_ed25519_p1p2(r, &p);
+  mu_ed25519_dbl(&p, r);
+  mu_ed25519_p1p3(r, &p);
+  for (i = 0; i < 64; i += 2) {
+    mu_ed25519_select(ctx, &t, i/2, e[i]);
+    mu_ed25519_madd(&p, r, &t, 0);
+    mu_ed25519_p1p3(r, &p);
+  }
+
+  for (i = 0; i < 64; i++) {
+    e[i] = 0;
+  }
+  mu25519_fe_0(&t.ypx); mu25519_fe_0(&t.ymx); mu25519_fe_0(&t.t2d);
+  mu25519_fe_0(&p.X);   mu25519_fe_0(&p.Y);   mu25519_fe_0(&p.Z);   mu25519_fe_0(&p.T);
+}
+
+/* row[j] = (j+1).P, affine with one inversion */
+static void mu_ed25519_table_row(mu_ed25519_ctx_t *ctx, mu_ed25519_niels_t *row,
+                                 mu_ed25519_pt_t *P) {
+  mu_ed25519_pt_t     Q[8], t;
+  mu_ed25519_cached_t c;
+  mu25519_fe_t        acc[8], inv, x, y;
+  int                 j;
+
+  mu25519_fe_copy(&Q[0].X, &P->X);
+  mu25519_fe_copy(&Q[0].Y, &P->Y);
+  mu25519_fe_copy(&Q[0].Z, &P->Z);
+  mu25519_fe_copy(&Q[0].T, &P->T);
+  mu_ed25519_cached(ctx, &c, P);
+  for (j = 1; j < 8; j++) {
+    mu_ed25519_add(&t, &Q[j-1], &c, 0);
+    mu_ed25519_p1p3(&Q[j], &t);
+  }
+
+  mu25519_fe_copy(&acc[0], &Q[0].Z);
+  for (j = 1; j < 8; j++) {
+    mu25519_fe_mul(&acc[j], &acc[j-1], &Q[j].Z);
+  }
+  mu25519_fe_inv(&inv, &acc[7]);
+  for (j = 7; j >= 0; j--) {
+    if (j) {
+      mu25519_fe_mul(&acc[j], &inv, &acc[j-1]);
+      mu25519_fe_mul(&inv, &inv, &Q[j].Z);
+    } else {
+      mu25519_fe_copy(&acc[0], &inv);
+    }
+    mu25519_fe_mul(&x, &Q[j].X, &acc[j]);
+    mu25519_fe_mul(&y, &Q[j].Y, &acc[j]);
+    mu25519_fe_add(&row[j].ypx, &y, &x);
+    mu25519_fe_sub(&row[j].ymx, &y, &x);
+    mu25519_fe_mul(&x, &x, &y);
+    mu25519_fe_mul(&row[j].t2d, &x, &ctx->d2);
+  }
+}
+
+/* ======================================================================================= */
+/*                                      Variable base                                      */
+/* ======================================================================================= */
+
+/* tab[j] = (2j+1).P */
+static void mu_ed25519_odd_multiples(mu_ed25519_ctx_t *ctx, mu_ed25519_cached_t *tab,
+                                     mu_ed25519_pt_t *P) {
+  mu_ed25519_pt_t     t, u, P2;
+  mu_ed25519_cached_t c2;
+  int                 j;
+
+  mu_ed25519_cached(ctx, &tab[0], P);
+  mu_ed25519_dbl(&t, P);
+  mu_ed25519_p1p3(&P2, &t);
+  mu_ed25519_cached(ctx, &c2, &P2);
+  mu25519_fe_copy(&u.X, &P->X);
+  mu25519_fe_copy(&u.Y, &P->Y);
+  mu25519_fe_copy(&u.Z, &P->Z);
+  mu25519_fe_copy(&u.T, &P->T);
+  for (j = 1; j < UED25519_TAB; j++) {
+    mu_ed25519_add(&t, &u, &c2, 0);
+    mu_ed25519_p1p3(&u, &t);
+    mu_ed25519_cached(ctx, &tab[j], &u);
+  }
+}
+
+/*
+ * r = [b]B + sum [k_j]P_j, Straus with shared doublings, variable time.
+ * db: slide of b with max 7, odd multiples of B read in the fixed-base
+ * table. dig: n slides of 256 digits, max 15. tab: n tables of odd
+ * multiples. r is extended.
+ */
+static void mu_ed25519_straus(mu_ed25519_ctx_t *ctx, mu_ed25519_pt_t *r, const int8_t *db,
+                              mu_ed25519_cached_t *tab, const int8_t *dig, uint32_t n) {
+  mu_ed25519_pt_t t, u;
+  uint32_t        j;
+  int             i, d;
+
+  for (i = 255; i >= 0; i--) {
+    d = db[i];
+    for (j = 0; (j < n) && !d; j++) {
+      d = dig[j*256+i];
+    }
+    if (d) {
+      break;
+    }
+  }
+  mu_ed25519_identity(r);
+  for (; i >= 0; i--) {
+    mu_ed25519_dbl(&t, r);
+    d = db[i];
+    if (d) {
+      mu_ed25519_p1p3(&u, &t);
+      mu_ed25519_madd(&t, &u, &ctx->base[0][(d > 0 ? d : -d)-1], d < 0);
+    }
+    for (j = 0; j < n; j++) {
+      d = dig[j*256+i];
+      if (d) {
+        mu_ed25519_p1p3(&u, &t);
+        mu_ed25519_add(&t, &u, &tab[j*UED25519_TAB+(d > 0 ? d : -d)/2], d < 0);
+      }
+    }
+    if (i) {
+      mu_ed25519_p1p2(r, &t);
+    } else {
+      mu_ed25519_p1p3(r, &t);
+    }
+  }
+}
+
+/* ======================================================================================= */
+/*                                      Context                                            */
+/* ======================================================================================= */
+
+muBN_word_t mu_ed25519_ctx_init(mu_ed25519_ctx_t *ctx) {
+  muBN_uword_t    buf[UED25519_W];
+  muBN_uword_t    temp[4*UED25519_W+1];
+  mu_ed25519_pt_t P, t;
+  muBN_t          l;
+  muBN_size_t     i;
+  int             j;
+
+  muBN_init(&l, buf, UED25519_W);
+  for (i = 0; i < (int)UED25519_W; i++) {
+    buf[i] = mu_ed25519_l[i];
+  }
+  if (!muBN_barrett_ctx_init(&ctx->l, &l, ctx->lbuf, temp)) {
+    return 0;
+  }
+
+  mu25519_fe_frombytes(&ctx->d, mu_ed25519_d);
+  mu25519_fe_add(&ctx->d2, &ctx->d, &ctx->d);
+  mu25519_fe_frombytes(&ctx->sqrtm1, mu_ed25519_sqrtm1);
+  if (!mu_ed25519_frombytes(ctx, &P, mu_ed25519_B, 0)) {
+    return 0;
+  }
+  for (i = 0; i < 32; i++) {
+    mu_ed25519_table_row(ctx, ctx->base[i], &P);
+    for (j = 0; j < 8; j++) {
+      mu_ed25519_dbl(&t, &P);
+      if (j < 7) {
+        mu_ed25519_p1p2(&P, &t);
+      } else {
+        mu_ed25519_p1p3(&P, &t);
+      }
+    }
+  }
+  return 1;
+}
+
+/* ======================================================================================= */
+/*                                      Signature                                          */
+/* ======================================================================================= */
+
+/* h = SHA-512(sk), clamped first half */
+static void mu_ed25519_expand(uint8_t *h, const uint8_t *sk) {
+  muSHA512(h, sk, 32);
+  h[0]  &= 248;
+  h[31] &= 127;
+  h[31] |= 64;
+}
+
+void mu_ed25519_public_key(mu_ed25519_ctx_t *ctx, uint8_t *pk, const uint8_t *sk) {
+  uint8_t         h[USHA512_DIGEST];
+  mu_ed25519_pt_t A;
+  int             i;
+
+  mu_ed25519_expand(h, sk);
+  mu_ed25519_base_mul(ctx, &A, h);
+  mu_ed25519_tobytes(pk, &A);
+  for (i = 0; i < USHA512_DIGEST; i++) {
+    h[i] = 0;
+  }
+}
+
+void mu_ed25519_sign(mu_ed25519_ctx_t *ctx, uint8_t *sig, const uint8_t *m, uint32_t mlen,
+                     const uint8_t *sk, const uint8_t *pk) {
+  uint8_t         h[USHA512_DIGEST], r[USHA512_DIGEST], k[32];
+  muSHA512_t      sha;
+  muBN_uword_t    buf[UED25519_W];
+  muBN_t          rr;
+  mu_ed25519_pt_t R;
+  int             i;
+
+  mu_ed25519_expand(h, sk);
+
+  /* r = SHA-512(prefix || m) mod l, R = [r]B */
+  muSHA512_init(&sha);
+  muSHA512_update(&sha, h+32, 32);
+  muSHA512_update(&sha, m, mlen);
+  muSHA512_final(&sha, r);
+  muBN_init(&rr, buf, UED25519_W);
+  mu_ed25519_sc_reduce(ctx, &rr, r, USHA512_DIGEST);
+  mu_ed25519_sc_store(r, &rr);
+  mu_ed25519_base_mul(ctx, &R, r);
+  mu_ed25519_tobytes(sig, &R);
+
+  /* S = r + k.a mod l */
+  mu_ed25519_hram(ctx, k, sig, pk, m, mlen);
+  mu_ed25519_sc_muladd(ctx, sig+32, h, 32, k, r);
+
+  for (i = 0; i < USHA512_DIGEST; i++) {
+    h[i] = 0;
+    r[i] = 0;
+  }
+  for (i = 0; i < (int)UED25519_W; i++) {
+    buf[i] = 0;
+  }
+  mu25519_fe_0(&R.X); mu25519_fe_0(&R.Y); mu25519_fe_0(&R.Z); mu25519_fe_0(&R.T);
+}
+
+muBN_word_t mu_ed25519_verify(mu_ed25519_ctx_t *ctx, const uint8_t *sig, const uint8_t *m,
+                              uint32_t mlen, const uint8_t *pk) {
+  mu_ed25519_cached_t tab[UED25519_TAB], c;
+  mu_ed25519_pt_t     A, R, P, t;
+  int8_t              ds[256], dk[256];
+  uint8_t             k[32];
+
+  if (!mu_ed25519_sc_check(ctx, sig+32) ||
+      !mu_ed25519_frombytes(ctx, &A, pk, 1) ||
+      !mu_ed25519_frombytes(ctx, &R, sig, 1)) {
+    return 0;
+  }
+  mu_ed25519_hram(ctx, k, sig, pk, m, mlen);
+
+  /* [8]([S]B + [k](-A) + (-R)) = 0 */
+  mu_ed25519_odd_multiples(ctx, tab, &A);
+  mu_ed25519_slide(ds, sig+32, 7);
+  mu_ed25519_slide(dk, k, 15);
+  mu_ed25519_straus(ctx, &P, ds, tab, dk, 1);
+  mu_ed25519_cached(ctx, &c, &R);
+  mu_ed25519_add(&t, &P, &c, 0);
+  mu_ed25519_p1p2(&P, &t);
+  return mu_ed25519_is_small(&P);
+}
+
+/* ======================================================================================= */
+/*                                      Batch                                              */
+/* ======================================================================================= */
+
+/* Slides of 256 digits, in field elements */
+#define UED25519_DIG_FE(n)  (((n)*256+sizeof(mu25519_fe_t)-1)/sizeof(mu25519_fe_t))
+
+uint32_t mu_ed25519_batch_tmp(uint32_t n) {
+  return 2*n*UED25519_TAB*4 + (uint32_t)UED25519_DIG_FE(2*n+1);
+}
+
+/*
+ * temp: 2n tables of odd multiples of A_i, R_i, then 2n+1 slides:
+ * z_i.k_i for A_i, z_i for R_i, -sum z_i.S_i for B.
+ */
+muBN_word_t mu_ed25519_verify_batch(mu_ed25519_ctx_t *ctx, uint8_t *valid,
+                                    const uint8_t **sig, const uint8_t **m,
+                                    const uint32_t *mlen, const uint8_t **pk, uint32_t n,
+                                    mu25519_fe_t *temp) {
+  mu_ed25519_cached_t *tab;
+  mu_ed25519_pt_t      P;
+  muSHA512_t           sha;
+  int8_t              *dig;
+  uint8_t              seed[USHA512_DIGEST], h[USHA512_DIGEST];
+  uint8_t              z[32], k[32], s[32], zero[32];
+  muBN_word_t          ok;
+  uint32_t             i, j;
+
+  if (n == 0) {
+    return 1;
+  }
+  tab = (mu_ed25519_cached_t*)temp;
+  dig = (int8_t*)(temp + 2*n*UED25519_TAB*4);
+
+  /* decode, tables, k_i, seed = SHA-512(sig_i || k_i ...) */
+  ok = 1;
+  muSHA512_init(&sha);
+  for (i = 0; ok && (i < n); i++) {
+    ok = mu_ed25519_sc_check(ctx, sig[i]+32) &&
+         mu_ed25519_frombytes(ctx, &P, pk[i], 0);
+    if (ok) {
+      mu_ed25519_odd_multiples(ctx, tab+(2*i)*UED25519_TAB, &P);
+      ok = mu_ed25519_frombytes(ctx, &P, sig[i], 0);
+    }
+    if (ok) {
+      mu_ed25519_odd_multiples(ctx, tab+(2*i+1)*UED25519_TAB, &P);
+      mu_ed25519_hram(ctx, (uint8_t*)dig+(2*i)*256, sig[i], pk[i], m[i], mlen[i]);
+      muSHA512_update(&sha, sig[i], 64);
+      muSHA512_update(&sha, (uint8_t*)dig+(2*i)*256, 32);
+    }
+  }
+  muSHA512_final(&sha, seed);
+
+  if (ok) {
+    /* z_i = SHA-512(seed || i) mod 2^128 */
+    for (j = 0; j < 32; j++) {
+      s[j]    = 0;
+      zero[j] = 0;
+    }
+    for (i = 0; i < n; i++) {
+      muSHA512_init(&sha);
+      muSHA512_update(&sha, seed, USHA512_DIGEST);
+      for (j = 0; j < 4; j++) {
+        z[j] = (uint8_t)(i >> (8*j));
+      }
+      muSHA512_update(&sha, z, 4);
+      muSHA512_final(&sha, h);
+      for (j = 0; j < 32; j++) {
+        z[j] = (j < 16) ? h[j] : 0;
+        k[j] = (uint8_t)dig[(2*i)*256+j];
+      }
+      mu_ed25519_sc_muladd(ctx, k, z, 16, k, zero);
+      mu_ed25519_sc_muladd(ctx, s, z, 16, sig[i]+32, s);
+      mu_ed25519_slide(dig+(2*i)*256, k, 15);
+      mu_ed25519_slide(dig+(2*i+1)*256, z, 15);
+    }
+    /* -sum z_i.S_i = (l-1).sum z_i.S_i */
+    mu_ed25519_sc_store(k, &ctx->l.m);
+    k[0] -= 1;
+    mu_ed25519_sc_muladd(ctx, s, k, 32, s, zero);
+    mu_ed25519_slide(dig+(2*n)*256, s, 7);
+
+    mu_ed25519_straus(ctx, &P, dig+(2*n)*256, tab, dig, 2*n);
+    ok = mu_ed25519_is_small(&P);
+  }
+
+  if (valid) {
+    if (ok) {
+      for (i = 0; i < n; i++) {
+        valid[i] = 1;
+      }
+    } else {
+      for (i = 0; i < n; i++) {
+        valid[i] = (uint8_t)mu_ed25519_verify(ctx, sig[i], m[i], mlen[i], pk[i]);
+      }
+    }
+  }
+  return ok;
+}
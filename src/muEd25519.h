@@ -0,0 +1,161 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef muEd25519_H
+#define muEd25519_H
+
+/*
+ * Ed25519 signatures (RFC 8032) over the mu25519 field.
+ *
+ * Points of -x² + y² = 1 + dx²y² are kept in extended twisted Edwards
+ * coordinates (X,Y,Z,T), x = X/Z, y = Y/Z, xy = T/Z. Scalars mod the
+ * group order l are muBN numbers reduced by a Barrett context.
+ *
+ * Signing and key generation use a fixed-base table held in the context
+ * and run in constant time. Verification is variable time and
+ * cofactored, [8][S]B = [8]R + [8][k]A, so that single and batch
+ * verification accept the same signatures.
+ */
+
+#include "muBN.h"
+#include "mu25519.h"
+#include "muSHA512.h"
+
+/* Word length of scalars mod l */
+#define UED25519_WLEN    ((256+UBN_BITS_PER_WORD-1)/UBN_BITS_PER_WORD)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Precomputed affine point (y+x, y-x, 2dxy)
+ */
+typedef struct {
+  mu25519_fe_t  ypx;
+  mu25519_fe_t  ymx;
+  mu25519_fe_t  t2d;
+} mu_ed25519_niels_t;
+
+/**
+ * Context: curve constants, order and fixed-base table, about 31KB with
+ * 64 bits words. Read only once initialized, it shall not be moved.
+ */
+typedef struct {
+  mu_ed25519_niels_t  base[32][8];   /* base[i][j] = (j+1).256^i.B      */
+  mu25519_fe_t        d;             /* -121665/121666                  */
+  mu25519_fe_t        d2;            /* 2d                              */
+  mu25519_fe_t        sqrtm1;        /* sqrt(-1)                        */
+  muBN_barrett_ctx_t  l;             /* group order                     */
+  muBN_uword_t        lbuf[2*UED25519_WLEN+1];
+} mu_ed25519_ctx_t;
+
+/* ======================================================================================= */
+/*                                      Context                                            */
+/* ======================================================================================= */
+
+/**
+ * Setup the context and compute its fixed-base table.
+ *
+ * @param [out] ctx
+ *
+ * @return 1 if the context is ready
+ * @return 0 else
+ */
+muBN_word_t mu_ed25519_ctx_init(mu_ed25519_ctx_t *ctx);
+
+/* ======================================================================================= */
+/*                                      Signature                                          */
+/* ======================================================================================= */
+
+/**
+ * pk = [a]B, a the clamped first half of SHA-512(sk)
+ *
+ * @param [in]  ctx
+ * @param [out] pk    32 bytes public key
+ * @param [in]  sk    32 bytes secret key
+ */
+void mu_ed25519_public_key(mu_ed25519_ctx_t *ctx, uint8_t *pk, const uint8_t *sk);
+
+/**
+ * sig = Ed25519 signature of m
+ *
+ * @param [in]  ctx
+ * @param [out] sig   64 bytes R || S
+ * @param [in]  m     message
+ * @param [in]  mlen  message byte length
+ * @param [in]  sk    32 bytes secret key
+ * @param [in]  pk    32 bytes public key of sk
+ */
+void mu_ed25519_sign(mu_ed25519_ctx_t *ctx, uint8_t *sig, const uint8_t *m, uint32_t mlen,
+                     const uint8_t *sk, const uint8_t *pk);
+
+/**
+ * Verify sig, variable time.
+ *
+ * @param [in]  ctx
+ * @param [in]  sig   64 bytes R || S
+ * @param [in]  m     message
+ * @param [in]  mlen  message byte length
+ * @param [in]  pk    32 bytes public key
+ *
+ * @return 1 if sig is valid
+ * @return 0 if sig is invalid, S >= l, or R or pk do not decode
+ */
+muBN_word_t mu_ed25519_verify(mu_ed25519_ctx_t *ctx, const uint8_t *sig, const uint8_t *m,
+                              uint32_t mlen, const uint8_t *pk);
+
+/**
+ * Temp length, in field elements, of mu_ed25519_verify_batch for n
+ * signatures.
+ */
+uint32_t mu_ed25519_batch_tmp(uint32_t n);
+
+/**
+ * Verify n signatures at once, variable time.
+ *
+ * With z_i 128 bits coefficients, the random linear combination
+ *
+ *   [8]([-sum z_i.S_i]B + sum [z_i](R_i) + sum [z_i.k_i](A_i)) = 0
+ *
+ * is checked with a single multi-scalar multiplication (Straus, shared
+ * doublings), about twice as fast as n verifications. The z_i are
+ * derived from SHA-512 of the whole batch, so that no signature can be
+ * chosen after them. If the combination does not hold, each signature
+ * is verified on its own to fill valid.
+ *
+ * @param [in]  ctx
+ * @param [out] valid  n results of mu_ed25519_verify, may be NULL
+ * @param [in]  sig    n signatures
+ * @param [in]  m      n messages
+ * @param [in]  mlen   n message byte lengths
+ * @param [in]  pk     n public keys
+ * @param [in]  n
+ * @param [in]  temp   mu_ed25519_batch_tmp(n) field elements
+ *
+ * @return 1 if all signatures are valid
+ * @return 0 else
+ */
+muBN_word_t mu_ed25519_verify_batch(mu_ed25519_ctx_t *ctx, uint8_t *valid,
+                                    const uint8_t **sig, const uint8_t **m,
+                                    const uint32_t *mlen, const uint8_t **pk, uint32_t n,
+                                    mu25519_fe_t *temp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
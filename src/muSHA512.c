@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "muSHA512.h"
+
+static const uint64_t muSHA512_K[80] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+  0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+  0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+  0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+  0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+  0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+  0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+  0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+  0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+  0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+  0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+  0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+  0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+  0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+  0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+  0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+  0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+  0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+  0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+  0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+  0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static const uint64_t muSHA512_H0[8] = {
+  0x6a09e667f3bcc908ULL,
+  0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL,
+  0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL,
+  0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL,
+  0x5be0cd19137e2179ULL,
+};
+
+#define USHA_ROR(x,n)  (((x)>>(n))|((x)<<(64-(n))))
+#define USHA_S0(x)     (USHA_ROR(x,28)^USHA_ROR(x,34)^USHA_ROR(x,39))
+#define USHA_S1(x)     (USHA_ROR(x,14)^USHA_ROR(x,18)^USHA_ROR(x,41))
+#define USHA_s0(x)     (USHA_ROR(x,1) ^USHA_ROR(x,8) ^((x)>>7))
+#define USHA_s1(x)     (USHA_ROR(x,19)^USHA_ROR(x,61)^((x)>>6))
+#define USHA_CH(x,y,z) (((x)&(y))^(~(x)&(z)))
+#define USHA_MAJ(x,y,z)(((x)&(y))^((x)&(z))^((y)&(z)))
+
+static uint64_t muSHA512_load(const uint8_t *p) {
+  uint64_t w;
+  int      i;
+
+  w = 0;
+  for (i = 0; i < 8; i++) {
+    w = (w<<8) | p[i];
+  }
+  return w;
+}
+
+static void muSHA512_store(uint8_t *p, uint64_t w) {
+  int i;
+
+  for (i = 7; i >= 0; i--) {
+    p[i] = (uint8_t)w;
+    w  >>= 8;
+  }
+}
+
+/* Message schedule on a 16 words ring */
+static void muSHA512_block(uint64_t *h, const uint8_t *block) {
+  uint64_t w[16];
+  uint64_t a, b, c, d, e, f, g, k, t1, t2;
+  int      i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = muSHA512_load(block+8*i);
+  }
+  a = h[0]; b = h[1]; c = h[2]; d = h[3];
+  e = h[4]; f = h[5]; g = h[6]; k = h[7];
+  for (i = 0; i < 80; i++) {
+    if (i >= 16) {
+      w[i&15] += USHA_s1(w[(i-2)&15]) + w[(i-7)&15] + USHA_s0(w[(i-15)&15]);
+    }
+    t1 = k + USHA_S1(e) + USHA_CH(e,f,g) + muSHA512_K[i] + w[i&15];
+    t2 = USHA_S0(a) + USHA_MAJ(a,b,c);
+    k = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+  h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+void muSHA512_init(muSHA512_t *ctx) {
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    ctx->h[i] = muSHA512_H0[i];
+  }
+  ctx->len  = 0;
+  ctx->blen = 0;
+}
+
+void muSHA512_update(muSHA512_t *ctx, const uint8_t *data, uint32_t len) {
+  uint32_t n;
+
+  ctx->len += len;
+  if (ctx->blen) {
+    n = USHA512_BLOCK - ctx->blen;
+    if (n > len) {
+      n = len;
+    }
+    for (len -= n; n; n--) {
+      ctx->block[ctx->blen++] = *data++;
+    }
+    if (ctx->blen < USHA512_BLOCK) {
+      return;
+    }
+    muSHA512_block(ctx->h, ctx->block);
+    ctx->blen = 0;
+  }
+  for (; len >= USHA512_BLOCK; len -= USHA512_BLOCK) {
+    muSHA512_block(ctx->h, data);
+    data += USHA512_BLOCK;
+  }
+  for (; len; len--) {
+    ctx->block[ctx->blen++] = *data++;
+  }
+}
+
+void muSHA512_final(muSHA512_t *ctx, uint8_t *digest) {
+  uint32_t i;
+
+  ctx->block[ctx->blen++] = 0x80;
+  if (ctx->blen > USHA512_BLOCK-16) {
+    while (ctx->blen < USHA512_BLOCK) {
+      ctx->block[ctx->blen++] = 0;
+    }
+    muSHA512_block(ctx->h, ctx->block);
+    ctx->blen = 0;
+  }
+  while (ctx->blen < USHA512_BLOCK-8) {
+    ctx->block[ctx->blen++] = 0;
+  }
+  /* 128 bits bit length, high part is 0 */
+  muSHA512_store(ctx->block+USHA512_BLOCK-8, ctx->len<<3);
+  ctx->block[USHA512_BLOCK-9] = (uint8_t)(ctx->len>>61);
+  muSHA512_block(ctx->h, ctx->block);
+
+  for (i = 0; i < 8; i++) {
+    muSHA512_store(digest+8*i, ctx->h[i]);
+  }
+  for (i = 0; i < USHA512_BLOCK; i++) {
+    ctx->block[i] = 0;
+  }
+  for (i = 0; i < 8; i++) {
+    ctx->h[i] = 0;
+  }
+  ctx->len  = 0;
+  ctx->blen = 0;
+}
+
+void muSHA512(uint8_t *digest, const uint8_t *data, uint32_t len) {
+  muSHA512_t ctx;
+
+  muSHA512_init(&ctx);
+  muSHA512_update(&ctx, data, len);
+  muSHA512_final(&ctx, digest);
+}
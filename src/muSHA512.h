@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef muSHA512_H
+#define muSHA512_H
+
+/*
+ * SHA-512, FIPS 180-4. Self contained, used by Ed25519.
+ */
+
+#include <stdint.h>
+
+#define USHA512_BLOCK   128
+#define USHA512_DIGEST  64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint64_t  h[8];                    /* chaining value                 */
+  uint64_t  len;                     /* hashed length in bytes         */
+  uint8_t   block[USHA512_BLOCK];    /* pending bytes                  */
+  uint32_t  blen;                    /* pending bytes length           */
+} muSHA512_t;
+
+/**
+ * Start a new hash.
+ *
+ * @param [out] ctx
+ */
+void muSHA512_init(muSHA512_t *ctx);
+
+/**
+ * Hash len more bytes.
+ *
+ * @param [in/out] ctx
+ * @param [in]     data
+ * @param [in]     len
+ */
+void muSHA512_update(muSHA512_t *ctx, const uint8_t *data, uint32_t len);
+
+/**
+ * Pad, output the digest and wipe the context.
+ *
+ * @param [in/out] ctx
+ * @param [out]    digest  USHA512_DIGEST bytes
+ */
+void muSHA512_final(muSHA512_t *ctx, uint8_t *digest);
+
+/**
+ * One shot digest = SHA-512(data)
+ */
+void muSHA512(uint8_t *digest, const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
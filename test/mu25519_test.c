@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * X25519 against the RFC 7748 known answers: the two vectors of section
+ * 5.2, the iterated function after 1 and 1000 rounds, and the key
+ * agreement of section 6.1. The limb count follows the word size, build
+ * it twice to cover both fields:
+ *
+ *   5 limbs of 51 bits, 64 bits words:
+ *   gcc -Isrc/linux -Isrc test/mu25519_test.c src/mu25519.c src/muBN.c -o mu25519_test
+ *
+ *   10 limbs of 26 and 25 bits, 32 bits words:
+ *   gcc -m32 -Isrc/linux -Isrc test/mu25519_test.c src/mu25519.c src/muBN.c -o mu25519_test
+ *
+ * Exit status 0 if all the results match.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "mu25519.h"
+
+static int fails;
+
+static void hex2bin(uint8_t *b, const char *h, uint32_t len) {
+  uint32_t i;
+  unsigned int v;
+
+  for (i = 0; i < len; i++) {
+    sscanf(h+2*i, "%2x", &v);
+    b[i] = (uint8_t)v;
+  }
+}
+
+static void check(const char *op, const uint8_t *got, const char *exp) {
+  uint8_t e[32];
+
+  hex2bin(e, exp, 32);
+  if (memcmp(got, e, 32) != 0) {
+    printf("FAIL %s, %d limbs\n", op, U25519_LIMBS);
+    fails++;
+  }
+}
+
+/* RFC 7748, 5.2 */
+static void test_vectors(void) {
+  static const char *vec[2][3] = {
+    {"a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+     "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+     "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552"},
+    {"4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d",
+     "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493",
+     "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957"}
+  };
+  uint8_t k[32], u[32], r[32];
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    hex2bin(k, vec[i][0], 32);
+    hex2bin(u, vec[i][1], 32);
+    mu_x25519(r, k, u);
+    check("x25519", r, vec[i][2]);
+  }
+}
+
+/* RFC 7748, 5.2: k, u = X25519(k, u), k, from k = u = 9 */
+static void test_iterated(void) {
+  uint8_t k[32], u[32], r[32];
+  int i;
+
+  memset(k, 0, 32);
+  k[0] = 9;
+  memcpy(u, k, 32);
+  for (i = 1; i <= 1000; i++) {
+    mu_x25519(r, k, u);
+    memcpy(u, k, 32);
+    memcpy(k, r, 32);
+    if (i == 1) {
+      check("iterated 1", k, "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079");
+    }
+  }
+  check("iterated 1000", k, "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51");
+}
+
+/* RFC 7748, 6.1 */
+static void test_agreement(void) {
+  uint8_t a[32], b[32], pa[32], pb[32], ka[32], kb[32];
+
+  hex2bin(a, "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a", 32);
+  hex2bin(b, "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb", 32);
+  mu_x25519_base(pa, a);
+  mu_x25519_base(pb, b);
+  check("public a", pa, "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a");
+  check("public b", pb, "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f");
+  mu_x25519(ka, a, pb);
+  mu_x25519(kb, b, pa);
+  check("shared a", ka, "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742");
+  check("shared b", kb, "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742");
+
+  //u = 0 is of small order
+  memset(pa, 0, 32);
+  if (mu_x25519(ka, a, pa)) {
+    printf("FAIL small order, %d limbs\n", U25519_LIMBS);
+    fails++;
+  }
+}
+
+int main(void) {
+  test_vectors();
+  test_iterated();
+  test_agreement();
+  if (fails) {
+    printf("%d failures\n", fails);
+    return 1;
+  }
+  printf("mu25519: all tests passed, %d limbs\n", U25519_LIMBS);
+  return 0;
+}
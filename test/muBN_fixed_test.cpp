@@ -0,0 +1,159 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * muBN_fixed<N> against the generic muBN API: add, sub, mul, mod_add,
+ * mod_sub, mgt_mul and mgt_sqr on random operands and edge values, for
+ * several word-lengths.
+ *
+ *   gcc -c -Isrc/linux -Isrc src/muBN.c
+ *   g++ -std=c++11 -Isrc/linux -Isrc test/muBN_fixed_test.cpp muBN.o -o muBN_fixed_test
+ *
+ * Exit status 0 if all the results match.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "muBN.h"
+#include "muBN_fixed.h"
+
+#define NB_TESTS  200
+
+static uint32_t rnd_state = 0x12345678;
+
+static muBN_uword_t rnd_word(void) {
+  muBN_uword_t w = 0;
+  for (size_t i = 0; i < sizeof(muBN_uword_t); i += 2) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    w = (muBN_uword_t)((w << 8) << 8) | (muBN_uword_t)(rnd_state & 0xFFFF);
+  }
+  return w;
+}
+
+static int fails;
+
+template<size_t N> static void check(const char *op, const muBN_uword_t *got,
+                                     const muBN_uword_t *exp, size_t len) {
+  if (memcmp(got, exp, len*sizeof(muBN_uword_t)) != 0) {
+    printf("FAIL %s, wlen %d\n", op, (int)N);
+    fails++;
+  }
+}
+
+/* a random below m, or m-1, or 0 */
+template<size_t N> static void below(muBN_fixed<N> &a, const muBN_fixed<N> &m, int kind) {
+  muBN_fixed<N> one;
+
+  for (size_t i = 0; i < N; i++) {
+    a.v[i]   = rnd_word();
+    one.v[i] = 0;
+  }
+  one.v[N-1] = 1;
+  if (kind == 1) {
+    muBN_fixed<N>::sub(a, m, one);
+  } else if (kind == 2) {
+    for (size_t i = 0; i < N; i++) {
+      a.v[i] = 0;
+    }
+  } else {
+    a.v[0] = m.v[0] ? a.v[0] % m.v[0] : 0;
+  }
+}
+
+template<size_t N> static void test(void) {
+  muBN_fixed<N>     m, a, b, r;
+  muBN_fixed<2*N>   p;
+  muBN_uword_t      e[2*N], cbuf[3*N], temp[3*N+1];
+  muBN_t            um, ua, ub, ue, ue2;
+  muBN_mgt_ctx_t    ctx;
+  muBN_uword_t      c;
+
+  for (int t = 0; t < NB_TESTS; t++) {
+    //odd modulus, full top word, or all ones
+    for (size_t i = 0; i < N; i++) {
+      m.v[i] = (t == 0) ? (muBN_uword_t)~(muBN_uword_t)0 : rnd_word();
+    }
+    m.v[0]   |= (muBN_uword_t)1 << (UBN_BITS_PER_WORD-1);
+    m.v[N-1] |= 1;
+    um = m.ubn();
+    if ((N == 1) && (m.v[0] == 1)) {
+      continue;
+    }
+    muBN_mgt_ctx_init(&ctx, &um, cbuf, temp);
+
+    below(a, m, t%7 == 1 ? 1 : t%11 == 2 ? 2 : 0);
+    below(b, m, t%5 == 1 ? 1 : 0);
+    ua = a.ubn();
+    ub = b.ubn();
+    muBN_init(&ue,  e, (muBN_size_t)N);
+    muBN_init(&ue2, e, (muBN_size_t)(2*N));
+
+    c = muBN_fixed<N>::add(r, a, b);
+    muBN_add(&ue, &ua, &ub);
+    check<N>("add", r.v, e, N);
+    if (c != ue.C) {
+      printf("FAIL add carry, wlen %d\n", (int)N);
+      fails++;
+    }
+
+    muBN_fixed<N>::sub(r, a, b);
+    muBN_sub(&ue, &ua, &ub);
+    check<N>("sub", r.v, e, N);
+
+    muBN_fixed<N>::mul(p, a, b);
+    muBN_mul(&ue2, &ua, &ub);
+    check<N>("mul", p.v, e, 2*N);
+
+    muBN_fixed<N>::mod_add(r, a, b, m);
+    muBN_mod_add(&ue, &ua, &ub, &um);
+    check<N>("mod_add", r.v, e, N);
+
+    muBN_fixed<N>::mod_sub(r, a, b, m);
+    muBN_mod_sub(&ue, &ua, &ub, &um);
+    check<N>("mod_sub", r.v, e, N);
+
+    muBN_fixed<N>::mgt_mul(r, a, b, m, ctx.j0);
+    muBN_mgt_mul(&ue, &ua, &ub, &um, ctx.j0);
+    check<N>("mgt_mul", r.v, e, N);
+
+    muBN_fixed<N>::mgt_sqr(r, a, m, ctx.j0);
+    muBN_mgt_sqr(&ue, &ua, &um, ctx.j0, temp);
+    check<N>("mgt_sqr", r.v, e, N);
+
+    //r may be a
+    r = a;
+    muBN_fixed<N>::mgt_mul(r, r, b, m, ctx.j0);
+    muBN_mgt_mul(&ue, &ua, &ub, &um, ctx.j0);
+    check<N>("mgt_mul r=a", r.v, e, N);
+  }
+}
+
+int main(void) {
+  test<1>();
+  test<2>();
+  test<3>();
+  test<4>();
+  test<5>();
+  test<6>();
+  test<8>();
+  test<12>();
+  test<16>();
+  test<33>();
+  printf("muBN_fixed: %s\n", fails ? "FAILED" : "ok");
+  return fails != 0;
+}
@@ -0,0 +1,411 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * muECDSA against the RFC 6979 known answers (A.2.5 P-256, A.2.6 P-384,
+ * with their fixed k), with and without the generator and public key
+ * tables; rejection of tampered r, s and hash, of r = 0, s = 0, r >= n and
+ * s >= n; an ECDH known answer (NIST CAVS, P-256) and off-curve peer keys.
+ * Then muEC_comb_mul and muEC_msm (Straus and Pippenger) are checked
+ * against muEC_mul on the three curves.
+ *
+ *   gcc -Isrc/linux -Isrc test/muECDSA_test.c src/muECDSA.c src/muEC.c src/muBN.c \
+ *       -o muECDSA_test
+ *
+ * Exit status 0 if all the results match.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "muECDSA.h"
+
+#define TMP_WLEN    (1<<17)
+#define TAB_WLEN    (1<<17)
+#define MSM_N       70
+
+static int fails;
+
+static muEC_ctx_t     ec;
+static muECDSA_ctx_t  ds, dsg;
+static muEC_comb_t    G;
+static muBN_uword_t   ecbuf[UEC_MAX_WLEN*10+1], dsbuf[UEC_MAX_WLEN*3], dsgbuf[UEC_MAX_WLEN*3];
+static muBN_uword_t   gtab[TAB_WLEN], ktab[TAB_WLEN], temp[TMP_WLEN];
+
+static void fail(const char *op) {
+  printf("FAIL %s, curve %d, %d bits words\n", op, ec.curve, (int)UBN_BITS_PER_WORD);
+  fails++;
+}
+
+static int hexval(char c) {
+  return (c <= '9') ? c-'0' : (c|0x20)-'a'+10;
+}
+
+/* r = hex, big endian, r on the curve word-length */
+static void hex2bn(muBN_t *r, const char *hex) {
+  int n, i, bit;
+
+  muBN_zero(r);
+  n = (int)strlen(hex);
+  for (i = 0; i < n; i++) {
+    bit = 4*(n-1-i);
+    r->v[r->wlen-1-bit/UBN_BITS_PER_WORD] |= ((muBN_uword_t)hexval(hex[i])) << (bit%UBN_BITS_PER_WORD);
+  }
+}
+
+static uint32_t hex2bin(uint8_t *b, const char *hex) {
+  uint32_t i, n;
+
+  n = (uint32_t)strlen(hex)/2;
+  for (i = 0; i < n; i++) {
+    b[i] = (uint8_t)(hexval(hex[2*i])*16 + hexval(hex[2*i+1]));
+  }
+  return n;
+}
+
+static void check_bn(const char *op, muBN_t *got, const char *exp) {
+  muBN_uword_t  eb[UEC_MAX_WLEN];
+  muBN_t        e;
+
+  muBN_init(&e, eb, got->wlen);
+  hex2bn(&e, exp);
+  if (muBN_ucmp(got, &e) != 0) {
+    fail(op);
+  }
+}
+
+static void check_word(const char *op, muBN_word_t got, muBN_word_t exp) {
+  if (got != exp) {
+    fail(op);
+  }
+}
+
+/* curve context, generator tables with spacing 2, ECDSA contexts without and with them */
+static int setup(uint8_t curve) {
+  muEC_point_t  P;
+  muBN_uword_t  pb[UEC_MAX_WLEN*3];
+
+  if (!muEC_ctx_init(&ec, curve, ecbuf, temp)) {
+    fail("ec ctx init");
+    return 0;
+  }
+  if (((uint32_t)ec.tmp_mul > TMP_WLEN) || (muEC_comb_wlen(&ec, 1) > TAB_WLEN)) {
+    fail("test buffers");
+    return 0;
+  }
+  muEC_point_init(&ec, &P, pb);
+  muEC_set_generator(&ec, &P);
+  if (!muEC_comb_init(&ec, &G, &P, 2, gtab, temp) ||
+      !muECDSA_ctx_init(&ds, &ec, NULL, dsbuf, temp) ||
+      !muECDSA_ctx_init(&dsg, &ec, &G, dsgbuf, temp)) {
+    fail("ctx init");
+    return 0;
+  }
+  if ((ds.tmp_sign > TMP_WLEN) || (ds.tmp_verify > TMP_WLEN) || (ds.tmp_ecdh > TMP_WLEN) ||
+      (dsg.tmp_verify > TMP_WLEN)) {
+    fail("test buffers");
+    return 0;
+  }
+  return 1;
+}
+
+/* ======================================================================================= */
+/*                                      ECDSA                                              */
+/* ======================================================================================= */
+
+/* RFC 6979: curve, x, Ux, Uy, k, hash of the message, r, s */
+typedef struct {
+  uint8_t     curve;
+  const char  *x, *ux, *uy, *k, *h, *r, *s;
+} rfc6979_t;
+
+static const rfc6979_t rfc6979[] = {
+  //P-256, SHA-256, "sample"
+  {UEC_P256,
+   "c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721",
+   "60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+   "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299",
+   "a6e3c57dd01abe90086538398355dd4c3b17aa873382b0f24d6129493d8aad60",
+   "af2bdbe1aa9b6ec1e2ade1d694f41fc71a831d0268e9891562113d8a62add1bf",
+   "efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716",
+   "f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8"},
+  //P-256, SHA-256, "test"
+  {UEC_P256,
+   "c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721",
+   "60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+   "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299",
+   "d16b6ae827f17175e040871a1c7ec3500192c4c92677336ec2537acaee0008e0",
+   "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08",
+   "f1abb023518351cd71d881567b1ea663ed3efcf6c5132b354f28d3b0b7d38367",
+   "019f4113742a2b14bd25926b49c649155f267e60d3814b4c0cc84250e46f0083"},
+  //P-256, SHA-512, "sample": the hash is cut to its 256 leftmost bits
+  {UEC_P256,
+   "c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721",
+   "60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+   "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299",
+   "5fa81c63109badb88c1f367b47da606da28cad69aa22c4fe6ad7df73a7173aa5",
+   "39a5e04aaff7455d9850c605364f514c11324ce64016960d23d5dc57d3ffd8f4"
+   "9a739468ab8049bf18eef820cdb1ad6c9015f838556bc7fad4138b23fdf986c7",
+   "8496a60b5e9b47c825488827e0495b0e3fa109ec4568fd3f8d1097678eb97f00",
+   "2362ab1adbe2b8adf9cb9edab740ea6049c028114f2460f96554f61fae3302fe"},
+  //P-384, SHA-384, "sample"
+  {UEC_P384,
+   "6b9d3dad2e1b8c1c05b19875b6659f4de23c3b667bf297ba9aa47740787137d8"
+   "96d5724e4c70a825f872c9ea60d2edf5",
+   "ec3a4e415b4e19a4568618029f427fa5da9a8bc4ae92e02e06aae5286b300c64"
+   "def8f0ea9055866064a254515480bc13",
+   "8015d9b72d7d57244ea8ef9ac0c621896708a59367f9dfb9f54ca84b3f1c9db1"
+   "288b231c3ae0d4fe7344fd2533264720",
+   "94ed910d1a099dad3254e9242ae85abde4ba15168eaf0ca87a555fd56d10fbca"
+   "2907e3e83ba95368623b8c4686915cf9",
+   "9a9083505bc92276aec4be312696ef7bf3bf603f4bbd381196a029f340585312"
+   "313bca4a9b5b890efee42c77b1ee25fe",
+   "94edbb92a5ecb8aad4736e56c691916b3f88140666ce9fa73d64c4ea95ad133c"
+   "81a648152e44acf96e36dd1e80fabe46",
+   "99ef4aeb15f178cea1fe40db2603138f130e740a19624526203b6351d0a3a94f"
+   "a329c145786e679e7b82c71a38628ac8"}
+};
+
+/* verify with both contexts and both keys, all shall give exp */
+static void verify_all(const char *op, muECDSA_key_t *k0, muECDSA_key_t *k1, muBN_t *r,
+                       muBN_t *s, const uint8_t *h, uint32_t hlen, muBN_word_t exp) {
+  check_word(op, muECDSA_verify(&ds,  k0, r, s, h, hlen, temp), exp);
+  check_word(op, muECDSA_verify(&ds,  k1, r, s, h, hlen, temp), exp);
+  check_word(op, muECDSA_verify(&dsg, k0, r, s, h, hlen, temp), exp);
+  check_word(op, muECDSA_verify(&dsg, k1, r, s, h, hlen, temp), exp);
+}
+
+static void test_rfc6979(const rfc6979_t *v) {
+  muBN_uword_t   b[8][UEC_MAX_WLEN];
+  muBN_t         x, k, bl, qx, qy, r, s, t;
+  muECDSA_key_t  k0, k1;
+  uint8_t        h[64];
+  uint32_t       hlen;
+
+  muBN_init(&x,  b[0], ec.wlen);
+  muBN_init(&k,  b[1], ec.wlen);
+  muBN_init(&bl, b[2], ec.wlen);
+  muBN_init(&qx, b[3], ec.wlen);
+  muBN_init(&qy, b[4], ec.wlen);
+  muBN_init(&r,  b[5], ec.wlen);
+  muBN_init(&s,  b[6], ec.wlen);
+  muBN_init(&t,  b[7], ec.wlen);
+  hex2bn(&x, v->x);
+  hex2bn(&k, v->k);
+  hex2bn(&bl, "0123456789abcdef0123456789abcdef");
+  hlen = hex2bin(h, v->h);
+
+  //public key and signature, without then with the generator tables
+  check_word("public key", muECDSA_public_key(&ds, &qx, &qy, &x, temp), 1);
+  check_bn("public key x", &qx, v->ux);
+  check_bn("public key y", &qy, v->uy);
+  check_word("sign", muECDSA_sign(&ds, &r, &s, h, hlen, &x, &k, &bl, temp), 1);
+  check_bn("sign r", &r, v->r);
+  check_bn("sign s", &s, v->s);
+  muBN_zero(&r);
+  muBN_zero(&s);
+  check_word("public key tables", muECDSA_public_key(&dsg, &qx, &qy, &x, temp), 1);
+  check_bn("public key tables x", &qx, v->ux);
+  check_word("sign tables", muECDSA_sign(&dsg, &r, &s, h, hlen, &x, &k, &bl, temp), 1);
+  check_bn("sign tables r", &r, v->r);
+  check_bn("sign tables s", &s, v->s);
+
+  //keys without and with tables
+  if ((muECDSA_key_wlen(&ds, 1) > TAB_WLEN) ||
+      !muECDSA_key_init(&ds, &k0, &qx, &qy, 0, ktab, temp) ||
+      !muECDSA_key_init(&ds, &k1, &qx, &qy, 1, ktab+muECDSA_key_wlen(&ds, 0), temp)) {
+    fail("key init");
+    return;
+  }
+  verify_all("verify", &k0, &k1, &r, &s, h, hlen, 1);
+
+  //tampered r, s, hash
+  r.v[ec.wlen-1] ^= 1;
+  verify_all("verify tampered r", &k0, &k1, &r, &s, h, hlen, 0);
+  r.v[ec.wlen-1] ^= 1;
+  s.v[ec.wlen-1] ^= 1;
+  verify_all("verify tampered s", &k0, &k1, &r, &s, h, hlen, 0);
+  s.v[ec.wlen-1] ^= 1;
+  //in the leftmost bits, the only ones used when the hash is longer than n
+  h[0] ^= 1;
+  verify_all("verify tampered hash", &k0, &k1, &r, &s, h, hlen, 0);
+  h[0] ^= 1;
+
+  //r = 0, s = 0, r = n, s = n, s = n+s
+  muBN_zero(&t);
+  verify_all("verify r = 0", &k0, &k1, &t, &s, h, hlen, 0);
+  verify_all("verify s = 0", &k0, &k1, &r, &t, h, hlen, 0);
+  muBN_copy(&t, &ec.n);
+  verify_all("verify r = n", &k0, &k1, &t, &s, h, hlen, 0);
+  verify_all("verify s = n", &k0, &k1, &r, &t, h, hlen, 0);
+  if (!muBN_add(&t, &s, &ec.n)) {
+    verify_all("verify s + n", &k0, &k1, &r, &t, h, hlen, 0);
+  }
+  verify_all("verify restored", &k0, &k1, &r, &s, h, hlen, 1);
+
+  //off-curve key
+  qy.v[ec.wlen-1] ^= 1;
+  check_word("key init off-curve", muECDSA_key_init(&ds, &k0, &qx, &qy, 0, ktab, temp), 0);
+}
+
+/* ======================================================================================= */
+/*                                       ECDH                                              */
+/* ======================================================================================= */
+
+/* NIST CAVS 14.1, ECC CDH primitive, P-256, count 0 */
+static void test_ecdh(void) {
+  muBN_uword_t  b[4][UEC_MAX_WLEN];
+  muBN_t        d, qx, qy, z;
+
+  muBN_init(&d,  b[0], ec.wlen);
+  muBN_init(&qx, b[1], ec.wlen);
+  muBN_init(&qy, b[2], ec.wlen);
+  muBN_init(&z,  b[3], ec.wlen);
+  hex2bn(&d,  "7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+  hex2bn(&qx, "700c48f77f56584c5cc632ca65640db91b6bacce3a4df6b42ce7cc838833d287");
+  hex2bn(&qy, "db71e509e3fd9b060ddb20ba5c51dcc5948d46fbf640dfe0441782cab85fa4ac");
+  check_word("ecdh", muECDH(&ds, &z, &d, &qx, &qy, temp), 1);
+  check_bn("ecdh z", &z, "46fc62106420ff012e54a434fbdd2d25ccc5852060561e68040dd7778997bd7b");
+
+  qy.v[ec.wlen-1] ^= 1;
+  check_word("ecdh off-curve", muECDH(&ds, &z, &d, &qx, &qy, temp), 0);
+  check_bn("ecdh off-curve z", &z, "0");
+  qy.v[ec.wlen-1] ^= 1;
+  muBN_copy(&qy, &ec.fp.m);
+  check_word("ecdh y = p", muECDH(&ds, &z, &d, &qx, &qy, temp), 0);
+}
+
+/* ======================================================================================= */
+/*                                  Multiplications                                        */
+/* ======================================================================================= */
+
+static uint32_t rnd_state = 0x12345678;
+
+/* k random below 2^(nbits-1), so below n */
+static void rnd_scalar(muBN_t *k) {
+  muBN_size_t i, j;
+
+  for (i = 0; i < k->wlen; i++) {
+    k->v[i] = 0;
+    for (j = 0; j < (muBN_size_t)UBN_BITS_PER_WORD; j += 16) {
+      rnd_state ^= rnd_state << 13;
+      rnd_state ^= rnd_state >> 17;
+      rnd_state ^= rnd_state << 5;
+      k->v[i] = (muBN_uword_t)((k->v[i] << 8) << 8) | (muBN_uword_t)(rnd_state & 0xFFFF);
+    }
+  }
+  muBN_rshift(k, k->wlen*(muBN_size_t)UBN_BITS_PER_WORD - ec.nbits + 1);
+}
+
+static void check_pt(const char *op, muEC_point_t *P, muEC_point_t *Q) {
+  muBN_uword_t  b[4][UEC_MAX_WLEN];
+  muBN_t        px, py, qx, qy;
+
+  muBN_init(&px, b[0], ec.wlen);
+  muBN_init(&py, b[1], ec.wlen);
+  muBN_init(&qx, b[2], ec.wlen);
+  muBN_init(&qy, b[3], ec.wlen);
+  muEC_get_affine(&ec, &px, &py, P, temp);
+  muEC_get_affine(&ec, &qx, &qy, Q, temp);
+  if ((muBN_ucmp(&px, &qx) != 0) || (muBN_ucmp(&py, &qy) != 0)) {
+    fail(op);
+  }
+}
+
+static muBN_uword_t  pts[MSM_N][UEC_MAX_WLEN*3], ks[MSM_N][UEC_MAX_WLEN];
+
+/* comb_mul over G and over another point, msm of 3 points and of MSM_N, against mul */
+static void test_mul(void) {
+  muBN_uword_t  rb[3][UEC_MAX_WLEN*3];
+  muEC_point_t  P[MSM_N], R, S, T;
+  muBN_t        k[MSM_N];
+  muEC_comb_t   C;
+  muBN_size_t   i, sp;
+
+  for (i = 0; i < MSM_N; i++) {
+    muEC_point_init(&ec, &P[i], pts[i]);
+    muBN_init(&k[i], ks[i], ec.wlen);
+    rnd_scalar(&k[i]);
+  }
+  muEC_point_init(&ec, &R, rb[0]);
+  muEC_point_init(&ec, &S, rb[1]);
+  muEC_point_init(&ec, &T, rb[2]);
+
+  //P[i] = k[i].G, k[i] renewed
+  muEC_set_generator(&ec, &P[0]);
+  for (i = 1; i < MSM_N; i++) {
+    muEC_mul(&ec, &P[i], &k[i], &P[0], temp);
+    rnd_scalar(&k[i]);
+  }
+
+  //comb over G and over P[1]
+  muEC_mul(&ec, &R, &k[0], &P[0], temp);
+  muEC_comb_mul(&ec, &G, &S, &k[0], temp);
+  check_pt("comb G", &R, &S);
+  muEC_mul(&ec, &R, &k[0], &P[1], temp);
+  for (sp = 1; sp <= 4; sp += 3) {
+    muEC_comb_init(&ec, &C, &P[1], sp, ktab, temp);
+    muEC_comb_mul(&ec, &C, &S, &k[0], temp);
+    check_pt("comb P", &R, &S);
+    muEC_comb_clear(&ec, &C);
+  }
+
+  //msm, Straus then Pippenger
+  if (muEC_msm_tmp(&ec, MSM_N) > TMP_WLEN) {
+    fail("test buffers");
+    return;
+  }
+  muEC_set_infinity(&ec, &R);
+  for (i = 0; i < MSM_N; i++) {
+    muEC_mul(&ec, &T, &k[i], &P[i], temp);
+    muEC_add(&ec, &R, &R, &T, temp);
+    if (i == 2) {
+      muEC_msm(&ec, &S, k, P, 3, temp);
+      check_pt("msm 3", &R, &S);
+    }
+  }
+  muEC_msm(&ec, &S, k, P, MSM_N, temp);
+  check_pt("msm", &R, &S);
+}
+
+int main(void) {
+  uint32_t i;
+  uint8_t  curve;
+
+  for (curve = UEC_P256; curve <= UEC_SECP256K1; curve++) {
+    if (!setup(curve)) {
+      continue;
+    }
+    for (i = 0; i < sizeof(rfc6979)/sizeof(rfc6979[0]); i++) {
+      if (rfc6979[i].curve == curve) {
+        test_rfc6979(&rfc6979[i]);
+      }
+    }
+    if (curve == UEC_P256) {
+      test_ecdh();
+    }
+    test_mul();
+    muECDSA_ctx_clear(&ds);
+    muECDSA_ctx_clear(&dsg);
+    muEC_comb_clear(&ec, &G);
+    muEC_ctx_clear(&ec);
+  }
+  if (fails) {
+    printf("%d failures\n", fails);
+    return 1;
+  }
+  printf("muECDSA: all tests passed\n");
+  return 0;
+}
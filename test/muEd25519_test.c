@@ -0,0 +1,185 @@
+/*
+ *  Copyright 2015-2016, Ubinity SAS, cedric.mesnil@ubinity.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * muSHA512 against the FIPS 180-4 examples, Ed25519 against the RFC 8032
+ * known answers (7.1, tests 1 to 3), and batch verification with one
+ * tampered signature, which shall fail the batch and only its own valid
+ * entry. Build it for both fields, as test/mu25519_test.c:
+ *
+ *   gcc -Isrc/linux -Isrc test/muEd25519_test.c src/muEd25519.c src/mu25519.c \
+ *       src/muSHA512.c src/muBN.c -o muEd25519_test
+ *
+ * Exit status 0 if all the results match.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "muSHA512.h"
+#include "muEd25519.h"
+
+#define NB_SIG  3
+
+static int fails;
+
+static void hex2bin(uint8_t *b, const char *h, uint32_t len) {
+  uint32_t i;
+  unsigned int v;
+
+  for (i = 0; i < len; i++) {
+    sscanf(h+2*i, "%2x", &v);
+    b[i] = (uint8_t)v;
+  }
+}
+
+static void check(const char *op, const uint8_t *got, const char *exp, uint32_t len) {
+  uint8_t e[64];
+
+  hex2bin(e, exp, len);
+  if (memcmp(got, e, len) != 0) {
+    printf("FAIL %s, %d limbs\n", op, U25519_LIMBS);
+    fails++;
+  }
+}
+
+static void check_word(const char *op, muBN_word_t got, muBN_word_t exp) {
+  if (got != exp) {
+    printf("FAIL %s, %d limbs\n", op, U25519_LIMBS);
+    fails++;
+  }
+}
+
+/* FIPS 180-4 examples: one block, empty, two blocks, and a million of 'a' by updates */
+static void test_sha512(void) {
+  static const char *abc2 = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+                            "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+  muSHA512_t  ctx;
+  uint8_t     a[1000], digest[USHA512_DIGEST];
+  int         i;
+
+  muSHA512(digest, (const uint8_t*)"abc", 3);
+  check("sha512 abc", digest,
+        "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+        "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f", USHA512_DIGEST);
+  muSHA512(digest, (const uint8_t*)"", 0);
+  check("sha512 empty", digest,
+        "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+        "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e", USHA512_DIGEST);
+  muSHA512(digest, (const uint8_t*)abc2, (uint32_t)strlen(abc2));
+  check("sha512 two blocks", digest,
+        "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+        "501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909", USHA512_DIGEST);
+  memset(a, 'a', sizeof(a));
+  muSHA512_init(&ctx);
+  for (i = 0; i < 1000; i++) {
+    muSHA512_update(&ctx, a, sizeof(a));
+  }
+  muSHA512_final(&ctx, digest);
+  check("sha512 million", digest,
+        "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+        "de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b", USHA512_DIGEST);
+}
+
+/* RFC 8032, 7.1: secret key, public key, message, signature */
+static const char *rfc8032[NB_SIG][4] = {
+  {"9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60",
+   "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+   "",
+   "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e06522490155"
+   "5fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b"},
+  {"4ccd089b28ff96da9db6c346ec114e0f5b8a319f35aba624da8cf6ed4fb8a6fb",
+   "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c",
+   "72",
+   "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+   "085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00"},
+  {"c5aa8df43f9f837bedb7442f31dcb7b166d38535076f094b85ce3a2e0b4458f7",
+   "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025",
+   "af82",
+   "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac"
+   "18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a"}
+};
+
+static mu_ed25519_ctx_t  ed;
+static uint8_t           sk[NB_SIG][32], pk[NB_SIG][32], msg[NB_SIG][2], sig[NB_SIG][64];
+static uint32_t          mlen[NB_SIG];
+
+static void test_rfc8032(void) {
+  uint8_t  p[32], s[64];
+  int      i;
+
+  for (i = 0; i < NB_SIG; i++) {
+    mlen[i] = (uint32_t)strlen(rfc8032[i][2])/2;
+    hex2bin(sk[i],  rfc8032[i][0], 32);
+    hex2bin(msg[i], rfc8032[i][2], mlen[i]);
+    mu_ed25519_public_key(&ed, p, sk[i]);
+    check("public key", p, rfc8032[i][1], 32);
+    memcpy(pk[i], p, 32);
+    mu_ed25519_sign(&ed, s, msg[i], mlen[i], sk[i], pk[i]);
+    check("sign", s, rfc8032[i][3], 64);
+    memcpy(sig[i], s, 64);
+    check_word("verify", mu_ed25519_verify(&ed, sig[i], msg[i], mlen[i], pk[i]), 1);
+  }
+}
+
+/* The three RFC signatures, then the same batch with S of the second one changed */
+static void test_batch(void) {
+  static mu25519_fe_t  temp[1024];
+  const uint8_t        *s[NB_SIG], *m[NB_SIG], *p[NB_SIG];
+  uint8_t              bad[64], valid[NB_SIG];
+  int                  i;
+
+  if (mu_ed25519_batch_tmp(NB_SIG) > sizeof(temp)/sizeof(temp[0])) {
+    printf("FAIL batch temp, %d limbs\n", U25519_LIMBS);
+    fails++;
+    return;
+  }
+  for (i = 0; i < NB_SIG; i++) {
+    s[i] = sig[i];
+    m[i] = msg[i];
+    p[i] = pk[i];
+  }
+  memset(valid, 0xAA, sizeof(valid));
+  check_word("batch", mu_ed25519_verify_batch(&ed, valid, s, m, mlen, p, NB_SIG, temp), 1);
+  for (i = 0; i < NB_SIG; i++) {
+    check_word("batch valid", valid[i], 1);
+  }
+
+  memcpy(bad, sig[1], 64);
+  bad[32] ^= 1;
+  s[1] = bad;
+  check_word("verify tampered", mu_ed25519_verify(&ed, bad, msg[1], mlen[1], pk[1]), 0);
+  memset(valid, 0xAA, sizeof(valid));
+  check_word("batch tampered", mu_ed25519_verify_batch(&ed, valid, s, m, mlen, p, NB_SIG, temp), 0);
+  check_word("batch tampered valid 0", valid[0], 1);
+  check_word("batch tampered valid 1", valid[1], 0);
+  check_word("batch tampered valid 2", valid[2], 1);
+}
+
+int main(void) {
+  test_sha512();
+  if (!mu_ed25519_ctx_init(&ed)) {
+    printf("FAIL ctx init, %d limbs\n", U25519_LIMBS);
+    return 1;
+  }
+  test_rfc8032();
+  test_batch();
+  if (fails) {
+    printf("%d failures\n", fails);
+    return 1;
+  }
+  printf("muEd25519: all tests passed, %d limbs\n", U25519_LIMBS);
+  return 0;
+}